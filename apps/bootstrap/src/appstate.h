@@ -7,6 +7,7 @@ namespace AppState
 
 enum
 {
+    Loading,
     Splash,
     Frontend,
     InGame,
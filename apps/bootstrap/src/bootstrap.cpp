@@ -3,6 +3,7 @@
 #include "appstate.h"
 #include "gameplaystate.h"
 #include "iappstate.h"
+#include "loading.h"
 #include "sfx.h"
 #include "splash.h"
 #include "version.h"
@@ -14,6 +15,8 @@
 
 #include "tilemap.h"
 
+GLI_MEMORY_HOOK()
+
 namespace Bootstrap
 {
 
@@ -25,7 +28,14 @@ bool App::on_create()
         return false;
     }
 
+    // The scroller redraws every tile each frame, so let the draws spread over all cores
+    set_deferred_drawing(true);
+
+    // The tiles, tilesheet and minimap for one map
+    gli::set_memory_budget("tilemap", 4 * 1024 * 1024);
+
     _states.reserve(AppState::Count);
+    _states.insert(std::pair<AppState::Type, AppStatePtr>(AppState::Loading, std::make_unique<LoadingState>()));
     _states.insert(std::pair<AppState::Type, AppStatePtr>(AppState::Splash, std::make_unique<SplashState>()));
     //_states.insert(std::pair<AppState::Type, AppStatePtr>(AppState::Frontend, std::make_unique<TitleScreenState>()));
     _states.insert(std::pair<AppState::Type, AppStatePtr>(AppState::InGame, std::make_unique<GamePlayState>()));
@@ -41,27 +51,49 @@ bool App::on_create()
         }
     }
 
+    // Everything loads in parallel behind the loading screen
+    queue_sfx(_assets);
+    _assets.start();
+
     _state = AppState::Count;
-    _next_state = AppState::Splash;
+    _next_state = AppState::Loading;
     _active_state = nullptr;
 
-    if (!load_sfx())
+    if (!_audio_engine.start())
     {
-        gliLog(gli::LogLevel::Error, "Bootstrap", "App::on_create", "Failed to load SFX.");
+        gliLog(gli::LogLevel::Error, "Bootstrap", "App::on_create", "Failed to start audio engine.");
         return false;
     }
 
-    if (!_audio_engine.start())
+    return true;
+}
+
+bool App::on_assets_loaded()
+{
+    _assets.report();
+
+    if (_assets.failed())
     {
-        gliLog(gli::LogLevel::Error, "Bootstrap", "App::on_create", "Failed to start audio engine.");
+        gliLog(gli::LogLevel::Error, "Bootstrap", "App::on_assets_loaded", "Failed to load assets.");
         return false;
     }
 
+    for (const auto& kvp : _states)
+    {
+        if (kvp.second && !kvp.second->on_loaded())
+        {
+            return false;
+        }
+    }
+
     return true;
 }
 
 void App::on_destroy()
 {
+    // Quitting during the loading screen leaves loads running that write into the gamestates
+    _assets.wait();
+
     if (_active_state)
     {
         _active_state->on_exit();
@@ -80,8 +112,11 @@ void App::on_destroy()
     _audio_engine.stop();
 }
 
-bool App::on_update(float delta)
+// State changes happen here so a state entering shows its layers on its first frame
+bool App::on_pre_update(float delta)
 {
+    _state_entered = false;
+
     if (_next_state != AppState::Count)
     {
         if (_active_state)
@@ -107,11 +142,29 @@ bool App::on_update(float delta)
         }
 
         _next_state = AppState::Count;
+        _state_entered = true;
+    }
+
+    if (_active_state)
+    {
+        _active_state->on_pre_update(_state_entered ? 0.0f : delta);
+    }
+
+    return true;
+}
+
+
+bool App::on_update(float delta)
+{
+    if (_state_entered)
+    {
         delta = 0.0f;
     }
 
     if (_active_state)
     {
+        GLI_PROFILE_SCOPE("Bootstrap::state_update");
+
         if (!_active_state->on_update(delta))
         {
             _active_state->on_exit();
@@ -121,6 +174,11 @@ bool App::on_update(float delta)
 
     _audio_engine.update();
 
+    if (key_state(gli::Key_F6).pressed)
+    {
+        gli::memory_report();
+    }
+
     return !!_active_state;
 }
 
@@ -170,7 +228,8 @@ void App::draw_text_box(int x, int y, int w, int h, const std::string& text, con
     for (int i = 0; i < max_lines && pos < text.size() && len != std::string::npos; ++i)
     {
         wrap_text(text, line_width_chars, pos, len);
-        draw_string(x, y, text.substr(pos, len).c_str(), vga9_glyphs, vga9_glyph_width, vga9_glyph_height, fg, bg);
+        gli::FrameString line(text.data() + pos, std::min(len, text.size() - pos), frame_arena());
+        draw_string(x, y, line.c_str(), vga9_glyphs, vga9_glyph_width, vga9_glyph_height, fg, bg);
         pos += len;
         y += vga9_glyph_height;
     }
@@ -206,7 +265,7 @@ int gli_main(int argc, char** argv)
     std::string title(size, '\0');
     std::snprintf(&title[0], size, "Bootstrap (%s %s)", GLI_PLATFORM, APP_VERSION);
 
-    if (app.initialize(title.c_str(), 640, 360, 2))
+    if (app.initialize(title.c_str(), 640, 360, 2) && app.input_log_from_args(argc, argv))
     {
         app.run();
     }
@@ -16,9 +16,14 @@ public:
 
     bool on_create() override;
     void on_destroy() override;
+    bool on_pre_update(float delta) override;
     bool on_update(float delta) override;
     void set_next_state(AppState::Type next_state);
 
+    // Gamestates queue their loads here in on_init, the loading state runs them and then calls on_assets_loaded
+    gli::AssetLoader& assets() { return _assets; }
+    bool on_assets_loaded();
+
     void draw_text_box(int x, int y, int w, int h, const std::string& text, const gli::Pixel& fg, const gli::Pixel& bg);
 
     void play_sound(int sfx_id);
@@ -29,7 +34,9 @@ private:
     IAppState* _active_state;
     AppState::Type _state;
     AppState::Type _next_state;
+    bool _state_entered = false; // This frame, its first update gets a delta of 0
     gli::AudioEngine _audio_engine;
+    gli::AssetLoader _assets;
 
     void wrap_text(const std::string& text, int w, size_t& off, size_t& len);
 };
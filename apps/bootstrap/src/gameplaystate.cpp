@@ -98,90 +98,96 @@ std::vector<std::string> load_puzzle_list(const std::string& path)
 }
 
 
+// Everything the game draws goes on one atlas page, in handle order: the sprite sheets, then the NMI effects
+static const char* atlas_image_paths[] = {
+    GliAssetPath("sprites/droid.png"), GliAssetPath("sprites/illegal_opcode.png"), GliAssetPath("fx/bullet.png"),
+    GliAssetPath("gui/map_markers.png"), GliAssetPath("gui/hud.png"), GliAssetPath("gui/game_over.png"),
+    GliAssetPath("gui/title.png"), GliAssetPath("gui/victory.png"), GliAssetPath("fx/nmi_dark.png"),
+    GliAssetPath("fx/nmi_shock.png")
+};
+
+
 bool GamePlayState::on_init(App* app)
 {
     _app = app;
 
-    static const char* sprite_sheet_paths[Sprite::Count] = { GliAssetPath("sprites/droid.png"), GliAssetPath("sprites/illegal_opcode.png"),
-                                                             GliAssetPath("fx/bullet.png"),     GliAssetPath("gui/map_markers.png"),
-                                                             GliAssetPath("gui/hud.png"),       GliAssetPath("gui/game_over.png"),
-                                                             GliAssetPath("gui/title.png"),     GliAssetPath("gui/victory.png") };
-
-    size_t i = 0;
+    static_assert(sizeof(atlas_image_paths) / sizeof(atlas_image_paths[0]) == Sprite::Count + 2, "One path per atlas image");
 
-    for (gli::Sprite& sprite : _sprites)
+    for (int i = 0; i < Sprite::Count + 2; ++i)
     {
-        if (!sprite.load(sprite_sheet_paths[i]))
-        {
-            return false;
-        }
-
-        i++;
+        _app->assets().add(atlas_image_paths[i], _atlas_images[i], false);
     }
 
-    if (!_nmi_dark.load(GliAssetPath("fx/nmi_dark.png")))
-    {
-        return false;
-    }
+    _app->assets().add(GliAssetPath("maps/6502.png"), [this]() {
+        GLI_MEMORY_TAG("tilemap");
+        return _tilemap.load_minimap(GliAssetPath("maps/6502.png"));
+    });
 
-    if (!_nmi_shock.load(GliAssetPath("fx/nmi_shock.png")))
+    if (!_puzzle_state.on_init(app))
     {
         return false;
     }
 
-    if (!_tilemap.load_minimap(GliAssetPath("maps/6502.png")))
-    {
-        return false;
-    }
+    _app->assets().add(GliAssetPath("puzzles/puzzle_list.bin"), [this]() {
+        //// clang-format off
+        //static const std::vector<const char*> puzzle_paths{
+        //    GliAssetPath("puzzles/tax.bin"),
+        //    GliAssetPath("puzzles/txa.bin"),
+        //    GliAssetPath("puzzles/lda_immediate.bin"),
+        //    GliAssetPath("puzzles/add.bin"),
+        //    GliAssetPath("puzzles/sub.bin"),
+        //    GliAssetPath("puzzles/inc.bin"),
+        //    GliAssetPath("puzzles/ora_indexed.bin"),
+        //    GliAssetPath("puzzles/jmp.bin"),
+        //    GliAssetPath("puzzles/lda_indirect.bin"),
+        //    GliAssetPath("puzzles/sta.bin"),
+        //};
+        //// clang-format on
+        std::vector<std::string> puzzle_paths = load_puzzle_list(GliAssetPath("puzzles/puzzle_list.bin"));
+        _puzzles.reserve(puzzle_paths.size());
+
+        for (const std::string& path : puzzle_paths)
+        {
+            Puzzle::Definition definition;
 
-    if (!_puzzle_state.on_init(app))
+            if (Puzzle::load(definition, path))
+            {
+                _puzzles.push_back(definition);
+            }
+            else
+            {
+                gli::logf("GamePlayState::on_init: Failed to load puzzle '%s'\n", path.c_str());
+            }
+        }
+
+        return !_puzzles.empty();
+    });
+
+    return true;
+}
+
+
+bool GamePlayState::on_loaded()
+{
+    for (int i = 0; i < Sprite::Count + 2; ++i)
     {
-        return false;
+        _atlas.add(atlas_image_paths[i], std::move(_atlas_images[i]));
     }
 
-    //// clang-format off
-    //static const std::vector<const char*> puzzle_paths{
-    //    GliAssetPath("puzzles/tax.bin"),
-    //    GliAssetPath("puzzles/txa.bin"),
-    //    GliAssetPath("puzzles/lda_immediate.bin"),
-    //    GliAssetPath("puzzles/add.bin"),
-    //    GliAssetPath("puzzles/sub.bin"),
-    //    GliAssetPath("puzzles/inc.bin"),
-    //    GliAssetPath("puzzles/ora_indexed.bin"),
-    //    GliAssetPath("puzzles/jmp.bin"),
-    //    GliAssetPath("puzzles/lda_indirect.bin"),
-    //    GliAssetPath("puzzles/sta.bin"),
-    //};
-    //// clang-format on
-    std::vector<std::string> puzzle_paths = load_puzzle_list(GliAssetPath("puzzles/puzzle_list.bin"));
-
-    if (puzzle_paths.empty())
+    if (!_atlas.pack())
     {
         return false;
     }
 
-    _puzzles.reserve(puzzle_paths.size());
-
-    for (const std::string& path : puzzle_paths)
+    for (int i = 0; i < Sprite::Count; ++i)
     {
-        Puzzle::Definition definition;
-
-        if (Puzzle::load(definition, path))
-        {
-            _puzzles.push_back(definition);
-        }
-        else
-        {
-            gli::logf("GamePlayState::on_init: Failed to load puzzle '%s'\n", path);
-        }
+        _sprites[i] = _atlas.handle(i);
     }
 
-    if (_puzzles.empty())
-    {
-        return 0;
-    }
+    _nmi_dark = _atlas.handle(Sprite::Count);
+    _nmi_shock = _atlas.handle(Sprite::Count + 1);
 
-    return true;
+    return _puzzle_state.on_loaded();
 }
 
 
@@ -193,9 +199,13 @@ void GamePlayState::on_destroy()
 
 bool GamePlayState::on_enter()
 {
-    if (!_tilemap.load(GliAssetPath("maps/6502.bin")))
     {
-        return false;
+        GLI_MEMORY_TAG("tilemap");
+
+        if (!_tilemap.load(GliAssetPath("maps/6502.bin")))
+        {
+            return false;
+        }
     }
 
     _nmitimer = 0.0f;
@@ -234,6 +244,15 @@ bool GamePlayState::on_enter()
         ai_movable++;
     }
 
+    // The map is loaded again on every entry
+    if (!_tile_layer)
+    {
+        _tile_layer = &_app->add_layer(_app->screen_width() + _tilemap.tile_size(), _app->screen_height() + _tilemap.tile_size());
+    }
+
+    _tile_layer->set_visible(true);
+    _tile_layer_valid = false;
+
     _ais_remaining = _brains.size();
     _simulation_delta = 0.0f;
     _map_view = 0;
@@ -258,6 +277,7 @@ bool GamePlayState::on_enter()
 void GamePlayState::on_exit()
 {
     _movables.clear();
+    _tile_layer->set_visible(false);
 
     if (_puzzle_mode)
     {
@@ -293,6 +313,69 @@ static float ease_out(float t)
 
 static const float ShortFade = 0.125f;
 
+// The camera follows where the player was at the end of the last frame, so the tile layer can scroll ahead of compositing and
+// everything render_game draws over it lines up
+void GamePlayState::on_pre_update(float)
+{
+    const Movable& player = _movables[0];
+    int tile_size = _tilemap.tile_size();
+    _cx = (int)(player.position.x * tile_size + 0.5f) - _app->screen_width() / 2;
+    _cy = (int)(player.position.y * tile_size + 0.5f) - _app->screen_height() / 2;
+
+    // Rounded down, the camera can be left of or above the map
+    int tile_x = (_cx >= 0 ? _cx : _cx - tile_size + 1) / tile_size;
+    int tile_y = (_cy >= 0 ? _cy : _cy - tile_size + 1) / tile_size;
+
+    if (!_tile_layer_valid || tile_x != _tile_layer_x || tile_y != _tile_layer_y)
+    {
+        _tile_layer_x = tile_x;
+        _tile_layer_y = tile_y;
+        _tile_layer_valid = true;
+        draw_tile_layer();
+    }
+
+    _tile_layer->set_scroll(_cx - tile_x * tile_size, _cy - tile_y * tile_size);
+}
+
+
+void GamePlayState::draw_tile_layer()
+{
+    gli::Surface& surface = _tile_layer->surface();
+    int tile_size = _tilemap.tile_size();
+
+    _app->push_target(surface);
+    _app->clear_screen(gli::Pixel(0x1F1D2C));
+
+    for (int y = 0; y * tile_size < surface.height(); ++y)
+    {
+        for (int x = 0; x * tile_size < surface.width(); ++x)
+        {
+            // Off the map reads as tile 0, nothing
+            int t = _tilemap(_tile_layer_x + x, _tile_layer_y + y);
+
+            if (t)
+            {
+                int ox;
+                int oy;
+                bool has_alpha;
+                _tilemap.draw_info(t - 1, ox, oy, has_alpha);
+
+                if (has_alpha)
+                {
+                    _app->blend_partial_sprite(x * tile_size, y * tile_size, _tilemap.tilesheet(), ox, oy, tile_size, tile_size, 255);
+                }
+                else
+                {
+                    _app->draw_partial_sprite(x * tile_size, y * tile_size, &_tilemap.tilesheet(), ox, oy, tile_size, tile_size);
+                }
+            }
+        }
+    }
+
+    _app->pop_target();
+}
+
+
 bool GamePlayState::on_update(float delta)
 {
     if (_game_over && _app->key_state(gli::Key_Space).pressed)
@@ -761,61 +844,9 @@ void GamePlayState::update_ai(float delta)
 
 void GamePlayState::render_game(float delta)
 {
-    _app->clear_screen(gli::Pixel(0x1F1D2C));
-
+    // The tiles are a layer under the screen, on_pre_update has already scrolled it to _cx and _cy
     Movable& player = _movables[0];
 
-    _cx = (int)(player.position.x * _tilemap.tile_size() + 0.5f) - _app->screen_width() / 2;
-    _cy = (int)(player.position.y * _tilemap.tile_size() + 0.5f) - _app->screen_height() / 2;
-
-    int coarse_scroll_x = _cx / _tilemap.tile_size();
-    int coarse_scroll_y = _cy / _tilemap.tile_size();
-    int fine_scroll_x = _cx % _tilemap.tile_size();
-    int fine_scroll_y = _cy % _tilemap.tile_size();
-
-    int sy = -fine_scroll_y;
-
-    for (int y = coarse_scroll_y; y < _tilemap.height(); ++y)
-    {
-        int sx = -fine_scroll_x;
-
-        for (int x = coarse_scroll_x; x < _tilemap.width(); ++x)
-        {
-            int t = _tilemap(x, y);
-
-            if (t)
-            {
-                int ox;
-                int oy;
-                bool has_alpha;
-                _tilemap.draw_info(t - 1, ox, oy, has_alpha);
-
-                if (has_alpha)
-                {
-                    _app->blend_partial_sprite(sx, sy, _tilemap.tilesheet(), ox, oy, _tilemap.tile_size(), _tilemap.tile_size(), 255);
-                }
-                else
-                {
-                    _app->draw_partial_sprite(sx, sy, &_tilemap.tilesheet(), ox, oy, _tilemap.tile_size(), _tilemap.tile_size());
-                }
-            }
-
-            sx += _tilemap.tile_size();
-
-            if (sx >= _app->screen_width())
-            {
-                break;
-            }
-        }
-
-        sy += _tilemap.tile_size();
-
-        if (sy >= _app->screen_height())
-        {
-            break;
-        }
-    }
-
     // fx - pre-sprites
     if (_nmitimer > 0.0f)
     {
@@ -847,9 +878,9 @@ void GamePlayState::render_hud(float delta)
 
     // HUD
     int health_fill = (_health * HudGfx::HealthFillW) / 100;
-    _app->blend_partial_sprite(16 + HudGfx::HealthBarW - HudGfx::HealthFillW, 16 + 3, _sprites[Sprite::Hud], HudGfx::HealthFillX, HudGfx::HealthFillY,
-                               health_fill, HudGfx::HealthFillH, hud_alpha);
-    _app->blend_partial_sprite(16, 16, _sprites[Sprite::Hud], HudGfx::HealthBarX, HudGfx::HealthBarY, HudGfx::HealthBarW, HudGfx::HealthBarH,
+    _app->blend_partial_sprite(16 + HudGfx::HealthBarW - HudGfx::HealthFillW, 16 + 3, _atlas, _sprites[Sprite::Hud], HudGfx::HealthFillX,
+                               HudGfx::HealthFillY, health_fill, HudGfx::HealthFillH, hud_alpha);
+    _app->blend_partial_sprite(16, 16, _atlas, _sprites[Sprite::Hud], HudGfx::HealthBarX, HudGfx::HealthBarY, HudGfx::HealthBarW, HudGfx::HealthBarH,
                                hud_alpha);
 
     int score_digits[4];
@@ -877,7 +908,7 @@ void GamePlayState::render_hud(float delta)
 
     for (int i = 0; i < 4; ++i)
     {
-        _app->blend_partial_sprite(score_x, score_y, _sprites[Sprite::Hud], HudGfx::ScoreNumbersX + score_digits[i] * HudGfx::ScoreNumbersW,
+        _app->blend_partial_sprite(score_x, score_y, _atlas, _sprites[Sprite::Hud], HudGfx::ScoreNumbersX + score_digits[i] * HudGfx::ScoreNumbersW,
                                    HudGfx::ScoreNumbersY, HudGfx::ScoreNumbersW, HudGfx::ScoreNumbersH, hud_alpha);
         score_x += HudGfx::ScoreNumbersW;
     }
@@ -896,14 +927,15 @@ void GamePlayState::render_hud(float delta)
     int illegal_opcode_pad = 8;
     int remaining_x = _app->screen_width() - (16 + HudGfx::ScoreNumbersW * 2 + HudGfx::IllegalOpcodeW + illegal_opcode_pad);
     int remaining_y = _app->screen_height() - (16 + HudGfx::ScoreNumbersH);
-    _app->blend_partial_sprite(remaining_x, remaining_y, _sprites[Sprite::Hud], HudGfx::IllegalOpcodeX, HudGfx::IllegalOpcodeY,
+    _app->blend_partial_sprite(remaining_x, remaining_y, _atlas, _sprites[Sprite::Hud], HudGfx::IllegalOpcodeX, HudGfx::IllegalOpcodeY,
                                HudGfx::IllegalOpcodeW, HudGfx::IllegalOpcodeH, hud_alpha);
     remaining_x += HudGfx::IllegalOpcodeW + illegal_opcode_pad;
 
     for (int i = 0; i < 2; ++i)
     {
-        _app->blend_partial_sprite(remaining_x, remaining_y, _sprites[Sprite::Hud], HudGfx::ScoreNumbersX + score_digits[i] * HudGfx::ScoreNumbersW,
-                                   HudGfx::ScoreNumbersY, HudGfx::ScoreNumbersW, HudGfx::ScoreNumbersH, hud_alpha);
+        _app->blend_partial_sprite(remaining_x, remaining_y, _atlas, _sprites[Sprite::Hud],
+                                   HudGfx::ScoreNumbersX + score_digits[i] * HudGfx::ScoreNumbersW, HudGfx::ScoreNumbersY, HudGfx::ScoreNumbersW,
+                                   HudGfx::ScoreNumbersH, hud_alpha);
         remaining_x += HudGfx::ScoreNumbersW;
     }
 
@@ -920,10 +952,10 @@ void GamePlayState::render_hud(float delta)
 
 void GamePlayState::render_overlay(float delta, Sprite overlay)
 {
-    int x = (_app->screen_width() - _sprites[overlay].width()) / 2;
-    int y = (_app->screen_height() - _sprites[overlay].height()) / 2;
+    int x = (_app->screen_width() - _sprites[overlay].w) / 2;
+    int y = (_app->screen_height() - _sprites[overlay].h) / 2;
     uint8_t overlay_fade = (uint8_t)std::ceil(ease_in(delta) * 255.0f);
-    _app->blend_sprite(x, y, _sprites[overlay], overlay_fade);
+    _app->blend_sprite(x, y, _atlas, _sprites[overlay], overlay_fade);
 }
 
 
@@ -931,14 +963,26 @@ void GamePlayState::render_minimap(float delta)
 {
     _app->clear_screen(gli::Pixel(App::BgColor));
 
-    int mx, my;
-    mx = (_app->screen_width() - _tilemap.minimap().width()) / 2;
-    my = (_app->screen_height() - _tilemap.minimap().height()) / 2;
-    _app->blend_sprite(mx, my, _tilemap.minimap(), 255);
+    // Scaled up to the height of the screen, the markers stay their own size
+    const gli::Sprite& minimap = _tilemap.minimap();
+    int mh = _app->screen_height();
+    int mw = minimap.width() * mh / minimap.height();
+    int mx = (_app->screen_width() - mw) / 2;
+    int my = 0;
+    _app->set_blend_mode(gli::BlendMode::SrcAlpha, gli::BlendMode::InvSrcAlpha, 0);
+    _app->set_blend_op(gli::BlendOp::Add);
+    _app->draw_sprite_scaled(mx, my, mw, mh, minimap, gli::Filter_Bilinear);
+    _app->set_blend_op(gli::BlendOp::None);
+
+    auto to_screen = [&](int& px, int& py) {
+        px = px * mw / minimap.width();
+        py = py * mh / minimap.height();
+    };
 
     int px, py;
     _tilemap.pos_to_minimap(_movables[0].position, px, py);
-    _app->blend_partial_sprite(mx + px - 4, my + py - 4, _sprites[Sprite::MapMarkers], 0, 0, 8, 8, 255);
+    to_screen(px, py);
+    _app->blend_partial_sprite(mx + px - 4, my + py - 4, _atlas, _sprites[Sprite::MapMarkers], 0, 0, 8, 8, 255);
 
     for (const AiBrain& brain : _brains)
     {
@@ -947,7 +991,8 @@ void GamePlayState::render_minimap(float delta)
         if (movable.active)
         {
             _tilemap.pos_to_minimap(movable.position, px, py);
-            _app->blend_partial_sprite(mx + px - 4, my + py - 4, _sprites[Sprite::MapMarkers], 8, 0, 8, 8, 255);
+            to_screen(px, py);
+            _app->blend_partial_sprite(mx + px - 4, my + py - 4, _atlas, _sprites[Sprite::MapMarkers], 8, 0, 8, 8, 255);
         }
     }
 
@@ -966,11 +1011,11 @@ void GamePlayState::render_minimap(float delta)
 
 void GamePlayState::draw_sprite(const V2f& position, Sprite sprite, int frame)
 {
-    int size = _sprites[sprite].height();
+    int size = _sprites[sprite].h;
     int half_size = size / 2;
     int sx = (int)(position.x * _tilemap.tile_size() + 0.5f) - _cx - half_size;
     int sy = (int)(position.y * _tilemap.tile_size() + 0.5f) - _cy - half_size;
-    _app->blend_partial_sprite(sx, sy, _sprites[sprite], frame * size, 0, size, size, 255);
+    _app->blend_partial_sprite(sx, sy, _atlas, _sprites[sprite], frame * size, 0, size, size, 255);
 }
 
 
@@ -998,7 +1043,7 @@ void GamePlayState::draw_nmi(const V2f& position)
     {
         int nmi_sx = (int)(position.x * _tilemap.tile_size() + 0.5f) - _cx;
         int nmi_sy = (int)(position.y * _tilemap.tile_size() + 0.5f) - _cy;
-        _app->blend_sprite(nmi_sx - _nmi_dark.width() / 2, nmi_sy - _nmi_dark.height() / 2, _nmi_dark, nmidarkalpha);
+        _app->blend_sprite(nmi_sx - _nmi_dark.w / 2, nmi_sy - _nmi_dark.h / 2, _atlas, _nmi_dark, nmidarkalpha);
     }
 
     uint8_t nmizapalpha = 0;
@@ -1024,7 +1069,7 @@ void GamePlayState::draw_nmi(const V2f& position)
         {
             int nmi_sx = (int)(position.x * _tilemap.tile_size() + 0.5f) - _cx;
             int nmi_sy = (int)(position.y * _tilemap.tile_size() + 0.5f) - _cy;
-            _app->blend_sprite(nmi_sx - _nmi_shock.width() / 2, nmi_sy - _nmi_shock.height() / 2, _nmi_shock, nmizapalpha);
+            _app->blend_sprite(nmi_sx - _nmi_shock.w / 2, nmi_sy - _nmi_shock.h / 2, _atlas, _nmi_shock, nmizapalpha);
         }
     }
 }
@@ -1059,14 +1104,14 @@ bool GamePlayState::check_collision(const V2f& position, uint8_t filter_flags, f
 
 void GamePlayState::move_movables(float delta)
 {
-    std::vector<V2f> positions(_movables.size());
-    std::vector<V2f> movements(_movables.size());
-    std::vector<V2f> velocities(_movables.size());
+    gli::FrameArena& arena = _app->frame_arena();
+    gli::FrameVector<V2f> positions(_movables.size(), V2f{}, arena);
+    gli::FrameVector<V2f> movements(_movables.size(), V2f{}, arena);
+    gli::FrameVector<V2f> velocities(_movables.size(), V2f{}, arena);
     size_t i = 0;
 
     for (Movable& movable : _movables)
     {
-        Movable& movable = _movables[i];
         V2f& position = positions[i];
         V2f& move = movements[i];
         V2f& velocity = velocities[i];
@@ -1126,8 +1171,8 @@ void GamePlayState::fire_bullet(const Movable& attacker, const V2f& target)
 
 void GamePlayState::update_bullets(float delta)
 {
-    std::vector<Bullet> keep_bullets;
-    keep_bullets.reserve(_bullets.size());
+    // Compacted in place, keeping the order they were fired in
+    size_t kept = 0;
 
     for (Bullet& bullet : _bullets)
     {
@@ -1145,19 +1190,19 @@ void GamePlayState::update_bullets(float delta)
             else
             {
                 bullet.position = next_position;
-                keep_bullets.push_back(bullet);
+                _bullets[kept++] = bullet;
             }
         }
     }
 
-    _bullets = keep_bullets;
+    _bullets.erase(_bullets.begin() + kept, _bullets.end());
 }
 
 
 void GamePlayState::spawn_particle_system(const Movable& movable)
 {
-    gli::Sprite& sprite = _sprites[movable.sprite];
-    int size = sprite.height();
+    gli::AtlasHandle sprite = _sprites[movable.sprite];
+    int size = sprite.h;
     _particles.reserve(_particles.size() + size);
     V2f pos = (movable.position * _tilemap.tile_size()) + V2f{ size * -0.5f, size * -0.5f };
 
@@ -1169,7 +1214,7 @@ void GamePlayState::spawn_particle_system(const Movable& movable)
         p.frame = movable.frame;
         p.life = gRandom.get(ParticleLifeMin, ParticleLifeMax);
         p.max_life = p.life;
-        p.velocity.y = -2.0f * sprite.height() / p.life;
+        p.velocity.y = -2.0f * sprite.h / p.life;
         p.position = pos;
         pos.x = pos.x + 1.0f;
         _particles.push_back(p);
@@ -1179,8 +1224,7 @@ void GamePlayState::spawn_particle_system(const Movable& movable)
 
 void GamePlayState::update_particles(float delta)
 {
-    std::vector<Particle> keep_particles;
-    keep_particles.reserve(_particles.size());
+    size_t kept = 0;
 
     for (Particle& particle : _particles)
     {
@@ -1188,11 +1232,11 @@ void GamePlayState::update_particles(float delta)
         {
             particle.life -= delta;
             particle.position.y += delta * particle.velocity.y;
-            keep_particles.push_back(particle);
+            _particles[kept++] = particle;
         }
     }
 
-    _particles = keep_particles;
+    _particles.erase(_particles.begin() + kept, _particles.end());
 }
 
 
@@ -1200,12 +1244,12 @@ void GamePlayState::render_particles()
 {
     for (Particle& p : _particles)
     {
-        gli::Sprite& sprite = _sprites[p.sprite];
-        int size = sprite.height();
+        gli::AtlasHandle sprite = _sprites[p.sprite];
+        int size = sprite.h;
         int sx = (int)(p.position.x + 0.5f) - _cx;
         int sy = (int)(p.position.y + 0.5f) - _cy;
         uint8_t alpha = std::ceil(ease_in(p.life / p.max_life) * 255.0f);
-        _app->blend_partial_sprite(sx, sy, sprite, p.frame * size + p.column, 0, 1, size, alpha);
+        _app->blend_partial_sprite(sx, sy, _atlas, sprite, p.frame * size + p.column, 0, 1, size, alpha);
     }
 }
 
@@ -15,11 +15,13 @@ class GamePlayState : public IAppState
 {
 public:
     bool on_init(App* app) override;
+    bool on_loaded() override;
     void on_destroy() override;
     bool on_enter() override;
     void on_exit() override;
     void on_suspend() override;
     void on_resume() override;
+    void on_pre_update(float delta) override;
     bool on_update(float delta) override;
 
 private:
@@ -78,6 +80,7 @@ private:
     void update_simulation(float delta);
     void update_ai(float delta);
 
+    void draw_tile_layer();
     void render_game(float delta);
     void render_hud(float delta);
     void render_overlay(float delta, Sprite sprite);
@@ -107,12 +110,18 @@ private:
 
     PuzzleState _puzzle_state;
     TileMap _tilemap;
-    gli::Sprite _sprites[Sprite::Count];
-    gli::Sprite _nmi_dark;
-    gli::Sprite _nmi_shock;
+    gli::Sprite _atlas_images[Sprite::Count + 2]; // Loaded in the background, then moved onto the atlas
+    gli::SpriteAtlas _atlas;
+    gli::AtlasHandle _sprites[Sprite::Count];
+    gli::AtlasHandle _nmi_dark;
+    gli::AtlasHandle _nmi_shock;
     App* _app{};
     int _cx;
     int _cy;
+    gli::RenderLayer* _tile_layer{}; // The tiles around the camera, a tile bigger than the screen each way
+    int _tile_layer_x;               // The tile at its top left
+    int _tile_layer_y;
+    bool _tile_layer_valid{};
     float _nmitimer;
     float _nmifired;
     float _simulation_delta;
@@ -13,6 +13,9 @@ public:
     // Called once when gamestate is allocated
     virtual bool on_init(App* app) = 0;
 
+    // Called once after every asset the gamestates queued in on_init has loaded
+    virtual bool on_loaded() = 0;
+
     // Called once before gamestate is freed
     virtual void on_destroy() = 0;
 
@@ -28,6 +31,10 @@ public:
     // Called when the application is resumed and the gamestate is active
     virtual void on_resume() = 0;
 
+    // Called each frame when the gamestate is active, before the render layers are composited. Anything that changes a layer
+    // goes here, so it shows the same frame.
+    virtual void on_pre_update(float) {}
+
     // Called each frame when the gamestate is active
     virtual bool on_update(float delta) = 0;
 };
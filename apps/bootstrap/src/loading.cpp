@@ -0,0 +1,62 @@
+#include "loading.h"
+
+#include "bootstrap.h"
+#include "vga9.h"
+
+namespace Bootstrap
+{
+
+bool LoadingState::on_init(App* app)
+{
+    _app = app;
+    return true;
+}
+
+bool LoadingState::on_loaded()
+{
+    return true;
+}
+
+void LoadingState::on_destroy() {}
+
+bool LoadingState::on_enter()
+{
+    return true;
+}
+
+void LoadingState::on_exit() {}
+
+void LoadingState::on_suspend() {}
+
+void LoadingState::on_resume() {}
+
+bool LoadingState::on_update(float delta)
+{
+    gli::AssetLoader& assets = _app->assets();
+
+    if (assets.poll())
+    {
+        if (!_app->on_assets_loaded())
+        {
+            return false;
+        }
+
+        _app->set_next_state(AppState::Splash);
+    }
+
+    static const int BarWidth = 200;
+    static const int BarHeight = 8;
+    int x = (_app->screen_width() - BarWidth) / 2;
+    int y = (_app->screen_height() - BarHeight) / 2;
+    int fill = assets.count() ? (BarWidth - 4) * assets.finished() / assets.count() : BarWidth - 4;
+
+    _app->clear_screen(gli::Pixel(16, 0, 22));
+    _app->draw_string(x, y - vga9_glyph_height - 4, "Loading", vga9_glyphs, vga9_glyph_width, vga9_glyph_height, gli::Pixel(0xFFE2E2E2),
+                      gli::Pixel(16, 0, 22));
+    _app->fill_rect(x, y, BarWidth, BarHeight, 1, gli::Pixel(0xFFE2E2E2), gli::Pixel(16, 0, 22));
+    _app->draw_rect(x + 2, y + 2, fill, BarHeight - 4, gli::Pixel(0xFFE2E2E2));
+
+    return true;
+}
+
+} // namespace Bootstrap
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "iappstate.h"
+
+#include <gli.h>
+
+namespace Bootstrap
+{
+
+// Shows progress while the assets every gamestate queued load in the background, then hands over to the splash screens
+class LoadingState : public IAppState
+{
+public:
+    bool on_init(App* app) override;
+    bool on_loaded() override;
+    void on_destroy() override;
+    bool on_enter() override;
+    void on_exit() override;
+    void on_suspend() override;
+    void on_resume() override;
+    bool on_update(float delta) override;
+
+private:
+    App* _app{};
+};
+
+} // namespace Bootstrap
@@ -484,15 +484,9 @@ bool PuzzleState::on_init(App* app)
                                                        GliAssetPath("gui/go_btn_down.png"),     GliAssetPath("gui/verifying.png"),
                                                        GliAssetPath("gui/validation_fail.png"), GliAssetPath("gui/validation_success.png") };
 
-    size_t idx = 0;
-
-    for (gli::Sprite& sprite : _sprites)
+    for (int i = 0; i < Sprite::Count; ++i)
     {
-        if (!sprite.load(sprite_files[idx]))
-        {
-            return false;
-        }
-        idx++;
+        _app->assets().add(sprite_files[i], _sprites[i]);
     }
 
     // clang-format off
@@ -549,6 +543,12 @@ bool PuzzleState::on_init(App* app)
 }
 
 
+bool PuzzleState::on_loaded()
+{
+    return true;
+}
+
+
 void PuzzleState::on_destroy() {}
 
 
@@ -12,6 +12,7 @@ class PuzzleState : public IAppState
 {
 public:
     bool on_init(App* app) override;
+    bool on_loaded() override;
     void on_destroy() override;
     bool on_enter() override;
     void on_exit() override;
@@ -31,19 +31,12 @@ static SfxInfo infos[SfxId::Count] = {
 static gli::WaveForm waveforms[SfxId::Count];
 
 
-bool load_sfx()
+void queue_sfx(gli::AssetLoader& assets)
 {
-    size_t i = 0;
-
-    for (const SfxInfo& info : infos)
+    for (int i = 0; i < SfxId::Count; ++i)
     {
-        if (!waveforms[i++].load(info.wavefile))
-        {
-            return false;
-        }
+        assets.add(infos[i].wavefile, waveforms[i]);
     }
-
-    return true;
 }
 
 
@@ -32,7 +32,7 @@ struct SfxInfo
     bool looping;
 };
 
-bool load_sfx();
+void queue_sfx(gli::AssetLoader& assets);
 void get_sfx(int id, const SfxInfo*& info, const gli::WaveForm*& wave);
 
 } // namespace Bootstrap
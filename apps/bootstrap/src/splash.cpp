@@ -31,25 +31,27 @@ static float ease_out(float t)
 bool SplashState::on_init(App* app)
 {
     _app = app;
-    return true;
-}
 
-void SplashState::on_destroy() {}
-
-bool SplashState::on_enter()
-{
-    // Load images now - would like to be able to do this async
     static const char* filenames[Screens::Count] = { GliAssetPath("frontend/gli_presents.png"), GliAssetPath("frontend/an_inept_game.png"),
                                                      GliAssetPath("frontend/olc_codejam.png"), GliAssetPath("frontend/bootstrap.png") };
 
     for (int i = 0; i < Screens::Count; ++i)
     {
-        if (!_splash_images[i].load(filenames[i]))
-        {
-            return false;
-        }
+        _app->assets().add(filenames[i], _splash_images[i]);
     }
 
+    return true;
+}
+
+bool SplashState::on_loaded()
+{
+    return true;
+}
+
+void SplashState::on_destroy() {}
+
+bool SplashState::on_enter()
+{
     _current_screen = Screens::GliPresents;
     _screen_timer = -1.0f;
 
@@ -11,6 +11,7 @@ class SplashState : public IAppState
 {
 public:
     bool on_init(App* app) override;
+    bool on_loaded() override;
     void on_destroy() override;
     bool on_enter() override;
     void on_exit() override;
@@ -60,12 +60,18 @@ bool TileMap::load(const std::string& path)
     success = success && vread(_tile_info, map_data, read_ptr);
     success = success && _tilesheet.load(asset_path(tilesheet_path));
 
+    if (success)
+    {
+        _tilesheet.build_runs();
+    }
+
     return success;
 }
 
 
 bool TileMap::load_minimap(const std::string& path)
 {
+    // Drawn scaled, which samples the pixels and has no use for runs
     return _minimap.load(path);
 }
 
@@ -1,24 +1,46 @@
 #include <gli.h>
 
+#include <algorithm>
+
 #include "tilemap.h"
 
 class deadplanet : public gli::App
 {
 public:
+    static const int LayerCount = 3;
+    static const int MaxZoom = 4;
+
     bool on_create() override
     {
         _tilemap.load("maps//deadworld.bin");
+        _tile_px = _tilemap.tile_size();
+        set_deferred_drawing(true);
+
+        // A tile bigger than the screen at the closest zoom, the scroll covers the rest
+        for (int layer = 0; layer < LayerCount; ++layer)
+        {
+            _layers[layer] = &add_layer(screen_width() + _tilemap.tile_size() * MaxZoom, screen_height() + _tilemap.tile_size() * MaxZoom);
+        }
+
         return true;
     }
 
     void on_destroy() override {}
 
     DeadPlanet::TileMap _tilemap{};
+    gli::RenderLayer* _layers[LayerCount]{}; // Ground, then the two layers over it
 
     int _cx = 0;
     int _cy = 0;
+    int _tile_px = 0; // Tiles on screen are this many pixels across, Q and E zoom out and in
+
+    // What the layers were last drawn for
+    int _layer_x = 0;
+    int _layer_y = 0;
+    int _layer_tile_px = 0;
 
-    bool on_update(float delta) override
+    // Moving and zooming scroll and redraw the layers, so it happens ahead of compositing
+    bool on_pre_update(float) override
     {
         if (key_state(gli::Key::Key_W).down)
         {
@@ -40,68 +62,94 @@ public:
             _cx += 1;
         }
 
-        render();
+        if (key_state(gli::Key::Key_Q).pressed && _tile_px > std::max(_tilemap.tile_size() / MaxZoom, 1))
+        {
+            _tile_px /= 2;
+        }
+
+        if (key_state(gli::Key::Key_E).pressed && _tile_px < _tilemap.tile_size() * MaxZoom)
+        {
+            _tile_px *= 2;
+        }
+
+        update_layers();
         return true;
     }
 
-    void render()
+    // Everything on screen is in the layers
+    bool on_update(float) override
     {
-        clear_screen(gli::Pixel(0x1F1D2C));
+        return true;
+    }
 
+    void update_layers()
+    {
         //_cx = (int)(player.position.x * _tilemap.tile_size() + 0.5f) - _app->screen_width() / 2;
         //_cy = (int)(player.position.y * _tilemap.tile_size() + 0.5f) - _app->screen_height() / 2;
 
-        int coarse_scroll_x = _cx / _tilemap.tile_size();
-        int coarse_scroll_y = _cy / _tilemap.tile_size();
-        int fine_scroll_x = _cx % _tilemap.tile_size();
-        int fine_scroll_y = _cy % _tilemap.tile_size();
+        // The camera is in unzoomed pixels, the tile at the top left is rounded down so it can be left of or above the map
+        int scroll_x = _cx * _tile_px / _tilemap.tile_size();
+        int scroll_y = _cy * _tile_px / _tilemap.tile_size();
+        int tile_x = (scroll_x >= 0 ? scroll_x : scroll_x - _tile_px + 1) / _tile_px;
+        int tile_y = (scroll_y >= 0 ? scroll_y : scroll_y - _tile_px + 1) / _tile_px;
 
-        for (int layer = 0; layer < 3; ++layer)
+        if (tile_x != _layer_x || tile_y != _layer_y || _tile_px != _layer_tile_px)
         {
-            int sy = -fine_scroll_y;
+            _layer_x = tile_x;
+            _layer_y = tile_y;
+            _layer_tile_px = _tile_px;
 
-            for (int y = coarse_scroll_y; y < _tilemap.height(); ++y)
+            for (int layer = 0; layer < LayerCount; ++layer)
             {
-                int sx = -fine_scroll_x;
-
-                for (int x = coarse_scroll_x; x < _tilemap.width(); ++x)
-                {
-                    int t = _tilemap(x, y, layer);
+                draw_layer(layer);
+            }
+        }
 
-                    if (t)
-                    {
-                        int sheet;
-                        int ox;
-                        int oy;
-                        bool has_alpha;
-                        _tilemap.draw_info(t - 1, sheet, ox, oy, has_alpha);
-
-                        if (layer > 0)
-                        {
-                            blend_partial_sprite(sx, sy, _tilemap.tilesheet(sheet).texture, ox, oy, _tilemap.tile_size(), _tilemap.tile_size(), 255);
-                        }
-                        else
-                        {
-                            draw_partial_sprite(sx, sy, &_tilemap.tilesheet(sheet).texture, ox, oy, _tilemap.tile_size(), _tilemap.tile_size());
-                        }
-                    }
+        for (gli::RenderLayer* layer : _layers)
+        {
+            layer->set_scroll(scroll_x - tile_x * _tile_px, scroll_y - tile_y * _tile_px);
+        }
+    }
 
-                    sx += _tilemap.tile_size();
+    void draw_layer(int layer)
+    {
+        gli::Surface& surface = _layers[layer]->surface();
+        int tile_size = _tilemap.tile_size();
 
-                    if (sx >= screen_width())
-                    {
-                        break;
-                    }
-                }
+        // The layers over the ground stay transparent between their tiles, and their tiles are copied alpha and all for the
+        // compositor to blend
+        push_target(surface);
+        clear_screen(layer == 0 ? gli::Pixel(0x1F1D2C) : gli::Pixel(0u));
 
-                sy += _tilemap.tile_size();
+        for (int y = 0; y * _tile_px < surface.height(); ++y)
+        {
+            for (int x = 0; x * _tile_px < surface.width(); ++x)
+            {
+                // Off the map reads as tile 0, nothing
+                int t = _tilemap(_layer_x + x, _layer_y + y, layer);
 
-                if (sy >= screen_height())
+                if (t)
                 {
-                    break;
+                    int sheet;
+                    int ox;
+                    int oy;
+                    bool has_alpha;
+                    _tilemap.draw_info(t - 1, sheet, ox, oy, has_alpha);
+                    const gli::Sprite& texture = _tilemap.tilesheet(sheet).texture;
+
+                    if (_tile_px != tile_size)
+                    {
+                        draw_partial_sprite_scaled(x * _tile_px, y * _tile_px, _tile_px, _tile_px, texture, ox, oy, tile_size, tile_size);
+                    }
+                    else
+                    {
+                        draw_partial_sprite(x * _tile_px, y * _tile_px, &texture, ox, oy, tile_size, tile_size);
+                    }
                 }
             }
         }
+
+        pop_target();
     }
 };
 
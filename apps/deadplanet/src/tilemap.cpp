@@ -33,6 +33,12 @@ bool vread(TileMap::TileSheet& ts, std::vector<uint8_t>& data, size_t& read_ptr)
     std::string texture_path;
     result = result && vread(texture_path, data, read_ptr);
     result = result && ts.texture.load(texture_path);
+
+    if (result)
+    {
+        ts.texture.build_runs();
+    }
+
     return result;
 }
 
@@ -10,6 +10,10 @@ bool App::on_create()
 {
     _config.load();
 
+    // DOOM.WAD is about 12 MB and its textures about as much again once they're expanded to 32 bits
+    gli::set_memory_budget("wad", 16 * 1024 * 1024);
+    gli::set_memory_budget("textures", 16 * 1024 * 1024);
+
     GameState* state = new GameState;
     state->on_init(this);
     state->on_pushed();
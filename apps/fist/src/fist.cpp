@@ -2,11 +2,13 @@
 
 #include "app.h"
 
+GLI_MEMORY_HOOK()
+
 fist::App app;
 
 int gli_main(int argc, char** argv)
 {
-    if (app.initialize("Fist", 1280, 720, 1))
+    if (app.initialize("Fist", 1280, 720, 1) && app.input_log_from_args(argc, argv))
     {
         app.show_mouse(true);
         app.run();
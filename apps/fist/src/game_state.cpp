@@ -142,6 +142,11 @@ void GameState::on_update(float delta)
         gliLog(gli::LogLevel::Warning, "RenderIssue", "GameState::on_update", "pos: [%0.8f, %0.8f] facing: %0.8f", _player.pos.p.x, _player.pos.p.y,
                _player.pos.f);
     }
+
+    if (_app->key_state(gli::Key_F6).pressed)
+    {
+        gli::memory_report();
+    }
 }
 
 void GameState::load_configs()
@@ -36,6 +36,7 @@ void Render3D::draw_3d(const ThingPos& viewer, Map* map)
         // Resize
         _floor_mask.reset(new int[_screen_width]);
         _ceiling_mask.reset(new int[_screen_width]);
+        _column_pixels.reset(new gli::Pixel[_screen_height]);
         _solid_columns.reset(new SolidColumns[_screen_width]);
         _visplanes.reset();
         _max_visplanes = 0;
@@ -64,7 +65,15 @@ void Render3D::draw_3d(const ThingPos& viewer, Map* map)
     _solid_columns[1].max = INT32_MAX;
     _solid_columns[1].next = nullptr;
 
-    draw_node(viewer, 0);
+    // Walls and planes are drawn straight into the framebuffer
+    _app->mark_dirty();
+
+    {
+        GLI_PROFILE_SCOPE("Render3D::draw_node");
+        draw_node(viewer, 0);
+    }
+
+    GLI_PROFILE_SCOPE("Render3D::draw_plane");
 
     for (size_t p = 0; p < _num_visplanes; ++p)
     {
@@ -653,16 +662,26 @@ void Render3D::draw_column(int x, float dist, float texu, float top, float botto
         int dest_stride = _screen_width;
         gli::Pixel* dest = _app->get_framebuffer() + x + (y1 * dest_stride);
         int iu = (int)std::floor(texu * _tex_scale + 0.5f) % texture->height();
-        gli::Pixel* src = texture->pixels() + iu * texture->width();
+        gli::Pixel* src = texture->pixels() + iu * texture->stride();
 
         float fade = (fade_offset / 255.0f) + clamp(1.0f - (dist / _max_fade_dist), 0.0f, 0.8f) * sector_light;
+        gli::Pixel* column = _column_pixels.get();
+        int count = y2 - y1;
 
-        for (int y = y1; y < y2; ++y, dest += dest_stride)
+        // Texels are gathered into a contiguous run so the whole column is shaded in one batch
+        for (int i = 0; i < count; ++i)
         {
             int iv = (int)std::floor(texv * _tex_scale + 0.5f) % texture->width();
-            *dest = src[iv] * fade;
+            column[i] = src[iv];
             texv += dvdy;
         }
+
+        _light_table.scale_pixels(column, count, _light_table.level(fade));
+
+        for (int i = 0; i < count; ++i, dest += dest_stride)
+        {
+            *dest = column[i];
+        }
     }
     else
     {
@@ -730,6 +749,7 @@ void Render3D::draw_plane(const ThingPos& viewer, size_t plane)
                         float u = world_x + dx * dudx;
                         float v = world_y + dx * dvdx;
                         gli::Pixel* src = texture->pixels();
+                        int src_stride = texture->stride();
                         gli::Pixel* dest = _app->get_framebuffer() + (y * _screen_width) + span_start;
                         int iu = (int)std::floor(u * _tex_scale + 0.5f);
                         int iv = (int)std::floor(v * _tex_scale + 0.5f);
@@ -742,10 +762,11 @@ void Render3D::draw_plane(const ThingPos& viewer, size_t plane)
                         float verror = 0.0f;
                         int uerradjust = dudx < 0.0f ? -1 : 1;
                         int verradjust = dvdx < 0.0f ? -1 : 1;
+                        gli::Pixel* span = dest;
 
                         for (int x = span_start; x < span_end; ++x)
                         {
-                            *dest++ = src[(iu & 63) + (iv & 63) * 64] * fade;
+                            *dest++ = src[(iu & 63) + (iv & 63) * src_stride];
                             iu += ustep;
                             iv += vstep;
                             uerror += uerrstep;
@@ -763,6 +784,8 @@ void Render3D::draw_plane(const ThingPos& viewer, size_t plane)
                                 verror -= 1.0f;
                             }
                         }
+
+                        _light_table.scale_pixels(span, span_end - span_start, _light_table.level(fade));
                     }
                     else
                     {
@@ -2,6 +2,8 @@
 
 #include "types.h"
 
+#include <gli_light.h>
+
 #include <memory>
 
 namespace fist
@@ -53,6 +55,7 @@ private:
     Transform2D _world_view{};
     std::unique_ptr<int[]> _floor_mask{};
     std::unique_ptr<int[]> _ceiling_mask{};
+    std::unique_ptr<gli::Pixel[]> _column_pixels{};
     std::unique_ptr<SolidColumns[]> _solid_columns{};
     int _num_solid_columns{};
     std::unique_ptr<VisPlane[]> _visplanes{};
@@ -61,6 +64,9 @@ private:
     size_t _ceiling_plane;
     size_t _floor_plane;
 
+    // Shading up to 2x, for the brightening fade_offset adds, in steps of 1/255
+    gli::LightTable _light_table{ 511, 2.0f };
+
     void load_configs();
     void grow_visplanes();
     size_t find_visplane(uint64_t texture, float height, float light);
@@ -19,6 +19,8 @@ bool TextureManager::add_wad(const std::string& path)
 
 bool TextureManager::add_wad(WadFile* wad_file)
 {
+    GLI_MEMORY_TAG("textures");
+
     auto load_callback = [](int64_t id, const Wad::Texture& texture, void* user_data) {
         TextureManager* tm = (TextureManager*)user_data;
         tm->_lookup[id] = tm->_textures.size();
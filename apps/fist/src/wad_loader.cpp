@@ -54,6 +54,8 @@ static constexpr uint32_t magicPWAD()
 
 WadFile* wad_open(const std::string& path)
 {
+    GLI_MEMORY_TAG("wad");
+
     std::ifstream is(path, std::ios::binary);
 
     if (!is)
@@ -182,7 +182,19 @@ bool GsPlay::on_init(Tetris* app)
     m_playfield_screen_max.x = m_playfield_screen_min.x + s_playfield_width * s_tile_size;
     m_playfield_screen_max.y = m_playfield_screen_min.y + s_visible_rows * s_tile_size;
 
-    m_random_generator.seed(m_random_device());
+    m_playfield_layer = &m_app->add_layer(m_app->screen_width(), m_app->screen_height());
+    m_playfield_layer->set_visible(false);
+
+    // A recording only plays the same game back from the same pieces
+    if (m_app->recording_input() || m_app->replaying_input())
+    {
+        m_random_generator.seed(0);
+    }
+    else
+    {
+        m_random_generator.seed(m_random_device());
+    }
+
     return true;
 }
 
@@ -207,6 +219,8 @@ bool GsPlay::on_enter()
     m_lines = 0;
     m_level = 0;
     m_gamespeed = powf(0.8f - ((float)m_level * 0.007f), (float)m_level);
+    m_playfield_layer->surface().invalidate();
+    m_playfield_layer->set_visible(true);
 
     return true;
 }
@@ -214,6 +228,7 @@ bool GsPlay::on_enter()
 
 void GsPlay::on_exit()
 {
+    m_playfield_layer->set_visible(false);
 }
 
 
@@ -227,7 +242,9 @@ void GsPlay::on_resume()
 }
 
 
-bool GsPlay::on_update(float delta)
+// The game moves on here and the playfield layer is redrawn, ahead of compositing, so a piece locking or a row clearing shows
+// in the same frame as the falling piece on_update draws
+void GsPlay::on_pre_update(float delta)
 {
     if (m_game_over)
     {
@@ -311,43 +328,15 @@ bool GsPlay::on_update(float delta)
         }
     }
 
-    m_app->clear_screen(0);
-
+    if (m_playfield_layer->surface().stale())
     {
-        for (int y = 0; y < s_visible_rows; ++y)
-        {
-            for (int x = 0; x < s_playfield_width; ++x)
-            {
-                V2i pf_pos{ x, y };
-                V2i tile_pos = playfield_to_screen(pf_pos);
-                int ox = read_playfield(pf_pos) * s_tile_size;
-
-                if (ox >= 0)
-                {
-                    m_app->draw_partial_sprite(tile_pos.x, tile_pos.y, m_sprite.get(), ox, 0, s_tile_size, s_tile_size);
-                }
-            }
-        }
-
-        int ox = s_border_index * s_tile_size;
-        int sy = m_playfield_screen_min.y;
-
-        for (int y = 0; y < s_visible_rows; ++y)
-        {
-            m_app->draw_partial_sprite(m_playfield_screen_min.x - s_tile_size, sy, m_sprite.get(), ox, 0, s_tile_size, s_tile_size);
-            m_app->draw_partial_sprite(m_playfield_screen_max.x, sy, m_sprite.get(), ox, 0, s_tile_size, s_tile_size);
-            sy += s_tile_size;
-        }
-
-        int sx = m_playfield_screen_min.x - s_tile_size;
-
-        for (int x = 0; x < s_playfield_width + 2; ++x)
-        {
-            m_app->draw_partial_sprite(sx, sy, m_sprite.get(), ox, 0, s_tile_size, s_tile_size);
-            sx += s_tile_size;
-        }
+        draw_playfield();
     }
+}
+
 
+bool GsPlay::on_update(float)
+{
     if (m_tetronimo)
     {
         V2i screen_pos;
@@ -531,6 +520,8 @@ void GsPlay::add_to_playfield(int t, int tx, int ty, int r)
 
         by--;
     }
+
+    m_playfield_layer->surface().invalidate();
 }
 
 
@@ -561,6 +552,7 @@ bool GsPlay::remove_full_row()
             m_lines++;
             m_level = m_lines / 10;
             m_gamespeed = powf(0.8f - ((float)m_level * 0.007f), (float)m_level);
+            m_playfield_layer->surface().invalidate();
             return true;
         }
     }
@@ -689,6 +681,48 @@ void GsPlay::draw_tetronimo(int x, int y, int t, int r, bool clip_to_payfield, b
     }
 }
 
+void GsPlay::draw_playfield()
+{
+    m_app->push_target(m_playfield_layer->surface());
+    m_app->clear_screen(0);
+
+    for (int y = 0; y < s_visible_rows; ++y)
+    {
+        for (int x = 0; x < s_playfield_width; ++x)
+        {
+            V2i pf_pos{ x, y };
+            V2i tile_pos = playfield_to_screen(pf_pos);
+            int ox = read_playfield(pf_pos) * s_tile_size;
+
+            if (ox >= 0)
+            {
+                m_app->draw_partial_sprite(tile_pos.x, tile_pos.y, m_sprite.get(), ox, 0, s_tile_size, s_tile_size);
+            }
+        }
+    }
+
+    int ox = s_border_index * s_tile_size;
+    int sy = m_playfield_screen_min.y;
+
+    for (int y = 0; y < s_visible_rows; ++y)
+    {
+        m_app->draw_partial_sprite(m_playfield_screen_min.x - s_tile_size, sy, m_sprite.get(), ox, 0, s_tile_size, s_tile_size);
+        m_app->draw_partial_sprite(m_playfield_screen_max.x, sy, m_sprite.get(), ox, 0, s_tile_size, s_tile_size);
+        sy += s_tile_size;
+    }
+
+    int sx = m_playfield_screen_min.x - s_tile_size;
+
+    for (int x = 0; x < s_playfield_width + 2; ++x)
+    {
+        m_app->draw_partial_sprite(sx, sy, m_sprite.get(), ox, 0, s_tile_size, s_tile_size);
+        sx += s_tile_size;
+    }
+
+    m_app->pop_target();
+}
+
+
 void GsPlay::hold()
 {
     std::swap(m_tetronimo, m_tetronimo_held);
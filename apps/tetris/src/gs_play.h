@@ -24,6 +24,7 @@ public:
     void on_exit() override;
     void on_suspend() override;
     void on_resume() override;
+    void on_pre_update(float delta) override;
     bool on_update(float delta) override;
 
 private:
@@ -117,6 +118,7 @@ private:
     char m_playfield[s_playfield_width * s_playfield_height];
     Tetronimo m_tetronimos[7];
     std::unique_ptr<gli::Sprite> m_sprite;
+    gli::RenderLayer* m_playfield_layer; // Locked pieces and the border, redrawn when they change
     uint8_t m_bag[16];
     uint8_t m_bag_read_ptr{ 0xFB };
     uint8_t m_bag_write_ptr{ 0xFB };
@@ -150,5 +152,6 @@ private:
     bool attempt_move(int dx, int dy);
     void hard_drop();
     void draw_tetronimo(int x, int y, int t, int r, bool clip_to_payfield, bool ghost);
+    void draw_playfield();
     void hold();
 };
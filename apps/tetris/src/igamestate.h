@@ -25,6 +25,10 @@ public:
     // Called when the application is resumed and the gamestate is active
     virtual void on_resume() = 0;
 
+    // Called each frame when the gamestate is active, before the render layers are composited. Anything that changes a layer
+    // goes here, so it shows the same frame.
+    virtual void on_pre_update(float) {}
+
     // Called each frame when the gamestate is active
     virtual bool on_update(float delta) = 0;
 };
@@ -54,7 +54,8 @@ void Tetris::on_destroy()
 }
 
 
-bool Tetris::on_update(float delta)
+// State changes happen here so a state entering shows its layers on its first frame
+bool Tetris::on_pre_update(float delta)
 {
     if (m_next_gamestate != GS_COUNT)
     {
@@ -78,6 +79,17 @@ bool Tetris::on_update(float delta)
         }
     }
 
+    if (m_active_state)
+    {
+        m_active_state->on_pre_update(delta);
+    }
+
+    return true;
+}
+
+
+bool Tetris::on_update(float delta)
+{
     if (m_active_state)
     {
         if (!m_active_state->on_update(delta))
@@ -101,7 +113,7 @@ Tetris app;
 
 int gli_main(int argc, char** argv)
 {
-    if (app.initialize("Tetris", 30 * 16, 24 * 16, 2))
+    if (app.initialize("Tetris", 30 * 16, 24 * 16, 2) && app.input_log_from_args(argc, argv))
     {
         app.run();
     }
@@ -21,6 +21,7 @@ public:
 
     bool on_create() override;
     void on_destroy() override;
+    bool on_pre_update(float delta) override;
     bool on_update(float delta) override;
 
     void set_next_state(GameState gs);
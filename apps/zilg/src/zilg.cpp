@@ -6,6 +6,8 @@
 #include <deque>
 #include <vector>
 
+GLI_MEMORY_HOOK()
+
 class Zilg : public gli::App
 {
 public:
@@ -13,6 +15,8 @@ public:
 
     bool on_create() override
     {
+        gli::set_memory_budget("transcript", 1024 * 1024);
+
         if (!fs.read_entire_file(storyfile.c_str(), story_data))
         {
             return false;
@@ -75,7 +79,12 @@ public:
 
     bool on_update(float delta) override
     {
-        ZMachine::State state = zm.update();
+        ZMachine::State state;
+
+        {
+            GLI_PROFILE_SCOPE("ZMachine::update");
+            state = zm.update();
+        }
 
         // Process keyboard input
         // TODO: Send keypreses directly to the machine. The machine can handle building up the input line (will also make read_char easy).
@@ -90,6 +99,14 @@ public:
                 gli::logf("User input: %s\n", input_buffer.c_str());
                 input_buffer.clear();
             }
+            else if (event.key == gli::Key_F6)
+            {
+                // Once per press, not again on the release
+                if (event.event == gli::Pressed)
+                {
+                    gli::memory_report();
+                }
+            }
             else if (event.ascii_code)
             {
                 input_buffer.push_back(event.ascii_code);
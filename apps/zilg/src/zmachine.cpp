@@ -1112,6 +1112,8 @@ void ZMachine::parse(uint16_t text_buffer, uint16_t parse_buffer)
 
 void ZMachine::flush_line()
 {
+    GLI_MEMORY_TAG("transcript");
+
     std::string line;
     while (std::getline(_linebuffer, line))
     {
@@ -1684,7 +1686,12 @@ void ZMachine::_sread(ZInstruction& instruction)
         uint16_t parse_buffer = instruction.operands[1];
         std::string user_input = _user_input.front();
         _user_input.pop_front();
-        _transcript.back() += user_input;
+
+        {
+            GLI_MEMORY_TAG("transcript");
+            _transcript.back() += user_input;
+        }
+
         uint8_t buffer_len = read(text_buffer);
         std::transform(user_input.begin(), user_input.end(), user_input.begin(), [](unsigned char c) { return std::tolower(c); });
         std::strncpy((char*)(_memory + text_buffer + 1), user_input.c_str(), buffer_len);
@@ -2,8 +2,17 @@
 
 #include "gli_types.h"
 #include "gli_core.h"
+#include "gli_asset_loader.h"
+#include "gli_atlas.h"
 #include "gli_debug.h"
 #include "gli_file.h"
+#include "gli_font.h"
+#include "gli_job.h"
+#include "gli_layer.h"
+#include "gli_light.h"
 #include "gli_log.h"
+#include "gli_memory.h"
+#include "gli_profile.h"
 #include "gli_sprite.h"
+#include "gli_surface.h"
 #include "gli_audio.h"
@@ -0,0 +1,128 @@
+#include "gli_asset_loader.h"
+
+#include "gli_audio.h"
+#include "gli_debug.h"
+#include "gli_log.h"
+#include "gli_sprite.h"
+
+#include <algorithm>
+
+namespace gli
+{
+
+AssetLoader::~AssetLoader()
+{
+    wait();
+}
+
+
+void AssetLoader::add(const std::string& name, LoadFunc load)
+{
+    gliAssert(m_counter.done());
+    m_loads.push_back({ name, std::move(load), false, 0, 0.0, 0.0 });
+}
+
+
+void AssetLoader::add(const std::string& path, Sprite& sprite, bool build_runs)
+{
+    add(path, [path, &sprite, build_runs]() {
+        if (!sprite.load(path))
+        {
+            return false;
+        }
+
+        if (build_runs)
+        {
+            sprite.build_runs();
+        }
+
+        return true;
+    });
+}
+
+
+#ifndef GLI_HEADLESS
+void AssetLoader::add(const std::string& path, WaveForm& wave)
+{
+    add(path, [path, &wave]() { return wave.load(path); });
+}
+#endif
+
+
+void AssetLoader::start()
+{
+    if (m_started == 0)
+    {
+        m_start_time = std::chrono::steady_clock::now();
+    }
+
+    for (; m_started < m_loads.size(); ++m_started)
+    {
+        Load* load = &m_loads[m_started];
+        JobSystem::get()->run([this, load]() { run(*load); }, &m_counter);
+    }
+}
+
+
+bool AssetLoader::poll()
+{
+    if (!m_counter.done() && JobSystem::get()->worker_count() == 0)
+    {
+        wait();
+    }
+
+    return m_counter.done();
+}
+
+
+void AssetLoader::wait()
+{
+    JobSystem::get()->wait(m_counter);
+}
+
+
+void AssetLoader::run(Load& load)
+{
+    using Ms = std::chrono::duration<double, std::milli>;
+
+    load.thread = JobSystem::get()->thread_index();
+    load.start_ms = Ms(std::chrono::steady_clock::now() - m_start_time).count();
+    load.succeeded = load.func();
+    load.end_ms = Ms(std::chrono::steady_clock::now() - m_start_time).count();
+
+    if (!load.succeeded)
+    {
+        gliLog(LogLevel::Error, "Assets", "AssetLoader::run", "Failed to load %s.", load.name.c_str());
+        m_failed.store(true, std::memory_order_release);
+    }
+
+    m_finished.fetch_add(1, std::memory_order_acq_rel);
+}
+
+
+void AssetLoader::report() const
+{
+    std::vector<const Load*> loads;
+    double total_ms = 0.0;
+    double elapsed_ms = 0.0;
+
+    for (size_t i = 0; i < m_started; ++i)
+    {
+        loads.push_back(&m_loads[i]);
+        total_ms += m_loads[i].end_ms - m_loads[i].start_ms;
+        elapsed_ms = std::max(elapsed_ms, m_loads[i].end_ms);
+    }
+
+    std::sort(loads.begin(), loads.end(), [](const Load* a, const Load* b) { return a->end_ms - a->start_ms > b->end_ms - b->start_ms; });
+
+    for (const Load* load : loads)
+    {
+        gliLog(LogLevel::Info, "Assets", "AssetLoader::report", "%8.2f ms  thread %d  %s%s", load->end_ms - load->start_ms, load->thread,
+               load->name.c_str(), load->succeeded ? "" : " (failed)");
+    }
+
+    gliLog(LogLevel::Info, "Assets", "AssetLoader::report", "%d assets loaded in %.2f ms, %.2f ms of loading across %d threads.",
+           (int)loads.size(), elapsed_ms, total_ms, JobSystem::get()->worker_count() + 1);
+}
+
+} // namespace gli
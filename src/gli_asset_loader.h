@@ -0,0 +1,72 @@
+#pragma once
+
+#include "gli_job.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace gli
+{
+
+class Sprite;
+class WaveForm;
+
+// Loads assets in parallel on the JobSystem while the app keeps running frames. Queue every load, start them, then poll once a
+// frame until they're done. Each load is timed, so report can break startup down per asset.
+class AssetLoader
+{
+public:
+    using LoadFunc = std::function<bool()>;
+
+    AssetLoader() = default;
+    AssetLoader(const AssetLoader&) = delete;
+    ~AssetLoader();
+
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // Loads run on any thread and in any order, so each one should only touch its own asset. name is for the report and errors.
+    void add(const std::string& name, LoadFunc load);
+    void add(const std::string& path, Sprite& sprite, bool build_runs = true);
+#ifndef GLI_HEADLESS
+    void add(const std::string& path, WaveForm& wave); // Audio is Win32 only
+#endif
+
+    // Starts everything queued so far. Queue more only once they're done.
+    void start();
+
+    // True once every load has finished. Without JobSystem workers the loads run here instead, all at once.
+    bool poll();
+    void wait();
+
+    int count() const { return (int)m_loads.size(); }
+    int finished() const { return m_finished.load(std::memory_order_acquire); }
+    bool failed() const { return m_failed.load(std::memory_order_acquire); }
+
+    // Logs each load's time and thread, slowest first, and the time from start to the last one finishing
+    void report() const;
+
+private:
+    struct Load
+    {
+        std::string name;
+        LoadFunc func;
+        bool succeeded;
+        int thread;
+        double start_ms;
+        double end_ms;
+    };
+
+    void run(Load& load);
+
+    std::vector<Load> m_loads{};
+    size_t m_started = 0; // Loads before this have been handed to the JobSystem
+    JobCounter m_counter{};
+    std::atomic<int> m_finished{};
+    std::atomic<bool> m_failed{};
+    std::chrono::steady_clock::time_point m_start_time{};
+};
+
+} // namespace gli
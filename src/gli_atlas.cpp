@@ -0,0 +1,333 @@
+#include "gli_atlas.h"
+
+#include "gli_debug.h"
+#include "gli_file.h"
+#include "gli_log.h"
+
+#include <stb/stb_image_write.h>
+#include <stb/stb_rect_pack.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace gli
+{
+
+static const char AtlasMagic[4] = { 'G', 'L', 'I', 'A' };
+static const uint16_t AtlasVersion = 1;
+
+// Followed by page_count pairs of uint16_t page sizes, then for each handle its AtlasHandle, a uint16_t name length and the name
+struct AtlasHeader
+{
+    char magic[4];
+    uint16_t version;
+    uint16_t page_count;
+    uint32_t handle_count;
+};
+
+
+static std::string page_path(const std::string& path, int page)
+{
+    size_t dot = path.find_last_of('.');
+    size_t slash = path.find_last_of("/\\");
+    std::string stem = dot != std::string::npos && (slash == std::string::npos || dot > slash) ? path.substr(0, dot) : path;
+    return stem + "_" + std::to_string(page) + ".png";
+}
+
+
+SpriteAtlas::SpriteAtlas(int page_size, int padding) : m_page_size(page_size), m_padding(padding)
+{
+    gliAssert(page_size > 0 && page_size <= 0xFFFF && padding >= 0);
+}
+
+
+int SpriteAtlas::add(const std::string& name, const Sprite& sprite)
+{
+    Sprite copy(sprite.width(), sprite.height());
+
+    for (int y = 0; y < sprite.height(); ++y)
+    {
+        memcpy(copy.pixels() + y * copy.stride(), sprite.pixels() + y * sprite.stride(), sprite.width() * sizeof(Pixel));
+    }
+
+    return add(name, std::move(copy));
+}
+
+
+int SpriteAtlas::add(const std::string& name, Sprite&& sprite)
+{
+    int index = (int)m_handles.size();
+    m_images.push_back(std::move(sprite));
+    m_names.push_back(name);
+    m_lookup[name] = index;
+    m_handles.push_back({});
+    return index;
+}
+
+
+int SpriteAtlas::add_file(const std::string& path)
+{
+    Sprite sprite;
+
+    if (!sprite.load(path))
+    {
+        gliLog(LogLevel::Error, "Atlas", "SpriteAtlas::add_file", "Failed to load %s.", path.c_str());
+        return -1;
+    }
+
+    return add(path, std::move(sprite));
+}
+
+
+bool SpriteAtlas::pack()
+{
+    gliAssert(m_pages.empty());
+
+    std::vector<stbrp_rect> rects(m_images.size());
+    std::vector<stbrp_node> nodes(m_page_size);
+
+    for (size_t i = 0; i < m_images.size(); ++i)
+    {
+        rects[i].id = (int)i;
+        rects[i].w = (stbrp_coord)(m_images[i].width() + m_padding);
+        rects[i].h = (stbrp_coord)(m_images[i].height() + m_padding);
+
+        if (m_images[i].width() + m_padding > m_page_size || m_images[i].height() + m_padding > m_page_size)
+        {
+            gliLog(LogLevel::Error, "Atlas", "SpriteAtlas::pack", "%s doesn't fit on a %dx%d page.", m_names[i].c_str(), m_page_size,
+                   m_page_size);
+            return false;
+        }
+    }
+
+    // Fill a page, then retry whatever didn't fit on the next one. stbrp_pack_rects keeps the rects in order.
+    while (!rects.empty())
+    {
+        stbrp_context context;
+        stbrp_init_target(&context, m_page_size, m_page_size, nodes.data(), (int)nodes.size());
+        stbrp_pack_rects(&context, rects.data(), (int)rects.size());
+
+        uint16_t page = (uint16_t)m_pages.size();
+        int page_w = 0;
+        int page_h = 0;
+        int packed = 0;
+
+        for (const stbrp_rect& rect : rects)
+        {
+            if (rect.was_packed)
+            {
+                const Sprite& image = m_images[rect.id];
+                m_handles[rect.id] = { page, (uint16_t)rect.x, (uint16_t)rect.y, (uint16_t)image.width(), (uint16_t)image.height() };
+                page_w = std::max(page_w, rect.x + image.width());
+                page_h = std::max(page_h, rect.y + image.height());
+                ++packed;
+            }
+        }
+
+        if (packed == 0)
+        {
+            gliLog(LogLevel::Error, "Atlas", "SpriteAtlas::pack", "%s couldn't be packed.", m_names[rects[0].id].c_str());
+            return false;
+        }
+
+        // Trimmed to what's used and transparent between the images
+        Sprite sprite(page_w, page_h);
+        std::fill_n(sprite.pixels(), sprite.stride() * page_h, Pixel(0u));
+
+        for (const stbrp_rect& rect : rects)
+        {
+            if (rect.was_packed)
+            {
+                const Sprite& image = m_images[rect.id];
+
+                for (int y = 0; y < image.height(); ++y)
+                {
+                    memcpy(sprite.pixels() + rect.x + (rect.y + y) * sprite.stride(), image.pixels() + y * image.stride(),
+                           image.width() * sizeof(Pixel));
+                }
+            }
+        }
+
+        sprite.build_runs();
+        m_pages.push_back(std::move(sprite));
+
+        rects.erase(std::remove_if(rects.begin(), rects.end(), [](const stbrp_rect& rect) { return rect.was_packed != 0; }),
+                    rects.end());
+    }
+
+    m_images.clear();
+    m_images.shrink_to_fit();
+    return true;
+}
+
+
+bool SpriteAtlas::save(const std::string& path) const
+{
+    std::vector<uint8_t> rgba;
+
+    for (int i = 0; i < page_count(); ++i)
+    {
+        const Sprite& sprite = m_pages[i];
+        rgba.resize((size_t)sprite.width() * sprite.height() * 4);
+        uint8_t* out = rgba.data();
+
+        for (int y = 0; y < sprite.height(); ++y)
+        {
+            const Pixel* p = sprite.pixels() + y * sprite.stride();
+
+            for (int x = 0; x < sprite.width(); ++x, ++p)
+            {
+                *out++ = p->r;
+                *out++ = p->g;
+                *out++ = p->b;
+                *out++ = p->a;
+            }
+        }
+
+        std::string file = page_path(path, i);
+
+        if (!stbi_write_png(file.c_str(), sprite.width(), sprite.height(), 4, rgba.data(), sprite.width() * 4))
+        {
+            gliLog(LogLevel::Error, "Atlas", "SpriteAtlas::save", "Failed to write %s.", file.c_str());
+            return false;
+        }
+    }
+
+    FILE* file = fopen(path.c_str(), "wb");
+
+    if (!file)
+    {
+        gliLog(LogLevel::Error, "Atlas", "SpriteAtlas::save", "Failed to open %s.", path.c_str());
+        return false;
+    }
+
+    AtlasHeader header{};
+    memcpy(header.magic, AtlasMagic, sizeof(AtlasMagic));
+    header.version = AtlasVersion;
+    header.page_count = (uint16_t)m_pages.size();
+    header.handle_count = (uint32_t)m_handles.size();
+    fwrite(&header, sizeof(header), 1, file);
+
+    for (const Sprite& sprite : m_pages)
+    {
+        uint16_t size[2] = { (uint16_t)sprite.width(), (uint16_t)sprite.height() };
+        fwrite(size, sizeof(size), 1, file);
+    }
+
+    for (size_t i = 0; i < m_handles.size(); ++i)
+    {
+        uint16_t length = (uint16_t)m_names[i].size();
+        fwrite(&m_handles[i], sizeof(AtlasHandle), 1, file);
+        fwrite(&length, sizeof(length), 1, file);
+        fwrite(m_names[i].data(), length, 1, file);
+    }
+
+    bool written = ferror(file) == 0;
+    fclose(file);
+    return written;
+}
+
+
+bool SpriteAtlas::load(const std::string& path)
+{
+    std::vector<uint8_t> contents;
+
+    if (!FileSystem::get()->read_entire_file(path.c_str(), contents))
+    {
+        gliLog(LogLevel::Error, "Atlas", "SpriteAtlas::load", "Failed to read %s.", path.c_str());
+        return false;
+    }
+
+    const uint8_t* in = contents.data();
+    const uint8_t* end = in + contents.size();
+
+    auto get = [&in, end](void* data, size_t size) {
+        if ((size_t)(end - in) < size)
+        {
+            return false;
+        }
+
+        memcpy(data, in, size);
+        in += size;
+        return true;
+    };
+
+    AtlasHeader header{};
+
+    if (!get(&header, sizeof(header)) || memcmp(header.magic, AtlasMagic, sizeof(AtlasMagic)) != 0 || header.version != AtlasVersion)
+    {
+        gliLog(LogLevel::Error, "Atlas", "SpriteAtlas::load", "%s is not an atlas from this version.", path.c_str());
+        return false;
+    }
+
+    std::vector<Sprite> pages(header.page_count);
+    std::vector<AtlasHandle> handles(header.handle_count);
+    std::vector<std::string> names(header.handle_count);
+
+    for (int i = 0; i < header.page_count; ++i)
+    {
+        uint16_t size[2];
+        std::string file = page_path(path, i);
+
+        if (!get(size, sizeof(size)) || !pages[i].load(file) || pages[i].width() != size[0] || pages[i].height() != size[1])
+        {
+            gliLog(LogLevel::Error, "Atlas", "SpriteAtlas::load", "Page %s is missing or doesn't match %s.", file.c_str(), path.c_str());
+            return false;
+        }
+
+        pages[i].build_runs();
+    }
+
+    for (uint32_t i = 0; i < header.handle_count; ++i)
+    {
+        uint16_t length;
+
+        if (!get(&handles[i], sizeof(AtlasHandle)) || !get(&length, sizeof(length)) || (size_t)(end - in) < length)
+        {
+            gliLog(LogLevel::Error, "Atlas", "SpriteAtlas::load", "%s is truncated.", path.c_str());
+            return false;
+        }
+
+        names[i].assign((const char*)in, length);
+        in += length;
+
+        const AtlasHandle& handle = handles[i];
+
+        if (handle.page >= header.page_count || handle.x + handle.w > pages[handle.page].width() ||
+            handle.y + handle.h > pages[handle.page].height())
+        {
+            gliLog(LogLevel::Error, "Atlas", "SpriteAtlas::load", "%s in %s is outside its page.", names[i].c_str(), path.c_str());
+            return false;
+        }
+    }
+
+    m_images.clear();
+    m_pages = std::move(pages);
+    m_handles = std::move(handles);
+    m_names = std::move(names);
+    m_lookup.clear();
+
+    for (size_t i = 0; i < m_names.size(); ++i)
+    {
+        m_lookup[m_names[i]] = (int)i;
+    }
+
+    return true;
+}
+
+
+bool SpriteAtlas::find(const std::string& name, AtlasHandle& handle) const
+{
+    auto it = m_lookup.find(name);
+
+    if (it == m_lookup.end())
+    {
+        return false;
+    }
+
+    handle = m_handles[it->second];
+    return true;
+}
+
+} // namespace gli
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "gli_sprite.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gli
+{
+
+// Where a packed image ended up: a rectangle on one of the atlas pages
+struct AtlasHandle
+{
+    uint16_t page;
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+};
+
+// Packs many small images onto a few large pages, so drawing them touches a few sprites instead of one each. Add everything,
+// then pack once; handles are numbered in the order images were added and can also be looked up by name. save writes the pages
+// and a manifest so a build step can pack ahead of time and the game only loads the result.
+class SpriteAtlas
+{
+public:
+    explicit SpriteAtlas(int page_size = 1024, int padding = 1);
+    SpriteAtlas(const SpriteAtlas&) = delete;
+
+    SpriteAtlas& operator=(const SpriteAtlas&) = delete;
+
+    // All return the handle index, or -1 if the image couldn't be loaded. add_file names the image after its path.
+    int add(const std::string& name, const Sprite& sprite);
+    int add(const std::string& name, Sprite&& sprite);
+    int add_file(const std::string& path);
+
+    // Packs the added images onto as many pages as they need and frees the copies add made. Fails if an image is larger than a page.
+    bool pack();
+
+    // Writes path, and the pages next to it as <path without extension>_0.png, _1.png and so on
+    bool save(const std::string& path) const;
+
+    // Replaces the atlas with one written by save, read through the FileSystem. Fails and leaves the atlas as it was if a page is
+    // missing or the wrong size, or a handle doesn't lie inside its page.
+    bool load(const std::string& path);
+
+    int handle_count() const { return (int)m_handles.size(); }
+    AtlasHandle handle(int index) const { return m_handles[index]; }
+    bool find(const std::string& name, AtlasHandle& handle) const;
+
+    int page_count() const { return (int)m_pages.size(); }
+    const Sprite& page(int index) const { return m_pages[index]; }
+    const Sprite& page(AtlasHandle handle) const { return m_pages[handle.page]; }
+
+private:
+    int m_page_size;
+    int m_padding;
+    std::vector<Sprite> m_images{}; // Waiting to be packed, in handle order
+    std::vector<std::string> m_names{};
+    std::unordered_map<std::string, int> m_lookup{};
+    std::vector<AtlasHandle> m_handles{};
+    std::vector<Sprite> m_pages{};
+};
+
+} // namespace gli
@@ -734,16 +734,21 @@ void SubMix::reset() {}
 size_t SubMix::read(float* data, size_t num_frames)
 {
     memset(data, 0, num_frames * num_channels() * sizeof(float));
-    std::vector<float> temp(num_frames * num_channels());
+
+    // Only ever grows, so the audio thread stops allocating once it has seen its largest buffer
+    if (_scratch.size() < num_frames * num_channels())
+    {
+        _scratch.resize(num_frames * num_channels());
+    }
 
     for (auto itr = _inputs.begin(); itr != _inputs.end();)
     {
-        size_t frames_read = (*itr)->read(&temp[0], num_frames);
+        size_t frames_read = (*itr)->read(_scratch.data(), num_frames);
 
         if ((*itr)->num_channels() == 2)
         {
             float fade = (*itr)->get_fade();
-            float* src = &temp[0];
+            float* src = _scratch.data();
             float* dest = data;
 
             for (size_t f = 0; f < frames_read; ++f)
@@ -761,7 +766,7 @@ size_t SubMix::read(float* data, size_t num_frames)
         {
             static const float half_sqrt2 = 0.70710678f;
             float fade = (*itr)->get_fade() * half_sqrt2;
-            float* src = &temp[0];
+            float* src = _scratch.data();
             float* dest = data;
 
             for (size_t f = 0; f < frames_read; ++f)
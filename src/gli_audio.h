@@ -113,6 +113,7 @@ public:
 
 protected:
     std::vector<std::unique_ptr<AudioSource>> _inputs;
+    std::vector<float> _scratch; // Each input is read into this before it's mixed
 };
 
 
@@ -0,0 +1,287 @@
+#include "gli_blend_simd.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+namespace gli
+{
+
+namespace
+{
+
+struct Sse2
+{
+    using Vec = __m128i;
+    using FVec = __m128;
+    static const int Width = 4;
+
+    static Vec load(const Pixel* p) { return _mm_loadu_si128((const __m128i*)p); }
+    static void store(Pixel* p, Vec v) { _mm_storeu_si128((__m128i*)p, v); }
+    static Vec zero() { return _mm_setzero_si128(); }
+    static Vec set1_64(uint64_t v) { return _mm_set1_epi64x((long long)v); }
+    static Vec set1_32(uint32_t v) { return _mm_set1_epi32((int)v); }
+    static Vec set1_16(uint16_t v) { return _mm_set1_epi16((short)v); }
+    static Vec and_(Vec a, Vec b) { return _mm_and_si128(a, b); }
+    static Vec andnot(Vec a, Vec b) { return _mm_andnot_si128(a, b); }
+    static Vec or_(Vec a, Vec b) { return _mm_or_si128(a, b); }
+    static Vec unpacklo_8(Vec a, Vec b) { return _mm_unpacklo_epi8(a, b); }
+    static Vec unpackhi_8(Vec a, Vec b) { return _mm_unpackhi_epi8(a, b); }
+    static Vec unpacklo_16(Vec a, Vec b) { return _mm_unpacklo_epi16(a, b); }
+    static Vec unpackhi_16(Vec a, Vec b) { return _mm_unpackhi_epi16(a, b); }
+    static Vec packus_16(Vec a, Vec b) { return _mm_packus_epi16(a, b); }
+    static Vec packs_32(Vec a, Vec b) { return _mm_packs_epi32(a, b); }
+    static Vec adds_u16(Vec a, Vec b) { return _mm_adds_epu16(a, b); }
+    static Vec subs_u16(Vec a, Vec b) { return _mm_subs_epu16(a, b); }
+    static Vec sub_16(Vec a, Vec b) { return _mm_sub_epi16(a, b); }
+    static Vec mullo_16(Vec a, Vec b) { return _mm_mullo_epi16(a, b); }
+    static Vec mulhi_u16(Vec a, Vec b) { return _mm_mulhi_epu16(a, b); }
+    static Vec broadcast_alpha(Vec v) { return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xFF), 0xFF); }
+
+    template <int N>
+    static Vec srli_16(Vec v) { return _mm_srli_epi16(v, N); }
+
+    static FVec set1_f(float v) { return _mm_set1_ps(v); }
+    static FVec add_f(FVec a, FVec b) { return _mm_add_ps(a, b); }
+    static FVec sub_f(FVec a, FVec b) { return _mm_sub_ps(a, b); }
+    static FVec mul_f(FVec a, FVec b) { return _mm_mul_ps(a, b); }
+    static FVec div_f(FVec a, FVec b) { return _mm_div_ps(a, b); }
+    static FVec min_f(FVec a, FVec b) { return _mm_min_ps(a, b); }
+    static FVec max_f(FVec a, FVec b) { return _mm_max_ps(a, b); }
+    static FVec to_float(Vec v) { return _mm_cvtepi32_ps(v); }
+    static Vec truncate(FVec v) { return _mm_cvttps_epi32(v); }
+};
+
+} // namespace
+
+
+static void cpuid(int info[4], int leaf, int subleaf)
+{
+#ifdef _MSC_VER
+    __cpuidex(info, leaf, subleaf);
+#else
+    __cpuid_count(leaf, subleaf, info[0], info[1], info[2], info[3]);
+#endif
+}
+
+
+static uint64_t xgetbv(uint32_t index)
+{
+#ifdef _MSC_VER
+    return _xgetbv(index);
+#else
+    uint32_t eax, edx;
+    __asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
+    return ((uint64_t)edx << 32) | eax;
+#endif
+}
+
+
+static bool cpu_has_avx2()
+{
+    int info[4];
+    cpuid(info, 0, 0);
+
+    if (info[0] < 7)
+    {
+        return false;
+    }
+
+    // AVX and OSXSAVE, and the OS saves the YMM registers
+    cpuid(info, 1, 0);
+
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (xgetbv(0) & 0x6) != 0x6)
+    {
+        return false;
+    }
+
+    cpuid(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+}
+
+
+// Whether the public functions take the AVX2 paths, the CPU's answer unless set_blend_isa says otherwise
+static bool& use_avx2()
+{
+    static bool avx2 = cpu_has_avx2();
+    return avx2;
+}
+
+
+bool set_blend_isa(BlendIsa isa)
+{
+    if (isa == Isa_Avx2 && !cpu_has_avx2())
+    {
+        return false;
+    }
+
+    use_avx2() = isa == Isa_Avx2;
+    return true;
+}
+
+
+BlendIsa get_blend_isa()
+{
+    return use_avx2() ? Isa_Avx2 : Isa_Sse2;
+}
+
+
+void fill_pixels(Pixel* dest, Pixel p, int count)
+{
+    __m128i color = _mm_set1_epi32((int)p.argb);
+    int i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        _mm_storeu_si128((__m128i*)(dest + i), color);
+        _mm_storeu_si128((__m128i*)(dest + i + 4), color);
+    }
+
+    for (; i < count; ++i)
+    {
+        dest[i] = p;
+    }
+}
+
+
+void expand_mask(Pixel* dest, uint32_t mask, int count, Pixel fg, Pixel bg)
+{
+    __m128i vfg = _mm_set1_epi32((int)fg.argb);
+    __m128i vbg = _mm_set1_epi32((int)bg.argb);
+    __m128i bits = _mm_set_epi32(8, 4, 2, 1);
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4, mask >>= 4)
+    {
+        __m128i select = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32((int)mask), bits), bits);
+        _mm_storeu_si128((__m128i*)(dest + i), _mm_or_si128(_mm_and_si128(select, vfg), _mm_andnot_si128(select, vbg)));
+    }
+
+    for (; i < count; ++i, mask >>= 1)
+    {
+        dest[i] = (mask & 1) ? fg : bg;
+    }
+}
+
+
+void expand_mask(uint8_t* dest, uint32_t mask, int count, uint8_t fg, uint8_t bg)
+{
+    __m128i vfg = _mm_set1_epi8((char)fg);
+    __m128i vbg = _mm_set1_epi8((char)bg);
+    __m128i bits = _mm_set1_epi64x(0x8040201008040201);
+    int i = 0;
+
+    for (; i + 16 <= count; i += 16, mask >>= 16)
+    {
+        // Byte n of the low half tests bit n of the mask, byte n of the high half tests bit n + 8
+        __m128i spread = _mm_set_epi64x(0x0101010101010101 * ((mask >> 8) & 0xFF), 0x0101010101010101 * (mask & 0xFF));
+        __m128i select = _mm_cmpeq_epi8(_mm_and_si128(spread, bits), bits);
+        _mm_storeu_si128((__m128i*)(dest + i), _mm_or_si128(_mm_and_si128(select, vfg), _mm_andnot_si128(select, vbg)));
+    }
+
+    for (; i < count; ++i, mask >>= 1)
+    {
+        dest[i] = (mask & 1) ? fg : bg;
+    }
+}
+
+
+void stream_pixels(Pixel* dest, Pixel p, int count)
+{
+    __m128i color = _mm_set1_epi32((int)p.argb);
+
+    // Streaming stores need 16 byte alignment
+    while (count > 0 && ((uintptr_t)dest & 15))
+    {
+        *dest++ = p;
+        --count;
+    }
+
+    for (; count >= 8; count -= 8, dest += 8)
+    {
+        _mm_stream_si128((__m128i*)dest, color);
+        _mm_stream_si128((__m128i*)(dest + 4), color);
+    }
+
+    while (count-- > 0)
+    {
+        *dest++ = p;
+    }
+
+    _mm_sfence();
+}
+
+
+void blend_straight(Pixel* dest, const Pixel* src, int count, uint8_t alpha)
+{
+    if (use_avx2())
+    {
+        blend_straight_avx2(dest, src, count, alpha);
+    }
+    else
+    {
+        blend_straight_span<Sse2>(dest, src, count, alpha);
+    }
+}
+
+
+void blend_premultiplied(Pixel* dest, const Pixel* src, int count, uint8_t alpha)
+{
+    if (use_avx2())
+    {
+        blend_premultiplied_avx2(dest, src, count, alpha);
+    }
+    else
+    {
+        blend_premultiplied_span<Sse2>(dest, src, count, alpha);
+    }
+}
+
+
+void scale_pixels(Pixel* dest, const Pixel* src, int count, uint16_t factor)
+{
+    if (use_avx2())
+    {
+        scale_pixels_avx2(dest, src, count, factor);
+    }
+    else
+    {
+        scale_span<Sse2>(dest, src, count, factor);
+    }
+}
+
+
+void sample_nearest(Pixel* dest, const Pixel* src, int stride, int u, int v, int du, int dv, int count)
+{
+    if (use_avx2())
+    {
+        sample_nearest_avx2(dest, src, stride, u, v, du, dv, count);
+    }
+    else
+    {
+        sample_nearest_scalar(dest, src, stride, u, v, du, dv, count);
+    }
+}
+
+
+void sample_bilinear(Pixel* dest, const Pixel* src, int stride, int width, int height, int u, int v, int du, int dv, int count)
+{
+    if (use_avx2())
+    {
+        sample_bilinear_avx2(dest, src, stride, width, height, u, v, du, dv, count);
+    }
+    else
+    {
+        sample_bilinear_scalar(dest, src, stride, width, height, u, v, du, dv, count);
+    }
+}
+
+
+BlendKernel get_blend_kernel(BlendMode src_blend, BlendMode dest_blend, BlendOp op)
+{
+    return use_avx2() ? get_blend_kernel_avx2(src_blend, dest_blend, op) : select_kernel<Sse2>(src_blend, dest_blend, op);
+}
+
+} // namespace gli
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "gli_core.h" // for gli::Pixel, gli::BlendMode, gli::BlendOp, gli::BlendKernel
+
+namespace gli
+{
+
+enum BlendIsa
+{
+    Isa_Sse2,
+    Isa_Avx2
+};
+
+// Forces the instruction set the functions below use, so both paths can be tested on one machine. Returns false and changes
+// nothing if the CPU doesn't support it. Kernels already returned by get_blend_kernel keep the one they were built for.
+bool set_blend_isa(BlendIsa isa);
+BlendIsa get_blend_isa();
+
+// Returns the precompiled span kernels for a blend state. Kernels use SSE2, or AVX2 when the CPU supports it.
+BlendKernel get_blend_kernel(BlendMode src_blend, BlendMode dest_blend, BlendOp op);
+
+// Fill count pixels with a solid color
+void fill_pixels(Pixel* dest, Pixel p, int count);
+
+// Write count pixels, pixel n is fg if bit n of mask is set and bg otherwise (count <= 32)
+void expand_mask(Pixel* dest, uint32_t mask, int count, Pixel fg, Pixel bg);
+void expand_mask(uint8_t* dest, uint32_t mask, int count, uint8_t fg, uint8_t bg);
+
+// Draw count pixels over dest with their alpha scaled by alpha / 255, leaving dest opaque. Within 1 of the float blend
+// blend_partial_sprite used to do.
+void blend_straight(Pixel* dest, const Pixel* src, int count, uint8_t alpha);
+
+// Draw count premultiplied pixels over dest with their alpha scaled by alpha / 255, leaving dest opaque
+void blend_premultiplied(Pixel* dest, const Pixel* src, int count, uint8_t alpha);
+
+// dest = src with r, g and b multiplied by factor / 256, rounded down and saturated. Alpha is copied. dest may be src.
+void scale_pixels(Pixel* dest, const Pixel* src, int count, uint16_t factor);
+
+// Sample count pixels along a line through an image of width x height pixels, starting at (u, v) and stepping by (du, dv), in
+// 16.16 fixed point. Every sample must land inside the image. Bilinear filtering weighs the four texels around each sample with
+// 8 bit weights, clamped to the image's edges. Uses AVX2 gathers when the CPU supports them.
+void sample_nearest(Pixel* dest, const Pixel* src, int stride, int u, int v, int du, int dv, int count);
+void sample_bilinear(Pixel* dest, const Pixel* src, int stride, int width, int height, int u, int v, int du, int dv, int count);
+
+// Same as fill_pixels using non-temporal stores, for fills large enough that they'd just evict everything else from the cache
+void stream_pixels(Pixel* dest, Pixel p, int count);
+
+} // namespace gli
@@ -0,0 +1,182 @@
+// The AVX2 kernels. This is the only file built with AVX2 enabled (/arch:AVX2, -mavx2), gli_blend.cpp only calls into it once it
+// has checked the CPU supports it.
+
+#include "gli_blend_simd.h"
+
+namespace gli
+{
+
+namespace
+{
+
+struct Avx2
+{
+    using Vec = __m256i;
+    using FVec = __m256;
+    static const int Width = 8;
+
+    static Vec load(const Pixel* p) { return _mm256_loadu_si256((const __m256i*)p); }
+    static void store(Pixel* p, Vec v) { _mm256_storeu_si256((__m256i*)p, v); }
+    static Vec zero() { return _mm256_setzero_si256(); }
+    static Vec set1_64(uint64_t v) { return _mm256_set1_epi64x((long long)v); }
+    static Vec set1_32(uint32_t v) { return _mm256_set1_epi32((int)v); }
+    static Vec set1_16(uint16_t v) { return _mm256_set1_epi16((short)v); }
+    static Vec and_(Vec a, Vec b) { return _mm256_and_si256(a, b); }
+    static Vec andnot(Vec a, Vec b) { return _mm256_andnot_si256(a, b); }
+    static Vec or_(Vec a, Vec b) { return _mm256_or_si256(a, b); }
+    static Vec unpacklo_8(Vec a, Vec b) { return _mm256_unpacklo_epi8(a, b); }
+    static Vec unpackhi_8(Vec a, Vec b) { return _mm256_unpackhi_epi8(a, b); }
+    static Vec unpacklo_16(Vec a, Vec b) { return _mm256_unpacklo_epi16(a, b); }
+    static Vec unpackhi_16(Vec a, Vec b) { return _mm256_unpackhi_epi16(a, b); }
+    static Vec packus_16(Vec a, Vec b) { return _mm256_packus_epi16(a, b); }
+    static Vec packs_32(Vec a, Vec b) { return _mm256_packs_epi32(a, b); }
+    static Vec adds_u16(Vec a, Vec b) { return _mm256_adds_epu16(a, b); }
+    static Vec subs_u16(Vec a, Vec b) { return _mm256_subs_epu16(a, b); }
+    static Vec sub_16(Vec a, Vec b) { return _mm256_sub_epi16(a, b); }
+    static Vec mullo_16(Vec a, Vec b) { return _mm256_mullo_epi16(a, b); }
+    static Vec mulhi_u16(Vec a, Vec b) { return _mm256_mulhi_epu16(a, b); }
+    static Vec broadcast_alpha(Vec v) { return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(v, 0xFF), 0xFF); }
+
+    template <int N>
+    static Vec srli_16(Vec v) { return _mm256_srli_epi16(v, N); }
+
+    static FVec set1_f(float v) { return _mm256_set1_ps(v); }
+    static FVec add_f(FVec a, FVec b) { return _mm256_add_ps(a, b); }
+    static FVec sub_f(FVec a, FVec b) { return _mm256_sub_ps(a, b); }
+    static FVec mul_f(FVec a, FVec b) { return _mm256_mul_ps(a, b); }
+    static FVec div_f(FVec a, FVec b) { return _mm256_div_ps(a, b); }
+    static FVec min_f(FVec a, FVec b) { return _mm256_min_ps(a, b); }
+    static FVec max_f(FVec a, FVec b) { return _mm256_max_ps(a, b); }
+    static FVec to_float(Vec v) { return _mm256_cvtepi32_ps(v); }
+    static Vec truncate(FVec v) { return _mm256_cvttps_epi32(v); }
+
+    // For the samplers, which have no SSE2 version
+    static Vec gather(const Pixel* base, Vec index) { return _mm256_i32gather_epi32((const int*)base, index, 4); }
+    static Vec add_32(Vec a, Vec b) { return _mm256_add_epi32(a, b); }
+    static Vec sub_32(Vec a, Vec b) { return _mm256_sub_epi32(a, b); }
+    static Vec mullo_32(Vec a, Vec b) { return _mm256_mullo_epi32(a, b); }
+    static Vec min_32(Vec a, Vec b) { return _mm256_min_epi32(a, b); }
+    static Vec max_32(Vec a, Vec b) { return _mm256_max_epi32(a, b); }
+    static Vec unpacklo_32(Vec a, Vec b) { return _mm256_unpacklo_epi32(a, b); }
+    static Vec unpackhi_32(Vec a, Vec b) { return _mm256_unpackhi_epi32(a, b); }
+
+    template <int N>
+    static Vec srli_32(Vec v) { return _mm256_srli_epi32(v, N); }
+    template <int N>
+    static Vec slli_32(Vec v) { return _mm256_slli_epi32(v, N); }
+};
+
+} // namespace
+
+
+BlendKernel get_blend_kernel_avx2(BlendMode src_blend, BlendMode dest_blend, BlendOp op)
+{
+    return select_kernel<Avx2>(src_blend, dest_blend, op);
+}
+
+
+void blend_straight_avx2(Pixel* dest, const Pixel* src, int count, uint8_t alpha)
+{
+    blend_straight_span<Avx2>(dest, src, count, alpha);
+}
+
+
+void blend_premultiplied_avx2(Pixel* dest, const Pixel* src, int count, uint8_t alpha)
+{
+    blend_premultiplied_span<Avx2>(dest, src, count, alpha);
+}
+
+
+void scale_pixels_avx2(Pixel* dest, const Pixel* src, int count, uint16_t factor)
+{
+    scale_span<Avx2>(dest, src, count, factor);
+}
+
+
+void sample_nearest_avx2(Pixel* dest, const Pixel* src, int stride, int u, int v, int du, int dv, int count)
+{
+    using Vec = Avx2::Vec;
+    Vec lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    Vec vu = Avx2::add_32(Avx2::set1_32(u), Avx2::mullo_32(lanes, Avx2::set1_32(du)));
+    Vec vv = Avx2::add_32(Avx2::set1_32(v), Avx2::mullo_32(lanes, Avx2::set1_32(dv)));
+    Vec step_u = Avx2::set1_32((uint32_t)du * Avx2::Width);
+    Vec step_v = Avx2::set1_32((uint32_t)dv * Avx2::Width);
+    Vec vstride = Avx2::set1_32(stride);
+    int i = 0;
+
+    for (; i + Avx2::Width <= count; i += Avx2::Width)
+    {
+        Vec index = Avx2::add_32(Avx2::mullo_32(Avx2::srli_32<16>(vv), vstride), Avx2::srli_32<16>(vu));
+        Avx2::store(dest + i, Avx2::gather(src, index));
+        vu = Avx2::add_32(vu, step_u);
+        vv = Avx2::add_32(vv, step_v);
+    }
+
+    sample_nearest_scalar(dest + i, src, stride, u + du * i, v + dv * i, du, dv, count - i);
+}
+
+
+void sample_bilinear_avx2(Pixel* dest, const Pixel* src, int stride, int width, int height, int u, int v, int du, int dv,
+                          int count)
+{
+    using Vec = Avx2::Vec;
+    Vec zero = Avx2::zero();
+    Vec lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    Vec vu = Avx2::add_32(Avx2::set1_32(u), Avx2::mullo_32(lanes, Avx2::set1_32(du)));
+    Vec vv = Avx2::add_32(Avx2::set1_32(v), Avx2::mullo_32(lanes, Avx2::set1_32(dv)));
+    Vec step_u = Avx2::set1_32((uint32_t)du * Avx2::Width);
+    Vec step_v = Avx2::set1_32((uint32_t)dv * Avx2::Width);
+    Vec vstride = Avx2::set1_32(stride);
+    Vec half = Avx2::set1_32(0x8000);
+    Vec max_u = Avx2::set1_32((width - 1) << 16);
+    Vec max_v = Avx2::set1_32((height - 1) << 16);
+    Vec max_x = Avx2::set1_32(width - 1);
+    Vec max_y = Avx2::set1_32(height - 1);
+    Vec one = Avx2::set1_32(1);
+    Vec frac = Avx2::set1_32(0xFF);
+
+    auto lerp16 = [](Vec a, Vec b, Vec f) {
+        Vec sum = Avx2::adds_u16(Avx2::mullo_16(a, Avx2::sub_16(Avx2::set1_16(256), f)), Avx2::mullo_16(b, f));
+        return Avx2::srli_16<8>(Avx2::adds_u16(sum, Avx2::set1_16(128)));
+    };
+
+    int i = 0;
+
+    for (; i + Avx2::Width <= count; i += Avx2::Width)
+    {
+        Vec cu = Avx2::min_32(Avx2::max_32(Avx2::sub_32(vu, half), zero), max_u);
+        Vec cv = Avx2::min_32(Avx2::max_32(Avx2::sub_32(vv, half), zero), max_v);
+        Vec x0 = Avx2::srli_32<16>(cu);
+        Vec x1 = Avx2::min_32(Avx2::add_32(x0, one), max_x);
+        Vec y0 = Avx2::srli_32<16>(cv);
+        Vec row0 = Avx2::mullo_32(y0, vstride);
+        Vec row1 = Avx2::mullo_32(Avx2::min_32(Avx2::add_32(y0, one), max_y), vstride);
+        Vec p00 = Avx2::gather(src, Avx2::add_32(row0, x0));
+        Vec p01 = Avx2::gather(src, Avx2::add_32(row0, x1));
+        Vec p10 = Avx2::gather(src, Avx2::add_32(row1, x0));
+        Vec p11 = Avx2::gather(src, Avx2::add_32(row1, x1));
+
+        // Each pixel's weight repeated across its four 16 bit channels, in the order unpacklo_8 and unpackhi_8 leave the pixels
+        Vec fx = Avx2::and_(Avx2::srli_32<8>(cu), frac);
+        Vec fy = Avx2::and_(Avx2::srli_32<8>(cv), frac);
+        fx = Avx2::or_(fx, Avx2::slli_32<16>(fx));
+        fy = Avx2::or_(fy, Avx2::slli_32<16>(fy));
+        Vec fx_lo = Avx2::unpacklo_32(fx, fx);
+        Vec fx_hi = Avx2::unpackhi_32(fx, fx);
+        Vec fy_lo = Avx2::unpacklo_32(fy, fy);
+        Vec fy_hi = Avx2::unpackhi_32(fy, fy);
+
+        Vec top_lo = lerp16(Avx2::unpacklo_8(p00, zero), Avx2::unpacklo_8(p01, zero), fx_lo);
+        Vec bottom_lo = lerp16(Avx2::unpacklo_8(p10, zero), Avx2::unpacklo_8(p11, zero), fx_lo);
+        Vec top_hi = lerp16(Avx2::unpackhi_8(p00, zero), Avx2::unpackhi_8(p01, zero), fx_hi);
+        Vec bottom_hi = lerp16(Avx2::unpackhi_8(p10, zero), Avx2::unpackhi_8(p11, zero), fx_hi);
+        Avx2::store(dest + i, Avx2::packus_16(lerp16(top_lo, bottom_lo, fy_lo), lerp16(top_hi, bottom_hi, fy_hi)));
+
+        vu = Avx2::add_32(vu, step_u);
+        vv = Avx2::add_32(vv, step_v);
+    }
+
+    sample_bilinear_scalar(dest + i, src, stride, width, height, u + du * i, v + dv * i, du, dv, count - i);
+}
+
+} // namespace gli
@@ -0,0 +1,555 @@
+#pragma once
+
+// The blend kernels, written once against an instruction set wrapper (Isa) and compiled by gli_blend.cpp for SSE2 and by
+// gli_blend_avx2.cpp for AVX2. Only those two files include this. Everything here has internal linkage, so each of them gets its
+// own copy built for its own instruction set, and the linker can't swap an AVX2 copy into the SSE2 path.
+//
+// Loads and stores are unaligned. Sprite rows start aligned but spans start wherever the clipped draw does, and on the CPUs with
+// AVX an unaligned access to aligned memory costs the same as an aligned one.
+
+#include "gli_blend.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace gli
+{
+
+namespace
+{
+
+// All blend math is done in integers with factors expressed in 255ths, so 1.0 == 255. Results are rounded the same way the
+// original float code rounded them (floor(f * 255 + 0.5)). None of the exact results land on a .5 boundary, so Add and Subtract
+// match the float version bit for bit. Multiply chains four float multiplies, and the error they pick up decides the rounding of
+// a few thousand inputs per factor pair in a way no integer form reproduces, so it repeats the float math in float lanes instead.
+
+// Blend factors. Scalar versions return the factor in 255ths, SIMD versions take the source and dest alpha broadcast across each
+// pixel's 16 bit channels. The float versions compute the factor exactly as the float code did, the SIMD ones from alpha / 255.
+// Constant is scalar only: the float code used the constant unnormalized, so the factor can be as large as 255 * 255 and doesn't
+// fit the 16 bit SIMD path.
+template <BlendMode Mode>
+struct Factor;
+
+template <>
+struct Factor<BlendMode::One>
+{
+    static const bool Simd = true;
+    static int scalar(int, int, int) { return 255; }
+    static float scalar_float(int, int, int) { return 1.0f; }
+    template <typename Isa>
+    static typename Isa::Vec simd(typename Isa::Vec, typename Isa::Vec) { return Isa::set1_16(255); }
+    template <typename Isa>
+    static typename Isa::FVec simd_float(typename Isa::FVec, typename Isa::FVec) { return Isa::set1_f(1.0f); }
+};
+
+template <>
+struct Factor<BlendMode::Zero>
+{
+    static const bool Simd = true;
+    static int scalar(int, int, int) { return 0; }
+    static float scalar_float(int, int, int) { return 0.0f; }
+    template <typename Isa>
+    static typename Isa::Vec simd(typename Isa::Vec, typename Isa::Vec) { return Isa::zero(); }
+    template <typename Isa>
+    static typename Isa::FVec simd_float(typename Isa::FVec, typename Isa::FVec) { return Isa::set1_f(0.0f); }
+};
+
+template <>
+struct Factor<BlendMode::SrcAlpha>
+{
+    static const bool Simd = true;
+    static int scalar(int sa, int, int) { return sa; }
+    static float scalar_float(int sa, int, int) { return sa / 255.0f; }
+    template <typename Isa>
+    static typename Isa::Vec simd(typename Isa::Vec sa, typename Isa::Vec) { return sa; }
+    template <typename Isa>
+    static typename Isa::FVec simd_float(typename Isa::FVec sa, typename Isa::FVec) { return sa; }
+};
+
+template <>
+struct Factor<BlendMode::InvSrcAlpha>
+{
+    static const bool Simd = true;
+    static int scalar(int sa, int, int) { return 255 - sa; }
+    static float scalar_float(int sa, int, int) { return 1.0f - (sa / 255.0f); }
+    template <typename Isa>
+    static typename Isa::Vec simd(typename Isa::Vec sa, typename Isa::Vec) { return Isa::sub_16(Isa::set1_16(255), sa); }
+    template <typename Isa>
+    static typename Isa::FVec simd_float(typename Isa::FVec sa, typename Isa::FVec) { return Isa::sub_f(Isa::set1_f(1.0f), sa); }
+};
+
+template <>
+struct Factor<BlendMode::DestAlpha>
+{
+    static const bool Simd = true;
+    static int scalar(int, int da, int) { return da; }
+    static float scalar_float(int, int da, int) { return da / 255.0f; }
+    template <typename Isa>
+    static typename Isa::Vec simd(typename Isa::Vec, typename Isa::Vec da) { return da; }
+    template <typename Isa>
+    static typename Isa::FVec simd_float(typename Isa::FVec, typename Isa::FVec da) { return da; }
+};
+
+template <>
+struct Factor<BlendMode::InvDestAlpha>
+{
+    static const bool Simd = true;
+    static int scalar(int, int da, int) { return 255 - da; }
+    static float scalar_float(int, int da, int) { return 1.0f - (da / 255.0f); }
+    template <typename Isa>
+    static typename Isa::Vec simd(typename Isa::Vec, typename Isa::Vec da) { return Isa::sub_16(Isa::set1_16(255), da); }
+    template <typename Isa>
+    static typename Isa::FVec simd_float(typename Isa::FVec, typename Isa::FVec da) { return Isa::sub_f(Isa::set1_f(1.0f), da); }
+};
+
+template <>
+struct Factor<BlendMode::Constant>
+{
+    static const bool Simd = false;
+    static int scalar(int, int, int constant) { return constant * 255; }
+    static float scalar_float(int, int, int constant) { return (float)constant; }
+};
+
+
+// Rounded divide by 255 of a non-negative value, clamped to [0, 255]
+inline uint32_t resolve(int v)
+{
+    return v <= 0 ? 0 : (uint32_t)std::min((v + 127) / 255, 255);
+}
+
+
+// Same as resolve for 16 bit lanes; v is saturated to 65535 which still resolves to > 255 and packus clamps the rest
+template <typename Isa>
+inline typename Isa::Vec resolve(typename Isa::Vec v)
+{
+    v = Isa::adds_u16(v, Isa::set1_16(127));
+    return Isa::template srli_16<7>(Isa::mulhi_u16(v, Isa::set1_16(0x8081)));
+}
+
+
+// Exact floor(v / 255) for 16 bit lanes up to 255 * 255
+template <typename Isa>
+inline typename Isa::Vec floor_div255(typename Isa::Vec v)
+{
+    v = Isa::adds_u16(v, Isa::adds_u16(Isa::template srli_16<8>(v), Isa::set1_16(1)));
+    return Isa::template srli_16<8>(v);
+}
+
+
+// Blend ops combine a source and dest channel (s, d) given the source and dest alpha (sa, da). SIMD versions take 8 bit values
+// unpacked into 16 bit lanes, with the alphas broadcast across each pixel's channels.
+template <BlendOp Op>
+struct Combine;
+
+template <>
+struct Combine<BlendOp::Add>
+{
+    template <BlendMode Src, BlendMode Dest>
+    static uint32_t scalar(int s, int d, int sa, int da, int constant)
+    {
+        return resolve(s * Factor<Src>::scalar(sa, da, constant) + d * Factor<Dest>::scalar(sa, da, constant));
+    }
+
+    template <typename Isa, BlendMode Src, BlendMode Dest>
+    static typename Isa::Vec simd(typename Isa::Vec s, typename Isa::Vec d, typename Isa::Vec sa, typename Isa::Vec da)
+    {
+        typename Isa::Vec fs = Factor<Src>::template simd<Isa>(sa, da);
+        typename Isa::Vec fd = Factor<Dest>::template simd<Isa>(sa, da);
+        return resolve<Isa>(Isa::adds_u16(Isa::mullo_16(s, fs), Isa::mullo_16(d, fd)));
+    }
+};
+
+template <>
+struct Combine<BlendOp::Subtract>
+{
+    template <BlendMode Src, BlendMode Dest>
+    static uint32_t scalar(int s, int d, int sa, int da, int constant)
+    {
+        return resolve(s * Factor<Src>::scalar(sa, da, constant) - d * Factor<Dest>::scalar(sa, da, constant));
+    }
+
+    template <typename Isa, BlendMode Src, BlendMode Dest>
+    static typename Isa::Vec simd(typename Isa::Vec s, typename Isa::Vec d, typename Isa::Vec sa, typename Isa::Vec da)
+    {
+        typename Isa::Vec fs = Factor<Src>::template simd<Isa>(sa, da);
+        typename Isa::Vec fd = Factor<Dest>::template simd<Isa>(sa, da);
+        return resolve<Isa>(Isa::subs_u16(Isa::mullo_16(s, fs), Isa::mullo_16(d, fd)));
+    }
+};
+
+template <>
+struct Combine<BlendOp::Multiply>
+{
+    // s * fs * d * fd, multiplied in that order and rounded as the float code did
+    template <BlendMode Src, BlendMode Dest>
+    static uint32_t scalar(int s, int d, int sa, int da, int constant)
+    {
+        float f = s / 255.0f * Factor<Src>::scalar_float(sa, da, constant);
+        f = f * (d / 255.0f) * Factor<Dest>::scalar_float(sa, da, constant);
+        f = f < 0.0f ? 0.0f : (f > 1.0f ? 1.0f : f);
+        return (uint32_t)(f * 255.0f + 0.5f);
+    }
+
+    template <typename Isa, BlendMode Src, BlendMode Dest>
+    static typename Isa::Vec simd(typename Isa::Vec s, typename Isa::Vec d, typename Isa::Vec sa, typename Isa::Vec da)
+    {
+        using Vec = typename Isa::Vec;
+        Vec zero = Isa::zero();
+        Vec lo = simd32<Isa, Src, Dest>(Isa::unpacklo_16(s, zero), Isa::unpacklo_16(d, zero), Isa::unpacklo_16(sa, zero),
+                                        Isa::unpacklo_16(da, zero));
+        Vec hi = simd32<Isa, Src, Dest>(Isa::unpackhi_16(s, zero), Isa::unpackhi_16(d, zero), Isa::unpackhi_16(sa, zero),
+                                        Isa::unpackhi_16(da, zero));
+        return Isa::packs_32(lo, hi);
+    }
+
+    // The same float operations as scalar, on 32 bit lanes. The result is positive, so truncating it is the floor.
+    template <typename Isa, BlendMode Src, BlendMode Dest>
+    static typename Isa::Vec simd32(typename Isa::Vec s, typename Isa::Vec d, typename Isa::Vec sa, typename Isa::Vec da)
+    {
+        using FVec = typename Isa::FVec;
+        FVec max = Isa::set1_f(255.0f);
+        FVec fsa = Isa::div_f(Isa::to_float(sa), max);
+        FVec fda = Isa::div_f(Isa::to_float(da), max);
+        FVec f = Isa::mul_f(Isa::div_f(Isa::to_float(s), max), Factor<Src>::template simd_float<Isa>(fsa, fda));
+        f = Isa::mul_f(Isa::mul_f(f, Isa::div_f(Isa::to_float(d), max)), Factor<Dest>::template simd_float<Isa>(fsa, fda));
+        f = Isa::min_f(Isa::max_f(f, Isa::set1_f(0.0f)), Isa::set1_f(1.0f));
+        return Isa::truncate(Isa::add_f(Isa::mul_f(f, max), Isa::set1_f(0.5f)));
+    }
+};
+
+
+template <BlendMode Src, BlendMode Dest, BlendOp Op>
+struct Kernel
+{
+    static uint32_t blend(uint32_t src, uint32_t dest, int constant)
+    {
+        int sa = src >> 24;
+        int da = dest >> 24;
+        uint32_t result = (uint32_t)std::min(Factor<Src>::scalar(sa, da, constant), 255) << 24;
+
+        for (int shift = 0; shift < 24; shift += 8)
+        {
+            result |= Combine<Op>::template scalar<Src, Dest>((src >> shift) & 0xFF, (dest >> shift) & 0xFF, sa, da, constant) << shift;
+        }
+
+        return result;
+    }
+
+    // Blend 8 bit pixels unpacked into 16 bit lanes
+    template <typename Isa>
+    static typename Isa::Vec blend16(typename Isa::Vec s, typename Isa::Vec d)
+    {
+        using Vec = typename Isa::Vec;
+        Vec sa = Isa::broadcast_alpha(s);
+        Vec da = Isa::broadcast_alpha(d);
+        Vec rgb = Combine<Op>::template simd<Isa, Src, Dest>(s, d, sa, da);
+
+        // Output alpha is the source factor
+        Vec alpha_mask = Isa::set1_64(0xFFFF000000000000ull);
+        return Isa::or_(Isa::andnot(alpha_mask, rgb), Isa::and_(alpha_mask, Factor<Src>::template simd<Isa>(sa, da)));
+    }
+
+    template <typename Isa>
+    static typename Isa::Vec blend(typename Isa::Vec src, typename Isa::Vec dest)
+    {
+        using Vec = typename Isa::Vec;
+        Vec zero = Isa::zero();
+        Vec lo = blend16<Isa>(Isa::unpacklo_8(src, zero), Isa::unpacklo_8(dest, zero));
+        Vec hi = blend16<Isa>(Isa::unpackhi_8(src, zero), Isa::unpackhi_8(dest, zero));
+        return Isa::packus_16(lo, hi);
+    }
+};
+
+
+template <typename Isa, BlendMode Src, BlendMode Dest, BlendOp Op>
+void blend_span(Pixel* dest, const Pixel* src, int count, uint8_t constant)
+{
+    int i = 0;
+
+    for (; i + Isa::Width <= count; i += Isa::Width)
+    {
+        Isa::store(dest + i, Kernel<Src, Dest, Op>::template blend<Isa>(Isa::load(src + i), Isa::load(dest + i)));
+    }
+
+    for (; i < count; ++i)
+    {
+        dest[i].argb = Kernel<Src, Dest, Op>::blend(src[i].argb, dest[i].argb, constant);
+    }
+}
+
+
+template <typename Isa, BlendMode Src, BlendMode Dest, BlendOp Op>
+void blend_fill(Pixel* dest, Pixel src, int count, uint8_t constant)
+{
+    typename Isa::Vec color = Isa::set1_32(src.argb);
+    int i = 0;
+
+    for (; i + Isa::Width <= count; i += Isa::Width)
+    {
+        Isa::store(dest + i, Kernel<Src, Dest, Op>::template blend<Isa>(color, Isa::load(dest + i)));
+    }
+
+    for (; i < count; ++i)
+    {
+        dest[i].argb = Kernel<Src, Dest, Op>::blend(src.argb, dest[i].argb, constant);
+    }
+}
+
+
+template <BlendMode Src, BlendMode Dest, BlendOp Op>
+void blend_span_scalar(Pixel* dest, const Pixel* src, int count, uint8_t constant)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        dest[i].argb = Kernel<Src, Dest, Op>::blend(src[i].argb, dest[i].argb, constant);
+    }
+}
+
+
+template <BlendMode Src, BlendMode Dest, BlendOp Op>
+void blend_fill_scalar(Pixel* dest, Pixel src, int count, uint8_t constant)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        dest[i].argb = Kernel<Src, Dest, Op>::blend(src.argb, dest[i].argb, constant);
+    }
+}
+
+
+// Source over dest for straight alpha sources: s * w + d * (1 - w) with w = sa * alpha. The weight is rounded to 255ths and the
+// result truncated, as the float version truncated.
+template <typename Isa>
+void blend_straight_span(Pixel* dest, const Pixel* src, int count, uint8_t alpha)
+{
+    using Vec = typename Isa::Vec;
+    Vec zero = Isa::zero();
+    Vec scale = Isa::set1_16(alpha);
+    Vec max = Isa::set1_16(255);
+    Vec opaque = Isa::set1_32(0xFF000000);
+
+    auto blend16 = [&](Vec s, Vec d) {
+        Vec w = resolve<Isa>(Isa::mullo_16(Isa::broadcast_alpha(s), scale));
+        return floor_div255<Isa>(Isa::adds_u16(Isa::mullo_16(s, w), Isa::mullo_16(d, Isa::sub_16(max, w))));
+    };
+
+    int i = 0;
+
+    for (; i + Isa::Width <= count; i += Isa::Width)
+    {
+        Vec s = Isa::load(src + i);
+        Vec d = Isa::load(dest + i);
+        Vec lo = blend16(Isa::unpacklo_8(s, zero), Isa::unpacklo_8(d, zero));
+        Vec hi = blend16(Isa::unpackhi_8(s, zero), Isa::unpackhi_8(d, zero));
+        Isa::store(dest + i, Isa::or_(Isa::packus_16(lo, hi), opaque));
+    }
+
+    for (; i < count; ++i)
+    {
+        uint32_t w = resolve(src[i].a * alpha);
+        dest[i].r = (uint8_t)((src[i].r * w + dest[i].r * (255 - w)) / 255);
+        dest[i].g = (uint8_t)((src[i].g * w + dest[i].g * (255 - w)) / 255);
+        dest[i].b = (uint8_t)((src[i].b * w + dest[i].b * (255 - w)) / 255);
+        dest[i].a = 255;
+    }
+}
+
+
+// Source over dest for premultiplied sources: s * alpha + d * (1 - sa * alpha). Like blend_straight both products are summed
+// before the one division, which keeps it within 1 of the float blend on top of the rounding already in the premultiplied copy.
+template <typename Isa>
+void blend_premultiplied_span(Pixel* dest, const Pixel* src, int count, uint8_t alpha)
+{
+    using Vec = typename Isa::Vec;
+    Vec zero = Isa::zero();
+    Vec scale = Isa::set1_16(alpha);
+    Vec max = Isa::set1_16(255);
+    Vec opaque = Isa::set1_32(0xFF000000);
+
+    auto blend16 = [&](Vec s, Vec d) {
+        Vec inv = Isa::sub_16(max, resolve<Isa>(Isa::mullo_16(Isa::broadcast_alpha(s), scale)));
+        return floor_div255<Isa>(Isa::adds_u16(Isa::mullo_16(s, scale), Isa::mullo_16(d, inv)));
+    };
+
+    int i = 0;
+
+    for (; i + Isa::Width <= count; i += Isa::Width)
+    {
+        Vec s = Isa::load(src + i);
+        Vec d = Isa::load(dest + i);
+        Vec lo = blend16(Isa::unpacklo_8(s, zero), Isa::unpacklo_8(d, zero));
+        Vec hi = blend16(Isa::unpackhi_8(s, zero), Isa::unpackhi_8(d, zero));
+        Isa::store(dest + i, Isa::or_(Isa::packus_16(lo, hi), opaque));
+    }
+
+    for (; i < count; ++i)
+    {
+        uint32_t inv = 255 - resolve(src[i].a * alpha);
+        dest[i].r = (uint8_t)std::min(std::min(src[i].r * alpha + dest[i].r * inv, 65535u) / 255, 255u);
+        dest[i].g = (uint8_t)std::min(std::min(src[i].g * alpha + dest[i].g * inv, 65535u) / 255, 255u);
+        dest[i].b = (uint8_t)std::min(std::min(src[i].b * alpha + dest[i].b * inv, 65535u) / 255, 255u);
+        dest[i].a = 255;
+    }
+}
+
+
+// Each channel goes into the top byte of its 16 bit lane, so the high half of the product with factor is c * factor / 256. Alpha
+// is multiplied by 256, which gives it back unchanged.
+template <typename Isa>
+void scale_span(Pixel* dest, const Pixel* src, int count, uint16_t factor)
+{
+    using Vec = typename Isa::Vec;
+    Vec zero = Isa::zero();
+    Vec multiplier = Isa::set1_64((256ull << 48) | ((uint64_t)factor << 32) | ((uint64_t)factor << 16) | factor);
+    Vec max = Isa::set1_16(255);
+    int i = 0;
+
+    // packus_16 saturates signed lanes, so products of 32768 and up would pack to 0. x - (x - 255) clamps them to 255 first.
+    auto clamp = [&](Vec x) { return Isa::subs_u16(x, Isa::subs_u16(x, max)); };
+
+    for (; i + Isa::Width <= count; i += Isa::Width)
+    {
+        Vec s = Isa::load(src + i);
+        Vec lo = clamp(Isa::mulhi_u16(Isa::unpacklo_8(zero, s), multiplier));
+        Vec hi = clamp(Isa::mulhi_u16(Isa::unpackhi_8(zero, s), multiplier));
+        Isa::store(dest + i, Isa::packus_16(lo, hi));
+    }
+
+    for (; i < count; ++i)
+    {
+        Pixel p = src[i];
+        dest[i] = Pixel((uint8_t)std::min((p.r * factor) >> 8, 255), (uint8_t)std::min((p.g * factor) >> 8, 255),
+                        (uint8_t)std::min((p.b * factor) >> 8, 255), p.a);
+    }
+}
+
+
+inline void copy_span(Pixel* dest, const Pixel* src, int count, uint8_t)
+{
+    memcpy(dest, src, sizeof(Pixel) * count);
+}
+
+
+inline void copy_fill(Pixel* dest, Pixel src, int count, uint8_t)
+{
+    fill_pixels(dest, src, count);
+}
+
+
+inline void sample_nearest_scalar(Pixel* dest, const Pixel* src, int stride, int u, int v, int du, int dv, int count)
+{
+    for (int i = 0; i < count; ++i, u += du, v += dv)
+    {
+        dest[i] = src[(v >> 16) * stride + (u >> 16)];
+    }
+}
+
+
+// a + (b - a) * f / 256, rounded. With 8 bit inputs every term fits in 16 bits, so the AVX2 version gives the same results.
+inline uint32_t lerp8(uint32_t a, uint32_t b, uint32_t f)
+{
+    return (a * (256 - f) + b * f + 128) >> 8;
+}
+
+
+inline void sample_bilinear_scalar(Pixel* dest, const Pixel* src, int stride, int width, int height, int u, int v, int du, int dv,
+                                   int count)
+{
+    for (int i = 0; i < count; ++i, u += du, v += dv)
+    {
+        // Texel centres are at .5, so the four texels around the sample start half a texel up and left
+        int cu = std::min(std::max(u - 0x8000, 0), (width - 1) << 16);
+        int cv = std::min(std::max(v - 0x8000, 0), (height - 1) << 16);
+        int x0 = cu >> 16;
+        int x1 = std::min(x0 + 1, width - 1);
+        uint32_t fx = (cu >> 8) & 0xFF;
+        uint32_t fy = (cv >> 8) & 0xFF;
+        const Pixel* row0 = src + (cv >> 16) * stride;
+        const Pixel* row1 = src + std::min((cv >> 16) + 1, height - 1) * stride;
+        uint32_t result = 0;
+
+        for (int shift = 0; shift < 32; shift += 8)
+        {
+            uint32_t top = lerp8((row0[x0].argb >> shift) & 0xFF, (row0[x1].argb >> shift) & 0xFF, fx);
+            uint32_t bottom = lerp8((row1[x0].argb >> shift) & 0xFF, (row1[x1].argb >> shift) & 0xFF, fx);
+            result |= lerp8(top, bottom, fy) << shift;
+        }
+
+        dest[i].argb = result;
+    }
+}
+
+
+template <typename Isa, bool Simd, BlendMode Src, BlendMode Dest, BlendOp Op>
+struct Select
+{
+    static BlendKernel kernel() { return { &blend_span_scalar<Src, Dest, Op>, &blend_fill_scalar<Src, Dest, Op> }; }
+};
+
+template <typename Isa, BlendMode Src, BlendMode Dest, BlendOp Op>
+struct Select<Isa, true, Src, Dest, Op>
+{
+    static BlendKernel kernel() { return { &blend_span<Isa, Src, Dest, Op>, &blend_fill<Isa, Src, Dest, Op> }; }
+};
+
+
+template <typename Isa, BlendMode Src, BlendMode Dest>
+BlendKernel select_op(BlendOp op)
+{
+    static const bool Simd = Factor<Src>::Simd && Factor<Dest>::Simd;
+
+    switch (op)
+    {
+        case BlendOp::Multiply: return Select<Isa, Simd, Src, Dest, BlendOp::Multiply>::kernel();
+        case BlendOp::Add: return Select<Isa, Simd, Src, Dest, BlendOp::Add>::kernel();
+        case BlendOp::Subtract: return Select<Isa, Simd, Src, Dest, BlendOp::Subtract>::kernel();
+        default: return { &copy_span, &copy_fill };
+    }
+}
+
+
+template <typename Isa, BlendMode Src>
+BlendKernel select_dest(BlendMode dest_blend, BlendOp op)
+{
+    switch (dest_blend)
+    {
+        case BlendMode::Zero: return select_op<Isa, Src, BlendMode::Zero>(op);
+        case BlendMode::SrcAlpha: return select_op<Isa, Src, BlendMode::SrcAlpha>(op);
+        case BlendMode::InvSrcAlpha: return select_op<Isa, Src, BlendMode::InvSrcAlpha>(op);
+        case BlendMode::DestAlpha: return select_op<Isa, Src, BlendMode::DestAlpha>(op);
+        case BlendMode::InvDestAlpha: return select_op<Isa, Src, BlendMode::InvDestAlpha>(op);
+        case BlendMode::Constant: return select_op<Isa, Src, BlendMode::Constant>(op);
+        default: return select_op<Isa, Src, BlendMode::One>(op);
+    }
+}
+
+
+template <typename Isa>
+BlendKernel select_kernel(BlendMode src_blend, BlendMode dest_blend, BlendOp op)
+{
+    switch (src_blend)
+    {
+        case BlendMode::Zero: return select_dest<Isa, BlendMode::Zero>(dest_blend, op);
+        case BlendMode::SrcAlpha: return select_dest<Isa, BlendMode::SrcAlpha>(dest_blend, op);
+        case BlendMode::InvSrcAlpha: return select_dest<Isa, BlendMode::InvSrcAlpha>(dest_blend, op);
+        case BlendMode::DestAlpha: return select_dest<Isa, BlendMode::DestAlpha>(dest_blend, op);
+        case BlendMode::InvDestAlpha: return select_dest<Isa, BlendMode::InvDestAlpha>(dest_blend, op);
+        case BlendMode::Constant: return select_dest<Isa, BlendMode::Constant>(dest_blend, op);
+        default: return select_dest<Isa, BlendMode::One>(dest_blend, op);
+    }
+}
+
+} // namespace
+
+
+// Built into gli_blend_avx2.cpp, only call them when the CPU has AVX2
+BlendKernel get_blend_kernel_avx2(BlendMode src_blend, BlendMode dest_blend, BlendOp op);
+void blend_straight_avx2(Pixel* dest, const Pixel* src, int count, uint8_t alpha);
+void blend_premultiplied_avx2(Pixel* dest, const Pixel* src, int count, uint8_t alpha);
+void scale_pixels_avx2(Pixel* dest, const Pixel* src, int count, uint16_t factor);
+void sample_nearest_avx2(Pixel* dest, const Pixel* src, int stride, int u, int v, int du, int dv, int count);
+void sample_bilinear_avx2(Pixel* dest, const Pixel* src, int stride, int width, int height, int u, int v, int du, int dv,
+                          int count);
+
+} // namespace gli
@@ -0,0 +1,454 @@
+#include "gli_capture.h"
+
+#include "gli_debug.h"
+#include "gli_log.h"
+#include "gli_profile.h"
+
+#include <stb/stb_image_write.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace gli
+{
+
+// Same math as the fade in the shader
+static void resolve_rgb(const Pixel* palette, const uint8_t* indices, const Pixel* pixels, int count, Pixel fade_color, float fade,
+                        uint8_t* rgb)
+{
+    float keep = 1.0f - fade;
+
+    for (int i = 0; i < count; ++i)
+    {
+        Pixel p = indices ? palette[indices[i]] : pixels[i];
+
+        if (fade > 0.0f)
+        {
+            rgb[i * 3 + 0] = (uint8_t)(p.r * keep + fade_color.r * fade);
+            rgb[i * 3 + 1] = (uint8_t)(p.g * keep + fade_color.g * fade);
+            rgb[i * 3 + 2] = (uint8_t)(p.b * keep + fade_color.b * fade);
+        }
+        else
+        {
+            rgb[i * 3 + 0] = p.r;
+            rgb[i * 3 + 1] = p.g;
+            rgb[i * 3 + 2] = p.b;
+        }
+    }
+}
+
+
+static void put_u32_be(std::vector<uint8_t>& out, uint32_t v)
+{
+    out.push_back((uint8_t)(v >> 24));
+    out.push_back((uint8_t)(v >> 16));
+    out.push_back((uint8_t)(v >> 8));
+    out.push_back((uint8_t)v);
+}
+
+
+// The Quite OK Image format (qoiformat.org), 3 channels. Much faster to encode than PNG and usually within 30% of its size.
+static void encode_qoi(const uint8_t* rgb, int width, int height, std::vector<uint8_t>& out)
+{
+    static const uint8_t OpIndex = 0x00;
+    static const uint8_t OpDiff = 0x40;
+    static const uint8_t OpLuma = 0x80;
+    static const uint8_t OpRun = 0xC0;
+    static const uint8_t OpRgb = 0xFE;
+
+    out.clear();
+    out.insert(out.end(), { 'q', 'o', 'i', 'f' });
+    put_u32_be(out, (uint32_t)width);
+    put_u32_be(out, (uint32_t)height);
+    out.push_back(3); // Channels
+    out.push_back(0); // sRGB
+
+    // Pixels are compared as argb with alpha always 255, so the zeroed index never matches
+    uint32_t index[64] = {};
+    uint32_t prev = 0xFF000000;
+    int run = 0;
+    int count = width * height;
+
+    for (int i = 0; i < count; ++i)
+    {
+        uint8_t r = rgb[i * 3 + 0];
+        uint8_t g = rgb[i * 3 + 1];
+        uint8_t b = rgb[i * 3 + 2];
+        uint32_t px = 0xFF000000 | (r << 16) | (g << 8) | b;
+
+        if (px == prev)
+        {
+            if (++run == 62 || i == count - 1)
+            {
+                out.push_back((uint8_t)(OpRun | (run - 1)));
+                run = 0;
+            }
+
+            continue;
+        }
+
+        if (run > 0)
+        {
+            out.push_back((uint8_t)(OpRun | (run - 1)));
+            run = 0;
+        }
+
+        int hash = (r * 3 + g * 5 + b * 7 + 255 * 11) % 64;
+
+        if (index[hash] == px)
+        {
+            out.push_back((uint8_t)(OpIndex | hash));
+        }
+        else
+        {
+            index[hash] = px;
+            int dr = (int8_t)(r - (uint8_t)(prev >> 16));
+            int dg = (int8_t)(g - (uint8_t)(prev >> 8));
+            int db = (int8_t)(b - (uint8_t)prev);
+            int dr_dg = dr - dg;
+            int db_dg = db - dg;
+
+            if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+            {
+                out.push_back((uint8_t)(OpDiff | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2)));
+            }
+            else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7)
+            {
+                out.push_back((uint8_t)(OpLuma | (dg + 32)));
+                out.push_back((uint8_t)(((dr_dg + 8) << 4) | (db_dg + 8)));
+            }
+            else
+            {
+                out.insert(out.end(), { OpRgb, r, g, b });
+            }
+        }
+
+        prev = px;
+    }
+
+    out.insert(out.end(), { 0, 0, 0, 0, 0, 0, 0, 1 });
+}
+
+
+// Full range BT.601 4:2:0, chroma from the average of each 2x2 block (odd sizes repeat the last row and column)
+static void encode_y4m_frame(const uint8_t* rgb, int width, int height, std::vector<uint8_t>& out)
+{
+    int chroma_width = (width + 1) / 2;
+    int chroma_height = (height + 1) / 2;
+    out.resize(6 + width * height + chroma_width * chroma_height * 2);
+    memcpy(out.data(), "FRAME\n", 6);
+
+    uint8_t* y_plane = out.data() + 6;
+    uint8_t* u_plane = y_plane + width * height;
+    uint8_t* v_plane = u_plane + chroma_width * chroma_height;
+
+    for (int i = 0; i < width * height; ++i)
+    {
+        const uint8_t* p = rgb + i * 3;
+        y_plane[i] = (uint8_t)((77 * p[0] + 150 * p[1] + 29 * p[2] + 128) >> 8);
+    }
+
+    for (int cy = 0; cy < chroma_height; ++cy)
+    {
+        int y0 = cy * 2;
+        int y1 = std::min(y0 + 1, height - 1);
+
+        for (int cx = 0; cx < chroma_width; ++cx)
+        {
+            int x0 = cx * 2;
+            int x1 = std::min(x0 + 1, width - 1);
+            int sum[3];
+
+            for (int c = 0; c < 3; ++c)
+            {
+                sum[c] = rgb[(y0 * width + x0) * 3 + c] + rgb[(y0 * width + x1) * 3 + c] + rgb[(y1 * width + x0) * 3 + c] +
+                         rgb[(y1 * width + x1) * 3 + c];
+            }
+
+            // Sums are 4x the average, so the shifts are 2 more than for a single pixel
+            int u = (-43 * sum[0] - 85 * sum[1] + 128 * sum[2] + 512) >> 10;
+            int v = (128 * sum[0] - 107 * sum[1] - 21 * sum[2] + 512) >> 10;
+            u_plane[cy * chroma_width + cx] = (uint8_t)std::min(std::max(u + 128, 0), 255);
+            v_plane[cy * chroma_width + cx] = (uint8_t)std::min(std::max(v + 128, 0), 255);
+        }
+    }
+}
+
+
+FrameCapture::~FrameCapture()
+{
+    stop_sequence();
+
+    if (m_thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_quit = true;
+            m_wake.notify_one();
+        }
+
+        m_thread.join();
+    }
+}
+
+
+void FrameCapture::save_image(const std::string& path, CaptureFormat format, const CaptureSource& source)
+{
+    gliAssert(format != Capture_Y4m);
+    Frame* frame = acquire(Frame::Image, format, path);
+    copy_source(*frame, source);
+    push(frame);
+}
+
+
+void FrameCapture::start_sequence(const std::string& prefix, CaptureFormat format, int fps)
+{
+    stop_sequence();
+
+    m_sequence_active = true;
+    m_sequence_format = format;
+    m_sequence_prefix = prefix;
+    m_sequence_fps = fps;
+    m_sequence_frame = 0;
+    m_sequence_failed = false;
+}
+
+
+void FrameCapture::add_frame(const CaptureSource& source)
+{
+    if (!m_sequence_active)
+    {
+        return;
+    }
+
+    if (m_sequence_failed)
+    {
+        stop_sequence();
+        return;
+    }
+
+    Frame* frame;
+
+    if (m_sequence_format == Capture_Y4m)
+    {
+        frame = acquire(Frame::VideoFrame, m_sequence_format, m_sequence_prefix + ".y4m");
+        frame->fps = m_sequence_fps;
+    }
+    else
+    {
+        char number[16];
+        snprintf(number, sizeof(number), "_%06u", m_sequence_frame);
+        frame = acquire(Frame::Image, m_sequence_format, m_sequence_prefix + number + (m_sequence_format == Capture_Qoi ? ".qoi" : ".png"));
+    }
+
+    copy_source(*frame, source);
+    push(frame);
+    ++m_sequence_frame;
+}
+
+
+void FrameCapture::stop_sequence()
+{
+    if (!m_sequence_active)
+    {
+        return;
+    }
+
+    if (m_sequence_format == Capture_Y4m)
+    {
+        push(acquire(Frame::VideoEnd, m_sequence_format, ""));
+    }
+
+    // A failed sequence has already said so
+    if (!m_sequence_failed)
+    {
+        gliLog(LogLevel::Info, "Capture", "FrameCapture::stop_sequence", "Captured %u frames to %s.", m_sequence_frame,
+               m_sequence_prefix.c_str());
+    }
+
+    m_sequence_active = false;
+}
+
+
+void FrameCapture::flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this] { return m_pending.empty() && !m_busy; });
+}
+
+
+FrameCapture::Frame* FrameCapture::acquire(Frame::Type type, CaptureFormat format, const std::string& path)
+{
+    Frame* frame;
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        if (m_free.empty() && m_frames.size() < MaxPending)
+        {
+            m_frames.emplace_back(new Frame());
+            m_free.push_back(m_frames.back().get());
+        }
+
+        if (m_free.empty())
+        {
+            GLI_PROFILE_SCOPE("FrameCapture::acquire wait");
+            m_idle.wait(lock, [this] { return !m_free.empty(); });
+        }
+
+        frame = m_free.back();
+        m_free.pop_back();
+    }
+
+    frame->type = type;
+    frame->format = format;
+    frame->path = path;
+    return frame;
+}
+
+
+void FrameCapture::copy_source(Frame& frame, const CaptureSource& source)
+{
+    GLI_PROFILE_SCOPE("FrameCapture::copy_source");
+    size_t count = (size_t)source.width * source.height;
+    frame.width = source.width;
+    frame.height = source.height;
+    frame.indexed = source.indices != nullptr;
+    frame.fade_color = source.fade_color;
+    frame.fade = source.fade;
+
+    if (frame.indexed)
+    {
+        frame.data.assign(source.indices, source.indices + count);
+        memcpy(frame.palette, source.palette, sizeof(frame.palette));
+    }
+    else
+    {
+        frame.data.assign((const uint8_t*)source.pixels, (const uint8_t*)(source.pixels + count));
+    }
+}
+
+
+void FrameCapture::push(Frame* frame)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_thread.joinable())
+    {
+        m_thread = std::thread(&FrameCapture::encoder_func, this);
+    }
+
+    m_pending.push_back(frame);
+    m_wake.notify_one();
+}
+
+
+void FrameCapture::encoder_func()
+{
+    GLI_PROFILE_THREAD("Frame capture");
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;)
+    {
+        m_wake.wait(lock, [this] { return m_quit || !m_pending.empty(); });
+
+        // Everything queued before quitting still gets written
+        if (m_pending.empty())
+        {
+            break;
+        }
+
+        Frame* frame = m_pending.front();
+        m_pending.pop_front();
+        m_busy = true;
+        lock.unlock();
+
+        encode(*frame);
+
+        lock.lock();
+        m_busy = false;
+        m_free.push_back(frame);
+        m_idle.notify_all();
+    }
+
+    if (m_video)
+    {
+        fclose(m_video);
+        m_video = nullptr;
+    }
+}
+
+
+void FrameCapture::encode(Frame& frame)
+{
+    GLI_PROFILE_SCOPE("FrameCapture::encode");
+
+    if (frame.type == Frame::VideoEnd)
+    {
+        if (m_video)
+        {
+            fclose(m_video);
+            m_video = nullptr;
+        }
+
+        m_video_failed = false;
+        return;
+    }
+
+    if (frame.type == Frame::VideoFrame && m_video_failed)
+    {
+        return;
+    }
+
+    int count = frame.width * frame.height;
+    m_rgb.resize((size_t)count * 3);
+    resolve_rgb(frame.palette, frame.indexed ? frame.data.data() : nullptr, (const Pixel*)frame.data.data(), count, frame.fade_color,
+                frame.fade, m_rgb.data());
+
+    if (frame.type == Frame::VideoFrame)
+    {
+        if (!m_video)
+        {
+            m_video = fopen(frame.path.c_str(), "wb");
+
+            if (!m_video)
+            {
+                gliLog(LogLevel::Error, "Capture", "FrameCapture::encode", "Failed to open %s, stopping the capture.", frame.path.c_str());
+                m_video_failed = true;
+                m_sequence_failed = true;
+                return;
+            }
+
+            fprintf(m_video, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XCOLORRANGE=FULL\n", frame.width, frame.height, frame.fps);
+        }
+
+        encode_y4m_frame(m_rgb.data(), frame.width, frame.height, m_encoded);
+        fwrite(m_encoded.data(), m_encoded.size(), 1, m_video);
+        return;
+    }
+
+    bool written;
+
+    if (frame.format == Capture_Qoi)
+    {
+        encode_qoi(m_rgb.data(), frame.width, frame.height, m_encoded);
+        FILE* file = fopen(frame.path.c_str(), "wb");
+        written = file && fwrite(m_encoded.data(), m_encoded.size(), 1, file) == 1;
+
+        if (file)
+        {
+            fclose(file);
+        }
+    }
+    else
+    {
+        written = stbi_write_png(frame.path.c_str(), frame.width, frame.height, 3, m_rgb.data(), frame.width * 3) != 0;
+    }
+
+    if (!written)
+    {
+        gliLog(LogLevel::Error, "Capture", "FrameCapture::encode", "Failed to write %s.", frame.path.c_str());
+    }
+}
+
+} // namespace gli
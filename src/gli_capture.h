@@ -0,0 +1,109 @@
+#pragma once
+
+#include "gli_core.h" // for gli::Pixel, gli::CaptureFormat
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace gli
+{
+
+// A frame as the screen shows it: pixels, or palette indices and the palette, with the screen fade still to be applied
+struct CaptureSource
+{
+    int width;
+    int height;
+    const Pixel* pixels;
+    const uint8_t* indices;
+    const Pixel* palette;
+    Pixel fade_color;
+    float fade;
+};
+
+// Writes screenshots and frame sequences on a background thread. Frames are copied into pooled buffers on the calling thread
+// and encoded in order; the caller only waits when MaxPending frames are already queued, so a sequence that can't keep up
+// slows the game down instead of dropping frames.
+class FrameCapture
+{
+public:
+    static const int MaxPending = 8;
+
+    FrameCapture() = default;
+    FrameCapture(const FrameCapture&) = delete;
+    ~FrameCapture();
+
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    void save_image(const std::string& path, CaptureFormat format, const CaptureSource& source);
+
+    // Sequences write prefix_000000.png, prefix_000001.png and so on, or every frame to prefix.y4m
+    void start_sequence(const std::string& prefix, CaptureFormat format, int fps);
+    void add_frame(const CaptureSource& source);
+    void stop_sequence();
+    bool sequence_active() const { return m_sequence_active; }
+
+    // Wait until everything queued so far has been written
+    void flush();
+
+private:
+    struct Frame
+    {
+        enum Type
+        {
+            Image,
+            VideoFrame,
+            VideoEnd
+        };
+
+        Type type;
+        CaptureFormat format;
+        std::string path; // Image file, or the video to open if none is open
+        int fps;
+        int width;
+        int height;
+        bool indexed;
+        std::vector<uint8_t> data; // Pixels or indices
+        Pixel palette[256];
+        Pixel fade_color;
+        float fade;
+    };
+
+    Frame* acquire(Frame::Type type, CaptureFormat format, const std::string& path);
+    void copy_source(Frame& frame, const CaptureSource& source);
+    void push(Frame* frame);
+    void encoder_func();
+    void encode(Frame& frame);
+
+    std::thread m_thread{};
+    std::mutex m_mutex{};
+    std::condition_variable m_wake{}; // Frames queued, or quitting
+    std::condition_variable m_idle{}; // A frame finished
+    std::deque<Frame*> m_pending{};
+    std::vector<Frame*> m_free{};
+    std::vector<std::unique_ptr<Frame>> m_frames{};
+    bool m_busy = false;
+    bool m_quit = false;
+    std::atomic<bool> m_sequence_failed{ false }; // Set by the encoder when the video can't be opened, add_frame stops the sequence
+
+    // Calling thread only
+    bool m_sequence_active = false;
+    CaptureFormat m_sequence_format = Capture_Png;
+    std::string m_sequence_prefix{};
+    int m_sequence_fps = 60;
+    uint32_t m_sequence_frame = 0;
+
+    // Encoder thread only
+    FILE* m_video = nullptr;
+    bool m_video_failed = false; // Drop frames until the VideoEnd
+    std::vector<uint8_t> m_rgb{};
+    std::vector<uint8_t> m_encoded{};
+};
+
+} // namespace gli
@@ -2,100 +2,51 @@
 
 #include "gli_core.h"
 
+#include "gli_atlas.h"
+#include "gli_blend.h"
+#include "gli_capture.h"
+#include "gli_debug.h"
+#include "gli_draw_list.h"
+#include "gli_font.h"
+#include "gli_input_log.h"
+#include "gli_layer.h"
+#include "gli_job.h"
 #include "gli_log.h"
-#include "gli_opengl.h"
+#include "gli_profile.h"
 #include "gli_sprite.h"
-#include "gli_types.h"
-
-#include "opengl/glad.h"
+#include "gli_surface.h"
 
-#include <objbase.h>
-#include <Xinput.h>
+#include "vga9.h"
 
-#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <ctime>
-#include <thread>
 #include <unordered_map>
 
-// TODO: Move this into gli::Sprite (and rename that class)
-#include <stb/stb_image_write.h>
-
-// TODO: AVX
+// For Pixel::operator*, which is for single pixels. gli::LightTable shades whole spans.
 #include "immintrin.h"
 
-extern int gli_main(int argc, char** argv);
-
-static const char* s_shader_source[2]{
-    R"(
-#version 400 core
-
-in vec2 vPos;
-out vec2 vTexCoord;
-
-out gl_PerVertex
-{
-    vec4 gl_Position;
-};
-
-void main()
-{
-    gl_Position = vec4(vPos, 0, 1);
-    vTexCoord = (vPos + 1.0) * vec2(0.5, -0.5);
-}
-    )",
-
-    R"(
-#version 400 core
-
-uniform sampler2D sDiffuseMap;
-uniform float fFade;
-
-in vec2 vTexCoord;
-out vec4 oColor;
-
-void main()
+namespace gli
 {
-    oColor = vec4(texture(sDiffuseMap, vTexCoord).rgb, fFade);
-}
-    )"
-};
 
-DWORD WINAPI XInputGetStateStub(DWORD, XINPUT_STATE*)
+// Local time as YYYYMMDDhhmmssmmm, for file names
+static std::string timestamp()
 {
-    return ERROR_DEVICE_NOT_CONNECTED;
+    std::chrono::system_clock::time_point tp = std::chrono::system_clock::now();
+    std::time_t tt = std::chrono::system_clock::to_time_t(tp);
+    std::chrono::system_clock::duration ticks = tp.time_since_epoch();
+    ticks -= std::chrono::duration_cast<std::chrono::seconds>(ticks);
+    uint32_t milliseconds = (uint32_t)(ticks / std::chrono::milliseconds(1));
+
+    char buffer[32];
+    size_t len = std::strftime(buffer, sizeof(buffer), "%Y%m%d%H%M%S", std::localtime(&tt));
+    std::snprintf(buffer + len, sizeof(buffer) - len, "%03u", milliseconds);
+    return buffer;
 }
 
-using XInputGetStateFuncPtr = decltype(&(XInputGetStateStub));
-
-struct ControllerState
-{
-    bool connected;
-    XINPUT_GAMEPAD current_state;
-    XINPUT_GAMEPAD prev_state;
-};
-
-namespace gli
-{
-
-char* wchar_to_utf8(const wchar_t* mbcs);
-wchar_t* utf8_to_wchar(const char* utf8);
-OpenGL _opengl;
-GLuint _shader_program{};
-GLuint _vbo = 0;
-GLuint _vao = 0;
-GLuint _texture = 0;
-GLuint _uniform_fade = 0;
-std::atomic<bool> _quit;
-std::atomic<bool> _active;
-std::atomic<bool> _mouse_active;
-std::atomic<App::MouseState> _mouse_state;
-std::atomic<bool> _poll_controllers;
-std::atomic<int> _mouse_wheel = 0;
-HMODULE _xinput_dll = NULL;
-XInputGetStateFuncPtr XInputGetState = XInputGetStateStub;
-ControllerState _controller_states[4]{};
-int _hide_cursor = 1;
-bool _cursor_hidden = true;
 
 #if 1
 // TODO: Not scaling alpha
@@ -124,168 +75,36 @@ Pixel Pixel::operator*(float f)
 }
 #endif
 
-bool App::initialize(const char* name, int screen_width, int screen_height, int window_scale)
+bool App::initialize(const char* name, int screen_width, int screen_height, int window_scale, FramebufferFormat format, int worker_count)
 {
     if (screen_width <= 0 || screen_height <= 0 || window_scale <= 0)
     {
         return false;
     }
 
-    m_title = utf8_to_wchar(name);
-
     m_screen_width = screen_width;
     m_screen_height = screen_height;
     m_window_width = screen_width * window_scale;
     m_window_height = screen_height * window_scale;
 
-    // Create window
-    WNDCLASSEXW wc = {};
-    wc.cbSize = sizeof(wc);
-    wc.style = CS_HREDRAW | CS_VREDRAW | CS_OWNDC;
-    wc.lpfnWndProc = window_proc;
-    wc.hInstance = GetModuleHandle(NULL);
-    wc.hCursor = LoadCursor(NULL, IDC_ARROW);
-    wc.lpszClassName = L"IneptEngineWindow";
+    // Initialise frame buffer
+    m_framebuffer_format = format;
 
-    if (!RegisterClassEx(&wc))
+    if (m_framebuffer_format == Framebuffer_Indexed)
     {
-        return false;
+        m_indexed_framebuffer = new uint8_t[screen_width * screen_height];
+        memset(m_indexed_framebuffer, 0, screen_width * screen_height);
     }
-
-    DWORD dwExStyle = WS_EX_APPWINDOW | WS_EX_WINDOWEDGE;
-    DWORD dwStyle = WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
-
-    RECT client_rect = { 0, 0, m_window_width, m_window_height };
-    AdjustWindowRectEx(&client_rect, dwStyle, FALSE, dwExStyle);
-    int width = client_rect.right - client_rect.left;
-    int height = client_rect.bottom - client_rect.top;
-    m_hwnd = CreateWindowEx(dwExStyle, L"IneptEngineWindow", m_title, dwStyle, 0, 0, width, height, NULL, NULL, GetModuleHandle(NULL), NULL);
-    SetProp(m_hwnd, L"IneptEngineWindow", (HANDLE)this);
-
-    if (m_hwnd == NULL)
+    else
     {
-        return false;
+        m_framebuffer = new Pixel[screen_width * screen_height];
     }
 
-    int x = (GetSystemMetrics(SM_CXSCREEN) - width) / 2;
-    int y = (GetSystemMetrics(SM_CYSCREEN) - height) / 2;
-    SetWindowPos(m_hwnd, 0, x, y, 0, 0, SWP_NOZORDER | SWP_NOSIZE);
-    ShowCursor(FALSE);
-
-    // Initialise key states
-    for (int i = 0; i < 2; ++i)
-    {
-        m_keystate[i] = new short[256];
-        memset(m_keystate[i], 0, sizeof(short) * 256);
-    }
-
-    // Map of gli::Key codes to Windows virtual keys
-    m_keymap[Key_A] = 'A';
-    m_keymap[Key_B] = 'B';
-    m_keymap[Key_C] = 'C';
-    m_keymap[Key_D] = 'D';
-    m_keymap[Key_E] = 'E';
-    m_keymap[Key_F] = 'F';
-    m_keymap[Key_G] = 'G';
-    m_keymap[Key_H] = 'H';
-    m_keymap[Key_I] = 'I';
-    m_keymap[Key_J] = 'J';
-    m_keymap[Key_K] = 'K';
-    m_keymap[Key_L] = 'L';
-    m_keymap[Key_M] = 'M';
-    m_keymap[Key_N] = 'N';
-    m_keymap[Key_O] = 'O';
-    m_keymap[Key_P] = 'P';
-    m_keymap[Key_Q] = 'Q';
-    m_keymap[Key_R] = 'R';
-    m_keymap[Key_S] = 'S';
-    m_keymap[Key_T] = 'T';
-    m_keymap[Key_U] = 'U';
-    m_keymap[Key_V] = 'V';
-    m_keymap[Key_W] = 'W';
-    m_keymap[Key_X] = 'X';
-    m_keymap[Key_Y] = 'Y';
-    m_keymap[Key_Z] = 'Z';
-    m_keymap[Key_0] = '0';
-    m_keymap[Key_1] = '1';
-    m_keymap[Key_2] = '2';
-    m_keymap[Key_3] = '3';
-    m_keymap[Key_4] = '4';
-    m_keymap[Key_5] = '5';
-    m_keymap[Key_6] = '6';
-    m_keymap[Key_7] = '7';
-    m_keymap[Key_8] = '8';
-    m_keymap[Key_9] = '9';
-    m_keymap[Key_Space] = VK_SPACE;
-    m_keymap[Key_BackTick] = VK_OEM_3;
-    m_keymap[Key_Minus] = VK_OEM_MINUS;
-    m_keymap[Key_Equals] = VK_OEM_PLUS;
-    m_keymap[Key_LeftBracket] = VK_OEM_4;
-    m_keymap[Key_RightBracket] = VK_OEM_6;
-    m_keymap[Key_Backslash] = VK_OEM_5;
-    m_keymap[Key_Semicolon] = VK_OEM_1;
-    m_keymap[Key_Apostrophe] = VK_OEM_7;
-    m_keymap[Key_Comma] = VK_OEM_COMMA;
-    m_keymap[Key_Period] = VK_OEM_PERIOD;
-    m_keymap[Key_Slash] = VK_OEM_2;
-    m_keymap[Key_Backspace] = VK_BACK;
-    m_keymap[Key_Tab] = VK_TAB;
-    m_keymap[Key_Enter] = VK_RETURN;
-    m_keymap[Key_Escape] = VK_ESCAPE;
-    m_keymap[Key_Menu] = VK_APPS;
-    m_keymap[Key_LeftSystem] = VK_LWIN;
-    m_keymap[Key_RightSystem] = VK_RWIN;
-    m_keymap[Key_PrintScreen] = VK_SNAPSHOT;
-    m_keymap[Key_F1] = VK_F1;
-    m_keymap[Key_F2] = VK_F2;
-    m_keymap[Key_F3] = VK_F3;
-    m_keymap[Key_F4] = VK_F4;
-    m_keymap[Key_F5] = VK_F5;
-    m_keymap[Key_F6] = VK_F6;
-    m_keymap[Key_F7] = VK_F7;
-    m_keymap[Key_F8] = VK_F8;
-    m_keymap[Key_F9] = VK_F9;
-    m_keymap[Key_F10] = VK_F10;
-    m_keymap[Key_F11] = VK_F11;
-    m_keymap[Key_F12] = VK_F12;
-    m_keymap[Key_LeftShift] = VK_LSHIFT;
-    m_keymap[Key_RightShift] = VK_RSHIFT;
-    m_keymap[Key_LeftControl] = VK_LCONTROL;
-    m_keymap[Key_RightControl] = VK_RCONTROL;
-    m_keymap[Key_LeftAlt] = VK_LMENU;
-    m_keymap[Key_RightAlt] = VK_RMENU;
-    m_keymap[Key_Left] = VK_LEFT;
-    m_keymap[Key_Right] = VK_RIGHT;
-    m_keymap[Key_Up] = VK_UP;
-    m_keymap[Key_Down] = VK_DOWN;
-    m_keymap[Key_PageUp] = VK_PRIOR;
-    m_keymap[Key_PageDown] = VK_NEXT;
-    m_keymap[Key_Home] = VK_HOME;
-    m_keymap[Key_End] = VK_END;
-    m_keymap[Key_Insert] = VK_INSERT;
-    m_keymap[Key_Delete] = VK_DELETE;
-    m_keymap[Key_ScrollLock] = VK_SCROLL;
-    m_keymap[Key_CapsLock] = VK_CAPITAL;
-    m_keymap[Key_NumLock] = VK_NUMLOCK;
-    m_keymap[Key_Num_0] = VK_NUMPAD0;
-    m_keymap[Key_Num_1] = VK_NUMPAD1;
-    m_keymap[Key_Num_2] = VK_NUMPAD2;
-    m_keymap[Key_Num_3] = VK_NUMPAD3;
-    m_keymap[Key_Num_4] = VK_NUMPAD4;
-    m_keymap[Key_Num_5] = VK_NUMPAD5;
-    m_keymap[Key_Num_6] = VK_NUMPAD6;
-    m_keymap[Key_Num_7] = VK_NUMPAD7;
-    m_keymap[Key_Num_8] = VK_NUMPAD8;
-    m_keymap[Key_Num_9] = VK_NUMPAD9;
-    m_keymap[Key_Num_Add] = VK_ADD;
-    m_keymap[Key_Num_Subtract] = VK_SUBTRACT;
-    m_keymap[Key_Num_Multiply] = VK_MULTIPLY;
-    m_keymap[Key_Num_Divide] = VK_DIVIDE;
-    m_keymap[Key_Num_Decimal] = VK_DECIMAL;
-    m_keymap[Key_Num_Enter] = VK_RETURN; // TODO - need to handle WM_KEY* and look at lparam to distinguish from other enter key
+    m_dirty.reset(screen_width, screen_height);
+    m_dirty.add_all();
+    m_clip = { 0, 0, screen_width, screen_height };
 
-    // Initialise frame buffer
-    m_framebuffer = new Pixel[screen_width * screen_height];
+    JobSystem::get()->start(worker_count);
 
     // Set default palette
     static uint32_t default_palette[256] = {
@@ -312,125 +131,143 @@ bool App::initialize(const char* name, int screen_width, int screen_height, int
 
     set_palette(default_palette);
 
-    // Initialize OpenGL
-    if (!_opengl.init(m_hwnd))
-    {
-        return false;
-    }
+    m_blend_kernel = get_blend_kernel(m_src_blend, m_dest_blend, m_blend_op);
+
+    return platform_initialize(name, window_scale);
+}
+
+
+void App::quit()
+{
+    m_quit = true;
+}
+
+
+void App::set_fixed_timestep(float delta)
+{
+    m_fixed_timestep = delta;
+}
+
+
+void App::set_input_script(InputScript script)
+{
+    m_input_script = std::move(script);
+}
+
+
+bool App::record_input(const std::string& path)
+{
+    stop_input_log();
+    m_input_log = new InputLog();
 
-    if (!_opengl.make_current(true))
+    if (!m_input_log->open_write(path))
     {
+        stop_input_log();
         return false;
     }
 
-    GLint status;
-    GLuint vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex_shader, 1, &s_shader_source[0], nullptr);
-    glCompileShader(vertex_shader);
-    glGetShaderiv(vertex_shader, GL_COMPILE_STATUS, &status);
+    return true;
+}
+
+
+bool App::replay_input(const std::string& path, const std::string& timing_path)
+{
+    stop_input_log();
+    m_input_log = new InputLog();
 
-    if (!status)
+    if (!m_input_log->open_read(path))
     {
-        GLint log_length;
-        glGetShaderiv(vertex_shader, GL_INFO_LOG_LENGTH, &log_length);
-        std::string log;
-        log.resize(log_length);
-        glGetShaderInfoLog(vertex_shader, log_length, nullptr, &log[0]);
-        logf("Vertex shader failed to compile:\n%s\n", log.c_str());
+        stop_input_log();
         return false;
     }
 
-    GLuint fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment_shader, 1, &s_shader_source[1], nullptr);
-    glCompileShader(fragment_shader);
-    glGetShaderiv(fragment_shader, GL_COMPILE_STATUS, &status);
-
-    if (!status)
+    if (!timing_path.empty())
     {
-        GLint log_length;
-        glGetShaderiv(fragment_shader, GL_INFO_LOG_LENGTH, &log_length);
-        std::string log;
-        log.resize(log_length);
-        glGetShaderInfoLog(fragment_shader, log_length, nullptr, &log[0]);
-        logf("Fragment shader failed to compile:\n%s\n", log.c_str());
-        return false;
+        m_timing_file = fopen(timing_path.c_str(), "w");
+
+        if (!m_timing_file)
+        {
+            gliLog(LogLevel::Error, "App", "App::replay_input", "Failed to open %s.", timing_path.c_str());
+            stop_input_log();
+            return false;
+        }
+
+        fputs("frame,ms\n", m_timing_file);
     }
 
-    _shader_program = glCreateProgram();
-    glAttachShader(_shader_program, vertex_shader);
-    glAttachShader(_shader_program, fragment_shader);
-    glLinkProgram(_shader_program);
-    glGetProgramiv(_shader_program, GL_LINK_STATUS, &status);
+    // Only the frames from here on line up with the log
+    m_frame_timer.reset();
+    return true;
+}
+
 
-    if (!status)
+void App::stop_input_log()
+{
+    if (m_input_log && m_input_log->frame_count() > 0)
     {
-        GLint log_length;
-        glGetProgramiv(_shader_program, GL_INFO_LOG_LENGTH, &log_length);
-        std::string log;
-        log.resize(log_length);
-        glGetProgramInfoLog(_shader_program, log_length, nullptr, &log[0]);
-        logf("Program failed to link:\n%s\n", log.c_str());
-        return false;
+        FrameStats stats = summarize_frames(m_input_log_times.data(), (int)m_input_log_times.size());
+        gliLog(LogLevel::Info, "App", "App::stop_input_log", "%s %llu frames, p50 %0.2f ms, p99 %0.2f ms, max %0.2f ms.",
+               m_input_log->writing() ? "Recorded" : "Replayed", (unsigned long long)m_input_log->frame_count(), stats.p50 * 1000.0f,
+               stats.p99 * 1000.0f, stats.max * 1000.0f);
     }
 
-    glDeleteShader(vertex_shader);
-    glDeleteShader(fragment_shader);
+    delete m_input_log;
+    m_input_log = nullptr;
+    m_input_log_times.clear();
 
-    glGenBuffers(1, &_vbo);
-    glGenVertexArrays(1, &_vao);
+    if (m_timing_file)
+    {
+        fclose(m_timing_file);
+        m_timing_file = nullptr;
+    }
+}
 
-    glBindVertexArray(_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
 
-    static const float verts[] = { -1.0f, 1.0f, -1.0f, -3.0f, 3.0f, 1.0f };
-    glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
+bool App::recording_input() const
+{
+    return m_input_log && m_input_log->writing();
+}
 
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
 
-    glGenTextures(1, &_texture);
-    glBindTexture(GL_TEXTURE_2D, _texture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+bool App::replaying_input() const
+{
+    return m_input_log && m_input_log->reading();
+}
 
-    _uniform_fade = glGetUniformLocation(_shader_program, "fFade");
 
-    _opengl.make_current(false);
+bool App::input_log_from_args(int argc, char** argv)
+{
+    const char* record_path = nullptr;
+    const char* replay_path = nullptr;
+    const char* timing_path = "";
 
-    // Initialize XInput
-    if ((_xinput_dll = LoadLibrary(XINPUT_DLL)))
+    for (int i = 1; i + 1 < argc; ++i)
     {
-        if (!(XInputGetState = (XInputGetStateFuncPtr)GetProcAddress(_xinput_dll, "XInputGetState")))
+        if (strcmp(argv[i], "--record") == 0)
         {
-            XInputGetState = XInputGetStateStub;
+            record_path = argv[++i];
         }
-
-        XINPUT_STATE state;
-
-        for (int i = 0; i < 4; ++i)
+        else if (strcmp(argv[i], "--replay") == 0)
+        {
+            replay_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--timing") == 0)
         {
-            _controller_states[i].connected = XInputGetState(i, &state) == ERROR_SUCCESS;
+            timing_path = argv[++i];
         }
     }
 
-    return true;
-}
-
-
-void App::run()
-{
-    _quit = false;
-    _active = true;
-    std::thread game_thread = std::thread(&App::engine_loop, this);
-    pump_messages();
-    game_thread.join();
-    shutdown();
-}
+    if (replay_path)
+    {
+        return replay_input(replay_path, timing_path);
+    }
 
+    if (record_path)
+    {
+        return record_input(record_path);
+    }
 
-void App::quit()
-{
-    _quit = true;
+    return true;
 }
 
 
@@ -446,59 +283,47 @@ const App::MouseState& App::mouse_state()
 }
 
 
-void App::show_mouse(bool show)
+App::ControllerState App::controller_state(int controller)
 {
-    if (show && _hide_cursor)
-    {
-        --_hide_cursor;
-    }
-    else
-    {
-        ++_hide_cursor;
-    }
+    return m_controllers[controller];
 }
 
 
-bool App::mouse_visible()
+void App::process_key_events(KeyEventHandler handler)
 {
-    return _hide_cursor == 0;
-}
+    if (input_from_devices())
+    {
+        for (size_t i = 0; i < m_events.size(); ++i)
+        {
+            const InputEvent& event = m_events[i];
 
+            if (event.type == Event_KeyDown)
+            {
+                KeyEvent keypress{};
+                keypress.event = event.repeat ? Repeat : Pressed;
+                keypress.key = event.key;
 
-App::ControllerState App::controller_state(int controller)
-{
-    ControllerState state{};
-    ::ControllerState* lowlevel_state = &_controller_states[controller];
-
-    if (lowlevel_state->connected)
-    {
-        state.lx = lowlevel_state->current_state.sThumbLX < 0 ? lowlevel_state->current_state.sThumbLX / 32768.0f :
-                                                                lowlevel_state->current_state.sThumbLX / 32767.0f;
-        state.ly = lowlevel_state->current_state.sThumbLY < 0 ? lowlevel_state->current_state.sThumbLY / 32768.0f :
-                                                                lowlevel_state->current_state.sThumbLY / 32767.0f;
-        state.rx = lowlevel_state->current_state.sThumbRX < 0 ? lowlevel_state->current_state.sThumbRX / 32768.0f :
-                                                                lowlevel_state->current_state.sThumbRX / 32767.0f;
-        state.ry = lowlevel_state->current_state.sThumbRY < 0 ? lowlevel_state->current_state.sThumbRY / 32768.0f :
-                                                                lowlevel_state->current_state.sThumbRY / 32767.0f;
-        state.lt = lowlevel_state->current_state.bLeftTrigger / 255.0f;
-        state.rt = lowlevel_state->current_state.bRightTrigger / 255.0f;
-        
-        for (int i = 0; i < 16; ++i)
-        {
-            WORD button_mask = (1 << i);
-            state.buttons[i].down = (lowlevel_state->current_state.wButtons & button_mask);
-            state.buttons[i].pressed = state.buttons[i].down && (lowlevel_state->prev_state.wButtons & button_mask) == 0;
-            state.buttons[i].released = !state.buttons[i].down && (lowlevel_state->prev_state.wButtons & button_mask);
-        }
-    }
+                // The character a key types is translated from its message and arrives straight after it
+                if (i + 1 < m_events.size() && m_events[i + 1].type == Event_Char && m_events[i + 1].value >= ' ' &&
+                    m_events[i + 1].value < 127)
+                {
+                    keypress.ascii_code = (char)m_events[i + 1].value;
+                }
 
-    return state;
-}
+                handler(keypress);
+            }
+            else if (event.type == Event_KeyUp)
+            {
+                KeyEvent keypress{};
+                keypress.event = Released;
+                keypress.key = event.key;
+                handler(keypress);
+            }
+        }
 
+        return;
+    }
 
-// TODO: Repeat events - wire directly to windows keyboard events instead of synthesizing these from key states
-void App::process_key_events(KeyEventHandler handler)
-{
     static const std::unordered_map<Key, std::pair<char, char>> ascii_map{
         { Key_BackTick, { '`', '~' } },     { Key_Minus, { '-', '_' } },      { Key_Equals, { '=', '+' } },    { Key_LeftBracket, { '[', '{' } },
         { Key_RightBracket, { ']', '}' } }, { Key_Backslash, { '\\', '|' } }, { Key_Semicolon, { ';', ':' } }, { Key_Apostrophe, { '\'', '"' } },
@@ -571,12 +396,39 @@ int App::screen_height()
     return m_screen_height;
 }
 
+
+FramebufferFormat App::framebuffer_format()
+{
+    return m_framebuffer_format;
+}
+
+
+void App::set_frame_limit(int fps)
+{
+    m_frame_timer.set_frame_limit(fps);
+}
+
+
+FrameStats App::frame_stats() const
+{
+    return m_frame_timer.stats();
+}
+
+
+void App::show_profile_overlay(bool show)
+{
+    m_profile_overlay = show;
+}
+
+
 void App::set_palette(uint32_t rgbx[256])
 {
     for (int p = 0; p < 256; ++p)
     {
         m_palette[p] = 0xFF000000 | (rgbx[p] & 0x00FFFFFF);
     }
+
+    m_palette_dirty = true;
 }
 
 
@@ -592,6 +444,8 @@ void App::set_palette(const uint8_t* palette, int size)
         dest->a = 0xFF;
         dest++;
     }
+
+    m_palette_dirty = true;
 }
 
 
@@ -612,13 +466,21 @@ void App::load_palette(const std::string& path)
 
 void App::clear_screen(uint8_t c)
 {
-    clear_screen(m_palette[c]);
+    DrawCommand command{};
+    command.type = DrawCommand::Clear;
+    command.fg = palette_color(c);
+    submit(command);
 }
 
 
 void App::set_pixel(int x, int y, uint8_t p)
 {
-    set_pixel(x, y, m_palette[p]);
+    DrawCommand command{};
+    command.type = DrawCommand::SetPixel;
+    command.x = x;
+    command.y = y;
+    command.fg = palette_color(p);
+    submit(command);
 }
 
 
@@ -627,208 +489,117 @@ void App::set_blend_mode(BlendMode src_blend, BlendMode dest_blend, uint8_t cons
     m_src_blend = src_blend;
     m_dest_blend = dest_blend;
     m_blend_constant = constant;
+    m_blend_kernel = get_blend_kernel(m_src_blend, m_dest_blend, m_blend_op);
 }
 
 
 void App::set_blend_op(BlendOp op)
 {
     m_blend_op = op;
+    m_blend_kernel = get_blend_kernel(m_src_blend, m_dest_blend, m_blend_op);
 }
 
 
 void App::clear_screen(Pixel p)
 {
-    Pixel* pixel = m_framebuffer;
-
-    for (int y = 0; y < m_screen_height; ++y)
+    if (direct_framebuffer("App::clear_screen"))
     {
-        for (int x = 0; x < m_screen_width; ++x)
-        {
-            *pixel++ = p;
-        }
+        DrawCommand command{};
+        command.type = DrawCommand::Clear;
+        command.fg = p.argb;
+        submit(command);
     }
 }
 
 
 void App::set_pixel(int x, int y, Pixel p)
 {
-    if (x >= 0 && x < m_screen_width && y >= 0 && y < m_screen_height)
+    if (direct_framebuffer("App::set_pixel"))
     {
-        if (m_blend_op == None)
-        {
-            m_framebuffer[(y * m_screen_width) + x] = p;
-        }
-        else
-        {
-            Pixel dest = m_framebuffer[(y * m_screen_width) + x];
-
-            auto alpha_factor = [](BlendMode mode, uint8_t src_alpha, uint8_t dest_alpha, uint8_t constant_alpha) -> float {
-                if (mode == BlendMode::Zero)
-                {
-                    return 0.0f;
-                }
-                else if (mode == BlendMode::SrcAlpha)
-                {
-                    return src_alpha / 255.0f;
-                }
-                else if (mode == BlendMode::InvSrcAlpha)
-                {
-                    return 1.0f - (src_alpha / 255.0f);
-                }
-                else if (mode == BlendMode::DestAlpha)
-                {
-                    return dest_alpha / 255.0f;
-                }
-                else if (mode == BlendMode::InvDestAlpha)
-                {
-                    return 1.0f - (dest_alpha / 255.0f);
-                }
-                else if (mode == BlendMode::Constant)
-                {
-                    return constant_alpha;
-                }
-                else
-                {
-                    return 1.0f;
-                }
-            };
-
-            float sa = alpha_factor(m_src_blend, p.a, dest.a, m_blend_constant);
-            float da = alpha_factor(m_dest_blend, p.a, dest.a, m_blend_constant);
-
-            float sr = p.r / 255.0f;
-            float sg = p.g / 255.0f;
-            float sb = p.b / 255.0f;
-            float dr = dest.r / 255.0f;
-            float dg = dest.g / 255.0f;
-            float db = dest.b / 255.0f;
-            float r = sr;
-            float g = sg;
-            float b = sb;
-
-            if (m_blend_op == BlendOp::Add)
-            {
-                r = sr * sa + dr * da;
-                g = sg * sa + dg * da;
-                b = sb * sa + db * da;
-            }
-            else if (m_blend_op == BlendOp::Multiply)
-            {
-                r = sr * sa * dr * da;
-                g = sg * sa * dg * da;
-                b = sb * sa * db * da;
-            }
-            else if (m_blend_op == BlendOp::Subtract)
-            {
-                r = sr * sa - dr * da;
-                g = sg * sa - dg * da;
-                b = sb * sa - db * da;
-            }
-
-            auto comp = [](float f) -> uint8_t {
-                f = (f < 0.0f) ? 0.0f : ((f > 1.0f) ? 1.0f : f);
-                return (uint8_t)std::floor(f * 255.0f + 0.5f);
-            };
-
-            m_framebuffer[(y * m_screen_width) + x] = Pixel(comp(r), comp(g), comp(b), comp(sa));
-        }
+        DrawCommand command{};
+        command.type = DrawCommand::SetPixel;
+        command.x = x;
+        command.y = y;
+        command.fg = p.argb;
+        submit(command);
     }
 }
 
 
 void App::draw_line(int x1, int y1, int x2, int y2, uint8_t c)
 {
-    draw_line(x1, y1, x2, y2, m_palette[c]);
+    submit_line(x1, y1, x2, y2, palette_color(c));
 }
 
 
 void App::draw_line(int x1, int y1, int x2, int y2, Pixel p)
 {
-    int delta_x = x2 - x1;
-    int delta_y = y2 - y1;
-    int step_x = delta_x > 0 ? 1 : (delta_x < 0 ? -1 : 0);
-    int step_y = delta_y > 0 ? 1 : (delta_y < 0 ? -1 : 0);
-
-    if ((delta_x * step_x) > (delta_y * step_y))
+    if (direct_framebuffer("App::draw_line"))
     {
-        // x-major
-        int y = y1;
-        int error = 0;
-
-        for (int x = x1; x != x2; x += step_x)
-        {
-            set_pixel(x, y, p);
-
-            error += step_y * delta_y;
-
-            if ((error * 2) >= step_x * delta_x)
-            {
-                y += step_y;
-                error -= step_x * delta_x;
-            }
-        }
+        submit_line(x1, y1, x2, y2, p.argb);
     }
-    else
-    {
-        // y-major
-        int x = x1;
-        int error = 0;
-
-        for (int y = y1; y != y2; y += step_y)
-        {
-            set_pixel(x, y, p);
+}
 
-            error += step_x * delta_x;
 
-            if ((error * 2) >= step_y * delta_y)
-            {
-                x += step_x;
-                error -= step_y * delta_y;
-            }
-        }
+// The glyph array calls usually draw with one font, so remembering the last one skips the lock in Font::from_glyphs
+const Font& App::glyph_font(const int* glyphs, int w, int h)
+{
+    if (!m_glyph_font || glyphs != m_glyph_font_glyphs || w != m_glyph_font->glyph_width() || h != m_glyph_font->glyph_height())
+    {
+        m_glyph_font = &Font::from_glyphs(glyphs, w, h);
+        m_glyph_font_glyphs = glyphs;
     }
+
+    return *m_glyph_font;
 }
 
 
 void App::draw_char(int x, int y, char c, const int* glyphs, int w, int h, uint8_t fg, uint8_t bg)
 {
-    uint8_t colors[2] = { bg, fg };
-    const int* glyph = glyphs + c * w * h;
-
-    for (int py = 0; py < h; ++py)
-    {
-        for (int px = 0; px < w; ++px)
-        {
-            set_pixel(x + px, y + py, colors[glyph[py * w + px]]);
-        }
-    }
+    submit_glyphs(x, y, &c, 1, glyph_font(glyphs, w, h), palette_color(fg), palette_color(bg));
 }
 
 
 void App::draw_string(int x, int y, const char* str, const int* glyphs, int w, int h, uint8_t fg, uint8_t bg)
 {
-    draw_string(x, y, str, glyphs, w, h, m_palette[fg], m_palette[bg]);
+    draw_string(x, y, str, glyph_font(glyphs, w, h), fg, bg);
 }
 
 
 void App::draw_string(int x, int y, const char* str, const int* glyphs, int w, int h, Pixel fg, Pixel bg)
 {
-    Pixel colors[2] = { bg, fg };
+    draw_string(x, y, str, glyph_font(glyphs, w, h), fg, bg);
+}
 
-    for (const char* c = str; *c; ++c)
+
+// Formats into a stack buffer, or into overflow for the rare string that doesn't fit
+template <typename Color>
+void App::vformat_string(int x, int y, const Font& font, Color fg, Color bg, const char* fmt, va_list args)
+{
+    char buffer[256];
+    std::string overflow;
+    va_list args_copy;
+    va_copy(args_copy, args);
+    int len = vsnprintf(buffer, sizeof(buffer), fmt, args_copy);
+    va_end(args_copy);
+
+    if (len < 0)
     {
-        const int* glyph = glyphs + *c * w * h;
+        return;
+    }
 
-        for (int py = 0; py < h; ++py)
-        {
-            for (int px = 0; px < w; ++px)
-            {
-                set_pixel(x + px, y + py, colors[glyph[py * w + px]]);
-            }
-        }
+    const char* str = buffer;
 
-        x += w;
+    if (len >= (int)sizeof(buffer))
+    {
+        overflow.resize(len + 1);
+        va_copy(args_copy, args);
+        vsnprintf(&overflow[0], overflow.size(), fmt, args_copy);
+        va_end(args_copy);
+        str = overflow.c_str();
     }
+
+    draw_string(x, y, str, font, fg, bg);
 }
 
 
@@ -836,23 +607,8 @@ void App::format_string(int x, int y, const int* glyphs, int w, int h, uint8_t f
 {
     va_list args;
     va_start(args, fmt);
-    int len = vsnprintf(nullptr, 0, fmt, args) + 1;
-    va_end(args);
-
-    char* buf = (char*)_malloca(len);
-
-    if (!buf)
-    {
-        return;
-    }
-
-    va_start(args, fmt);
-    vsnprintf(buf, len, fmt, args);
+    vformat_string(x, y, glyph_font(glyphs, w, h), fg, bg, fmt, args);
     va_end(args);
-
-    draw_string(x, y, buf, glyphs, w, h, fg, bg);
-
-    _freea(buf);
 }
 
 
@@ -860,111 +616,114 @@ void App::format_string(int x, int y, const int* glyphs, int w, int h, Pixel fg,
 {
     va_list args;
     va_start(args, fmt);
-    int len = vsnprintf(nullptr, 0, fmt, args) + 1;
+    vformat_string(x, y, glyph_font(glyphs, w, h), fg, bg, fmt, args);
     va_end(args);
+}
+
+
+void App::draw_string(int x, int y, const char* str, const Font& font, uint8_t fg, uint8_t bg)
+{
+    submit_glyphs(x, y, str, (int)strlen(str), font, palette_color(fg), palette_color(bg));
+}
 
-    char* buf = (char*)_malloca(len);
 
-    if (!buf)
+void App::draw_string(int x, int y, const char* str, const Font& font, Pixel fg, Pixel bg)
+{
+    if (direct_framebuffer("App::draw_string"))
     {
-        return;
+        submit_glyphs(x, y, str, (int)strlen(str), font, fg.argb, bg.argb);
     }
+}
 
+
+void App::format_string(int x, int y, const Font& font, uint8_t fg, uint8_t bg, const char* fmt, ...)
+{
+    va_list args;
     va_start(args, fmt);
-    vsnprintf(buf, len, fmt, args);
+    vformat_string(x, y, font, fg, bg, fmt, args);
     va_end(args);
+}
 
-    draw_string(x, y, buf, glyphs, w, h, fg, bg);
 
-    _freea(buf);
+void App::format_string(int x, int y, const Font& font, Pixel fg, Pixel bg, const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    vformat_string(x, y, font, fg, bg, fmt, args);
+    va_end(args);
 }
 
 
 void App::draw_rect(int x, int y, int w, int h, uint8_t c)
 {
-    for (int px = 0; px < w; ++px)
-    {
-        set_pixel(x + px, y, c);
-        set_pixel(x + px, y + h - 1, c);
-    }
+    submit_rect(x, y, w, h, palette_color(c));
+}
+
 
-    for (int py = 0; py < h; ++py)
+void App::draw_rect(int x, int y, int w, int h, Pixel c)
+{
+    if (direct_framebuffer("App::draw_rect"))
     {
-        set_pixel(x, y + py, c);
-        set_pixel(x + w - 1, y + py, c);
+        submit_rect(x, y, w, h, c.argb);
     }
 }
 
 
 void App::fill_rect(int x, int y, int w, int h, int bw, uint8_t fg, uint8_t bg)
 {
-    Pixel pfg = 0xFF000000 | *(uint32_t*)&m_palette[fg];
-    Pixel pbg = 0xFF000000 | *(uint32_t*)&m_palette[bg];
-    fill_rect(x, y, w, h, bw, pfg, pbg);
+    submit_fill_rect(x, y, w, h, bw, palette_color(fg), palette_color(bg));
 }
 
 
 void App::fill_rect(int x, int y, int w, int h, int bw, Pixel fg, Pixel bg)
 {
-    Pixel colors[2] = { fg, bg };
-
-    for (int py = 0; py < h; ++py)
+    if (direct_framebuffer("App::fill_rect"))
     {
-        for (int px = 0; px < w; ++px)
-        {
-            int color_index = (px < bw || px > w - 1 - bw || py < bw || py > h - 1 - bw);
-            set_pixel(x + px, y + py, colors[color_index]);
-        }
+        submit_fill_rect(x, y, w, h, bw, fg.argb, bg.argb);
     }
 }
 
 
 void App::copy_rect(int x, int y, int w, int h, const uint8_t* src, uint32_t stride)
 {
-#if 0 // UNTESTED
-    if (y < 0)
+    if (w <= 0 || h <= 0)
     {
-        src += stride * -y;
-        h += y;
-        y = 0;
+        return;
     }
 
-    if (x < 0)
-    {
-        src += x;
-        w += x;
-        x = 0;
-    }
+    DrawCommand command{};
+    command.type = DrawCommand::CopyRect;
+    command.x = x;
+    command.y = y;
+    command.w = w;
+    command.h = h;
+    command.param = (int)stride;
+    command.data = src;
+    command.palette = m_palette;
+    submit(command, src, (size_t)stride * (h - 1) + w);
+}
 
-    w = (x + w < screen_width) ? w : (screen_width - x);
-    h = (y + h < screen_height) ? h : (screen_height - y);
 
-    if (w <= 0 || h <= 0)
+void App::copy_rect_scaled(int x, int y, int w, int h, const uint8_t* src, uint32_t stride, int pixel_scale)
+{
+    if (w <= 0 || h <= 0 || pixel_scale <= 0)
     {
         return;
     }
 
-    uint8_t* dest = m_framebuffer + (x + y * screen_width) * 3;
-
-    for (int y = 0; y < h; ++y)
-    {
-        for (int x = 0; x < w; ++x)
-        {
-            uint8_t p = src[x];
-            RGBQUAD color = m_palette[p];
-            dest[x * 3 + 0] = color.rgbRed;
-            dest[x * 3 + 1] = color.rgbGreen;
-            dest[x * 3 + 2] = color.rgbBlue;
-        }
-
-        dest += screen_width * 3;
-        src += stride;
-    }
-#endif
+    DrawCommand command{};
+    command.type = DrawCommand::CopyRectScaled;
+    command.x = x;
+    command.y = y;
+    command.w = w * pixel_scale;
+    command.h = h * pixel_scale;
+    command.ox = pixel_scale;
+    command.param = (int)stride;
+    command.data = src;
+    command.palette = m_palette;
+    submit(command, src, (size_t)stride * (h - 1) + w);
 }
 
-void App::copy_rect_scaled(int x, int y, int w, int h, const uint8_t* src, uint32_t stride, int pixel_scale) {}
-
 
 void App::draw_sprite(int x, int y, const Sprite* sprite)
 {
@@ -974,535 +733,824 @@ void App::draw_sprite(int x, int y, const Sprite* sprite)
 
 void App::draw_partial_sprite(int x, int y, const Sprite* sprite, int ox, int oy, int w, int h)
 {
-    if (x + w < 0 || y + w < 0 || x >= m_screen_width || y >= m_screen_height)
+    if (direct_framebuffer("App::draw_partial_sprite"))
     {
-        return;
+        DrawCommand command{};
+        command.type = DrawCommand::Sprite;
+        command.x = x;
+        command.y = y;
+        command.w = w;
+        command.h = h;
+        command.ox = ox;
+        command.oy = oy;
+        command.data = sprite;
+        submit(command);
     }
+}
 
-    if (x < 0)
-    {
-        ox -= x;
-        w += x;
-        x = 0;
-    }
 
-    if (y < 0)
-    {
-        oy -= y;
-        h += y;
-        y = 0;
-    }
+void App::blend_sprite(int x, int y, const Sprite& sprite, uint8_t alpha)
+{
+    blend_partial_sprite(x, y, sprite, 0, 0, sprite.width(), sprite.height(), alpha);
+}
 
-    if (x > m_screen_width - w)
-    {
-        w = m_screen_width - x;
-    }
 
-    if (y > m_screen_height - h)
+void App::blend_partial_sprite(int x, int y, const Sprite& sprite, int ox, int oy, int w, int h, uint8_t alpha)
+{
+    if (direct_framebuffer("App::blend_partial_sprite"))
     {
-        h = m_screen_height - y;
+        DrawCommand command{};
+        command.type = DrawCommand::BlendSprite;
+        command.x = x;
+        command.y = y;
+        command.w = w;
+        command.h = h;
+        command.ox = ox;
+        command.oy = oy;
+        command.alpha = alpha;
+        command.data = &sprite;
+        submit(command);
     }
+}
 
-    if (w > 0 && h > 0)
-    {
-        Pixel* src = sprite->pixels() + ox + (oy * sprite->width());
-        Pixel* dest = m_framebuffer + x + (y * m_screen_width);
 
-        while (h--)
-        {
-            memcpy(dest, src, sizeof(Pixel) * w);
-            src += sprite->width();
-            dest += m_screen_width;
-        }
+void App::draw_sprite_scaled(int x, int y, int w, int h, const Sprite& sprite, SpriteFilter filter)
+{
+    draw_partial_sprite_scaled(x, y, w, h, sprite, 0, 0, sprite.width(), sprite.height(), filter);
+}
+
+
+void App::draw_partial_sprite_scaled(int x, int y, int w, int h, const Sprite& sprite, int ox, int oy, int sw, int sh,
+                                     SpriteFilter filter)
+{
+    if (w <= 0 || h <= 0 || sw <= 0 || sh <= 0 || !direct_framebuffer("App::draw_partial_sprite_scaled"))
+    {
+        return;
     }
+
+    // Destination pixel centres step evenly across the source, starting half a step in
+    SpriteTransform transform{};
+    transform.sprite = &sprite;
+    transform.sx = ox;
+    transform.sy = oy;
+    transform.sw = sw;
+    transform.sh = sh;
+    transform.du_dx = (int)(((int64_t)sw << 16) / w);
+    transform.dv_dy = (int)(((int64_t)sh << 16) / h);
+    transform.u = transform.du_dx / 2;
+    transform.v = transform.dv_dy / 2;
+    transform.filter = filter;
+    submit_sprite_transform(x, y, w, h, transform);
 }
 
 
-void App::blend_sprite(int x, int y, const Sprite& sprite, uint8_t alpha)
+void App::draw_sprite_transformed(float x, float y, const Sprite& sprite, float angle, float scale_x, float scale_y, SpriteFilter filter)
 {
-    blend_partial_sprite(x, y, sprite, 0, 0, sprite.width(), sprite.height(), alpha);
+    draw_partial_sprite_transformed(x, y, sprite, 0, 0, sprite.width(), sprite.height(), angle, scale_x, scale_y, filter);
 }
 
 
-void App::blend_partial_sprite(int x, int y, const Sprite& sprite, int ox, int oy, int w, int h, uint8_t alpha)
+void App::draw_partial_sprite_transformed(float x, float y, const Sprite& sprite, int ox, int oy, int w, int h, float angle,
+                                          float scale_x, float scale_y, SpriteFilter filter)
 {
-    if (x + w < 0 || y + w < 0 || x >= m_screen_width || y >= m_screen_height)
+    if (w <= 0 || h <= 0 || scale_x == 0.0f || scale_y == 0.0f || !direct_framebuffer("App::draw_partial_sprite_transformed"))
     {
         return;
     }
 
-    if (x < 0)
+    double c = cos((double)angle);
+    double s = sin((double)angle);
+    double half_w = w * 0.5;
+    double half_h = h * 0.5;
+
+    // Half the size of the transformed rectangle's bounding box. The bounds are cut down to the clip rectangle here, so the fixed
+    // point start position stays in range however far the sprite reaches off screen.
+    double extent_x = fabs(c * scale_x * half_w) + fabs(s * scale_y * half_h);
+    double extent_y = fabs(s * scale_x * half_w) + fabs(c * scale_y * half_h);
+    double x0 = std::max(floor(x - extent_x), (double)m_clip.x0);
+    double y0 = std::max(floor(y - extent_y), (double)m_clip.y0);
+    double x1 = std::min(ceil(x + extent_x), (double)m_clip.x1);
+    double y1 = std::min(ceil(y + extent_y), (double)m_clip.y1);
+
+    if (x0 >= x1 || y0 >= y1)
     {
-        ox -= x;
-        w += x;
-        x = 0;
+        return;
     }
 
-    if (y < 0)
+    // The inverse transform, from destination pixel centres back to source pixels
+    double du_dx = c / scale_x;
+    double du_dy = s / scale_x;
+    double dv_dx = -s / scale_y;
+    double dv_dy = c / scale_y;
+    double dx = x0 + 0.5 - x;
+    double dy = y0 + 0.5 - y;
+    double u = du_dx * dx + du_dy * dy + half_w;
+    double v = dv_dx * dx + dv_dy * dy + half_h;
+
+    // 16.16 fixed point only reaches 32768, which the steps pass once a scale drops below 1 / 32768 and the start position can pass
+    // for a huge scale far off the sprite. There's nothing sensible to draw either way.
+    static const double FixedLimit = 32767.0;
+
+    if (std::max({ fabs(u), fabs(v), fabs(du_dx), fabs(du_dy), fabs(dv_dx), fabs(dv_dy) }) > FixedLimit)
     {
-        oy -= y;
-        h += y;
-        y = 0;
+        return;
     }
 
-    if (x > m_screen_width - w)
+    auto fixed = [](double value) { return (int)llround(value * 65536.0); };
+
+    SpriteTransform transform{};
+    transform.sprite = &sprite;
+    transform.sx = ox;
+    transform.sy = oy;
+    transform.sw = w;
+    transform.sh = h;
+    transform.u = fixed(u);
+    transform.v = fixed(v);
+    transform.du_dx = fixed(du_dx);
+    transform.dv_dx = fixed(dv_dx);
+    transform.du_dy = fixed(du_dy);
+    transform.dv_dy = fixed(dv_dy);
+    transform.filter = filter;
+    submit_sprite_transform((int)x0, (int)y0, (int)(x1 - x0), (int)(y1 - y0), transform);
+}
+
+
+// Clips a partial draw of an atlas handle to its rectangle, and makes ox and oy page coordinates
+static bool clip_to_handle(const AtlasHandle& handle, int& x, int& y, int& ox, int& oy, int& w, int& h)
+{
+    if (ox < 0)
     {
-        w = m_screen_width - x;
+        x -= ox;
+        w += ox;
+        ox = 0;
     }
 
-    if (y > m_screen_height - h)
+    if (oy < 0)
     {
-        h = m_screen_height - y;
+        y -= oy;
+        h += oy;
+        oy = 0;
     }
 
-    if (w >= 0 && h >= 0)
+    w = std::min(w, handle.w - ox);
+    h = std::min(h, handle.h - oy);
+    ox += handle.x;
+    oy += handle.y;
+    return w > 0 && h > 0;
+}
+
+
+void App::draw_sprite(int x, int y, const SpriteAtlas& atlas, AtlasHandle handle)
+{
+    draw_partial_sprite(x, y, &atlas.page(handle), handle.x, handle.y, handle.w, handle.h);
+}
+
+
+void App::draw_partial_sprite(int x, int y, const SpriteAtlas& atlas, AtlasHandle handle, int ox, int oy, int w, int h)
+{
+    if (clip_to_handle(handle, x, y, ox, oy, w, h))
     {
-        Pixel* src = sprite.pixels() + ox + (oy * sprite.width());
-        Pixel* dest = m_framebuffer + x + (y * m_screen_width);
-        const float denom = 1.0f / 255.0f;
+        draw_partial_sprite(x, y, &atlas.page(handle), ox, oy, w, h);
+    }
+}
 
-        while (h--)
-        {
-            for (int i = 0; i < w; ++i)
-            {
-                float sr = src[i].r * denom;
-                float sg = src[i].g * denom;
-                float sb = src[i].b * denom;
-                float dr = dest[i].r * denom;
-                float dg = dest[i].g * denom;
-                float db = dest[i].b * denom;
-                float w = alpha * denom * src[i].a * denom;
-                float r = (sr * w) + dr * (1.0f - w);
-                float g = (sg * w) + dg * (1.0f - w);
-                float b = (sb * w) + db * (1.0f - w);
-
-                dest[i].r = r < 0.0f ? 0 : (r > 1.0f ? 255 : (uint8_t)(r * 255.0f));
-                dest[i].g = g < 0.0f ? 0 : (g > 1.0f ? 255 : (uint8_t)(g * 255.0f));
-                dest[i].b = b < 0.0f ? 0 : (b > 1.0f ? 255 : (uint8_t)(b * 255.0f));
-                dest[i].a = 255;
-            }
 
-            src += sprite.width();
-            dest += m_screen_width;
-        }
+void App::blend_sprite(int x, int y, const SpriteAtlas& atlas, AtlasHandle handle, uint8_t alpha)
+{
+    blend_partial_sprite(x, y, atlas.page(handle), handle.x, handle.y, handle.w, handle.h, alpha);
+}
+
+
+void App::blend_partial_sprite(int x, int y, const SpriteAtlas& atlas, AtlasHandle handle, int ox, int oy, int w, int h, uint8_t alpha)
+{
+    if (clip_to_handle(handle, x, y, ox, oy, w, h))
+    {
+        blend_partial_sprite(x, y, atlas.page(handle), ox, oy, w, h, alpha);
     }
 }
 
 
-void App::set_screen_fade(Pixel color, float fade)
+void App::draw_sprite_scaled(int x, int y, int w, int h, const SpriteAtlas& atlas, AtlasHandle handle, SpriteFilter filter)
 {
-    m_fade_color = color;
-    m_fade = fade;
+    draw_partial_sprite_scaled(x, y, w, h, atlas.page(handle), handle.x, handle.y, handle.w, handle.h, filter);
 }
 
 
-Pixel* App::get_framebuffer()
+void App::draw_sprite_transformed(float x, float y, const SpriteAtlas& atlas, AtlasHandle handle, float angle, float scale_x,
+                                  float scale_y, SpriteFilter filter)
 {
-    return m_framebuffer;
+    draw_partial_sprite_transformed(x, y, atlas.page(handle), handle.x, handle.y, handle.w, handle.h, angle, scale_x, scale_y,
+                                    filter);
 }
 
 
-void App::request_screenshot(const std::string& directory)
+void App::push_target(Surface& surface)
 {
-    m_screenshot_requested = true;
-    m_screenshot_directory = directory;
+    gliAssert(m_framebuffer_format == Framebuffer_Direct);
+    flush_draws();
+
+    m_target_stack.push_back({ m_target, m_clip, m_clip_stack.size() });
+    m_target = &surface;
+    m_clip = { 0, 0, surface.width(), surface.height() };
+
+    // The runs are about to be out of date
+    surface.drop_runs();
+    ++surface.m_generation;
 }
 
 
-void App::on_render(float delta)
+void App::pop_target()
 {
-    if (m_fade > 0.0f)
-    {
-        glClearColor(m_fade_color.r / 255.0f, m_fade_color.g / 255.0f, m_fade_color.b / 255.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    }
-    else
-    {
-        glDisable(GL_BLEND);
-    }
+    gliAssert(!m_target_stack.empty());
+
+    const TargetState& state = m_target_stack.back();
+    m_target->m_stale = false;
+    m_target = state.target;
+    m_clip = state.clip;
+    m_clip_stack.resize(state.clip_depth);
+    m_target_stack.pop_back();
+}
 
-    glBindTexture(GL_TEXTURE_2D, _texture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_screen_width, m_screen_height, 0, GL_BGRA, GL_UNSIGNED_BYTE, m_framebuffer);
-    glUseProgram(_shader_program);
-    glUniform1f(_uniform_fade, 1.0f - m_fade);
-    glBindVertexArray(_vao);
-    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+void App::push_clip(int x, int y, int w, int h)
+{
+    m_clip_stack.push_back(m_clip);
+
+    // Kept valid, an empty clip is x1 == x0 or y1 == y0
+    m_clip.x0 = std::min(std::max(x, m_clip.x0), m_clip.x1);
+    m_clip.y0 = std::min(std::max(y, m_clip.y0), m_clip.y1);
+    m_clip.x1 = std::max(std::min(x + w, m_clip.x1), m_clip.x0);
+    m_clip.y1 = std::max(std::min(y + h, m_clip.y1), m_clip.y0);
 }
 
 
-void App::shutdown()
+void App::pop_clip()
 {
-    glDeleteTextures(1, &_texture);
-    glDeleteVertexArrays(1, &_vao);
-    glDeleteBuffers(1, &_vbo);
-    glDeleteProgram(_shader_program);
+    gliAssert(m_clip_stack.size() > (m_target_stack.empty() ? 0 : m_target_stack.back().clip_depth));
 
-    delete[] m_framebuffer;
+    m_clip = m_clip_stack.back();
+    m_clip_stack.pop_back();
+}
 
-    for (int i = 0; i < 2; ++i)
-    {
-        delete[] m_keystate[i];
-    }
 
-    UnregisterClass(L"IneptEngineWindow", GetModuleHandle(NULL));
+int App::target_width()
+{
+    return m_target ? m_target->width() : m_screen_width;
+}
+
 
-    free(m_title);
+int App::target_height()
+{
+    return m_target ? m_target->height() : m_screen_height;
 }
 
 
-void App::pump_messages()
+RenderLayer& App::add_layer(int width, int height)
 {
-    MSG msg;
+    gliAssert(m_framebuffer_format == Framebuffer_Direct);
 
-    while (GetMessageW(&msg, 0, 0, 0) > 0)
+    if (!m_layers)
     {
-        if (msg.message == WM_QUIT)
-        {
-            break;
-        }
+        m_layers = new LayerCompositor();
+        m_layers->reset(m_screen_width, m_screen_height);
+    }
 
-        TranslateMessage(&msg);
-        DispatchMessageW(&msg);
+    return m_layers->add(width, height);
+}
 
-        if (!!_hide_cursor != _cursor_hidden)
-        {
-            _cursor_hidden = !!_hide_cursor;
-            ShowCursor(!_cursor_hidden);
-        }
-    }
+
+void App::remove_layers()
+{
+    delete m_layers;
+    m_layers = nullptr;
+}
+
+
+int App::layer_count() const
+{
+    return m_layers ? m_layers->count() : 0;
 }
 
 
-void App::engine_loop()
+RenderLayer& App::layer(int index)
 {
-    _opengl.make_current(true);
-    if (!on_create())
+    gliAssert(index >= 0 && index < layer_count());
+    return m_layers->layer(index);
+}
+
+
+void App::composite_layers()
+{
+    if (!m_layers || m_layers->count() == 0)
     {
-        _quit = true;
+        return;
     }
-    _opengl.make_current(false);
 
-    ShowWindow(m_hwnd, SW_SHOW);
-    auto prev_time = std::chrono::system_clock::now();
+    GLI_PROFILE_SCOPE("App::composite_layers");
+    const Pixel* background = m_layers->background();
 
-    while (!_quit)
+    if (m_layers->update())
     {
-        auto current_time = std::chrono::system_clock::now();
-        std::chrono::duration<float> elapsed_time = current_time - prev_time;
-        prev_time = current_time;
-        float delta = elapsed_time.count();
+        memcpy(m_framebuffer, background, sizeof(Pixel) * m_screen_width * m_screen_height);
+        m_dirty.add_all();
+        return;
+    }
 
-        wchar_t title[256];
-        swprintf(title, 256, L"%s - %llu us (%0.2f fps)", m_title, uint64_t(delta * 1000000.0), 1.0f / delta);
-        SetWindowText(m_hwnd, title);
+    // Nothing under the screen changed, so only what was drawn over it last frame needs putting back
+    for (int i = 0; i < m_presented.count(); ++i)
+    {
+        const DirtyRect& rect = m_presented.rects()[i];
+        size_t start = rect.x0 + (size_t)rect.y0 * m_screen_width;
 
-        if (_active)
+        for (int y = rect.y0; y < rect.y1; ++y, start += m_screen_width)
         {
-            short* current_keystate = m_keystate[m_current_keystate];
-            short* prev_keystate = m_keystate[m_current_keystate ^ 1];
+            memcpy(m_framebuffer + start, background + start, sizeof(Pixel) * (rect.x1 - rect.x0));
+        }
 
-            for (int i = 0; i < Key_Count; i++)
-            {
-                current_keystate[i] = GetAsyncKeyState(m_keymap[i]);
+        m_dirty.add(rect.x0, rect.y0, rect.x1, rect.y1);
+    }
+}
 
-                m_keys[i].pressed = false;
-                m_keys[i].released = false;
 
-                if (current_keystate[i] != prev_keystate[i])
-                {
-                    if (current_keystate[i] & 0x8000)
-                    {
-                        m_keys[i].pressed = !m_keys[i].down;
-                        m_keys[i].down = true;
-                    }
-                    else
-                    {
-                        m_keys[i].released = true;
-                        m_keys[i].down = false;
-                    }
-                }
-            }
+void App::set_deferred_drawing(bool deferred)
+{
+    flush_draws();
+    delete m_draw_list;
+    m_draw_list = nullptr;
 
-            m_current_keystate ^= 1;
-        }
+    if (deferred)
+    {
+        m_draw_list = new DrawList();
+        m_draw_list->reset(m_screen_width, m_screen_height);
+    }
+}
 
-        MouseState new_mouse_state = _mouse_state.load();
 
-        if (!_mouse_active)
+void App::flush_draws()
+{
+    if (m_draw_list && !m_draw_list->empty())
+    {
+        DirtyRect screen{ 0, 0, m_screen_width, m_screen_height };
+
+        if (m_framebuffer_format == Framebuffer_Indexed)
         {
-            m_mouse.x = 0;
-            m_mouse.y = 0;
-            m_mouse.wheel = 0;
+            m_draw_list->replay(raster(m_indexed_framebuffer, m_screen_width, screen));
         }
         else
         {
-            m_mouse.x = new_mouse_state.x;
-            m_mouse.y = new_mouse_state.y;
-            m_mouse.wheel = _mouse_wheel.exchange(0);
+            m_draw_list->replay(raster(m_framebuffer, m_screen_width, screen));
+        }
+    }
+}
 
-            static const int VkMouseButtons[3] = { VK_LBUTTON, VK_MBUTTON, VK_RBUTTON };
 
-            for (int i = 0; i < 3; ++i)
-            {
-                short state = GetAsyncKeyState(VkMouseButtons[i]);
-                bool was_down = m_mouse.buttons[i].down;
-                bool is_down = state & 0x8000;
-                m_mouse.buttons[i].down = is_down;
-                m_mouse.buttons[i].pressed = is_down && !was_down;
-                m_mouse.buttons[i].released = was_down && !is_down;
-            }
-        }
+void App::set_screen_fade(Pixel color, float fade)
+{
+    m_fade_color = color;
+    m_fade = fade;
+}
 
-        bool poll_controllers = _poll_controllers.exchange(false);
-        XINPUT_STATE xinput_state;
 
-        for (int i = 0; i < 4; ++i)
-        {
-            if (_controller_states[i].connected)
-            {
-                _controller_states[i].prev_state = _controller_states[i].current_state;
-            }
+Pixel* App::get_framebuffer()
+{
+    flush_draws();
+    return m_framebuffer;
+}
 
-            if (poll_controllers || _controller_states[i].connected)
-            {
-                _controller_states[i].connected = XInputGetState(i, &xinput_state) == ERROR_SUCCESS;
-            }
 
-            if (_controller_states[i].connected)
-            {
-                _controller_states[i].current_state = xinput_state.Gamepad;
-            }
-        }
+uint8_t* App::get_indexed_framebuffer()
+{
+    flush_draws();
+    return m_indexed_framebuffer;
+}
 
-        // User update
-        if (!on_update(delta))
-        {
-            _quit = true;
-        }
 
-        // Present
-        _opengl.begin_frame();
+void App::mark_dirty(int x, int y, int w, int h)
+{
+    m_dirty.add(x, y, x + w, y + h);
+}
 
-        on_render(delta);
 
-        if (m_screenshot_requested)
-        {
-            std::chrono::system_clock::time_point tp = std::chrono::system_clock::now();
-            std::time_t tt = std::chrono::system_clock::to_time_t(tp);
-            std::tm* local = std::localtime(&tt);
-            std::string filename(128, 0);
+void App::mark_dirty()
+{
+    m_dirty.add_all();
+}
 
-            for (size_t size = 128; true; size *= 2)
-            {
-                filename.resize(size);
 
-                if (std::strftime(&filename[0], size, "%Y%m%d%H%M%S", local))
-                {
-                    break;
-                }
-            }
+void App::request_screenshot(const std::string& directory)
+{
+    m_screenshot_requested = true;
+    m_screenshot_directory = directory;
+}
 
-            std::chrono::system_clock::duration ticks = tp.time_since_epoch();
-            ticks -= std::chrono::duration_cast<std::chrono::seconds>(ticks);
-            uint32_t milliseconds = (uint32_t)(ticks / std::chrono::milliseconds(1));
-            int len = std::snprintf(nullptr, 0, "%s\\screen_%s%03u.png", m_screenshot_directory.c_str(), filename.c_str(), milliseconds) + 1;
-            std::string path(len, 0);
-            std::snprintf(&path[0], len, "%s\\screen_%s%03u.png", m_screenshot_directory.c_str(), filename.c_str(), milliseconds);
-            make_screenshot(path);
-            m_screenshot_requested = false;
-        }
 
-        _opengl.end_frame();
+void App::start_capture(const std::string& directory, CaptureFormat format)
+{
+    if (!m_capture)
+    {
+        m_capture = new FrameCapture();
+    }
+
+    // Y4M needs a whole number of frames per second: the rate frames are paced to, else the fixed timestep's, else a guess
+    int fps = m_frame_timer.frame_limit();
+
+    if (fps <= 0)
+    {
+        fps = m_fixed_timestep > 0.0f ? (int)(1.0f / m_fixed_timestep + 0.5f) : 60;
+    }
+
+    m_capture->start_sequence(directory + "/capture_" + timestamp(), format, fps);
+}
 
-        m_fade = 0.0f;
+
+void App::stop_capture()
+{
+    if (m_capture)
+    {
+        m_capture->stop_sequence();
     }
+}
 
-    _opengl.make_current(true);
-    on_destroy();
-    _opengl.make_current(false);
 
-    PostMessage(m_hwnd, WM_DESTROY, 0, 0);
+bool App::capturing() const
+{
+    return m_capture && m_capture->sequence_active();
 }
 
 
-void App::make_screenshot(const std::string& path)
+static void update_key_state(App::KeyState& state, bool down)
 {
-    std::vector<uint8_t> image_data(m_window_width * m_window_height * 3);
-    glReadBuffer(GL_BACK);
-    glReadPixels(0, 0, m_window_width, m_window_height, GL_RGB, GL_UNSIGNED_BYTE, &image_data[0]);
-    stbi_flip_vertically_on_write(1);
-    stbi_write_png(path.c_str(), m_window_width, m_window_height, 3, &image_data[0], m_window_width * 3);
+    state.pressed = down && !state.down;
+    state.released = !down && state.down;
+    state.down = down;
 }
 
 
-LRESULT CALLBACK App::window_proc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
+float App::update_input(float delta)
 {
-    App* app = (App*)GetProp(hwnd, L"IneptEngineWindow");
+    m_frame_start = std::chrono::steady_clock::now();
 
-    switch (msg)
+    // The whole log's frame times, for the summary when it stops
+    if (m_input_log)
     {
-        case WM_ACTIVATEAPP:
-        {
-            _active = !!wparam;
-            break;
-        }
-        case WM_CLOSE:
-        {
-            _quit = true;
-            return 0;
-        }
-        case WM_DESTROY:
-        {
-            PostQuitMessage(0);
-            return 0;
-        }
-        case WM_DEVICECHANGE:
-        {
-            _poll_controllers = true;
-            return 0;
-        }
-        case WM_MOUSELEAVE:
-        {
-            _mouse_active = false;
-            return 0;
-        }
-        case WM_MOUSEMOVE:
+        m_input_log_times.push_back(delta);
+    }
+
+    if (m_fixed_timestep > 0.0f)
+    {
+        delta = m_fixed_timestep;
+    }
+
+    if (replaying_input())
+    {
+        if (!m_input_log->read(m_input, delta))
         {
-            MouseState state = _mouse_state.load();
-            int window_scale = app->m_window_width / app->m_screen_width;
-            state.x = int(lparam & 0xFFFF) / window_scale;
-            state.y = int(lparam >> 16) / window_scale;
-            _mouse_state.store(state);
-            _mouse_active = true;
-            return 0;
+            gliLog(LogLevel::Error, "App", "App::update_input", "Input log ends in the middle of frame %llu.",
+                   (unsigned long long)m_input_log->frame_count());
+            stop_input_log();
+            m_quit = true;
         }
-        case WM_MOUSEWHEEL:
+        else if (m_input_log->at_end())
         {
-            int delta = GET_WHEEL_DELTA_WPARAM(wparam);
-            _mouse_wheel.fetch_add(delta);
-            return 0;
+            // Quitting now still runs this frame, and no frame after it
+            m_quit = true;
         }
-        case WM_SYSKEYDOWN:
+    }
+    else if (m_input_script)
+    {
+        m_input_script(m_frame, m_input);
+    }
+
+    if (recording_input())
+    {
+        m_input_log->write(m_input, delta);
+    }
+
+    for (int i = 0; i < Key_Count; i++)
+    {
+        update_key_state(m_keys[i], m_input.keys[i]);
+    }
+
+    for (int i = 0; i < 3; ++i)
+    {
+        update_key_state(m_mouse.buttons[i], m_input.mouse_buttons[i]);
+    }
+
+    m_mouse.x = m_input.mouse_x;
+    m_mouse.y = m_input.mouse_y;
+    m_mouse.wheel = m_input.mouse_wheel;
+
+    // The wheel reports movement since the last frame
+    m_input.mouse_wheel = 0;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        const ControllerInput& input = m_input.controllers[i];
+        ControllerState& state = m_controllers[i];
+
+        // A controller that goes away reads as released
+        state.lx = input.connected ? input.lx : 0.0f;
+        state.ly = input.connected ? input.ly : 0.0f;
+        state.rx = input.connected ? input.rx : 0.0f;
+        state.ry = input.connected ? input.ry : 0.0f;
+        state.lt = input.connected ? input.lt : 0.0f;
+        state.rt = input.connected ? input.rt : 0.0f;
+
+        for (int button = 0; button < 16; ++button)
         {
-            if (wparam == VK_F10)
-            {
-                return 0;
-            }
-            break;
+            update_key_state(state.buttons[button], input.connected && (input.buttons & (1 << button)));
         }
     }
 
-    return DefWindowProc(hwnd, msg, wparam, lparam);
+    return delta;
 }
 
 
-char* wchar_to_utf8(const wchar_t* mbcs)
+float App::event_age(const InputEvent& event) const
 {
-    int utf8_len = WideCharToMultiByte(CP_UTF8, 0, mbcs, -1, NULL, 0, NULL, NULL);
-    char* utf8 = (char*)malloc(utf8_len);
-    WideCharToMultiByte(CP_UTF8, 0, mbcs, -1, utf8, utf8_len + 1, NULL, NULL);
-    return utf8;
+    return std::chrono::duration<float>(m_frame_start - event.time).count();
 }
 
 
-wchar_t* utf8_to_wchar(const char* utf8)
+bool App::input_from_devices() const
 {
-    int mbcs_len = MultiByteToWideChar(CP_UTF8, 0, utf8, -1, NULL, 0);
-    wchar_t* mbcs = (wchar_t*)malloc(sizeof(wchar_t) * mbcs_len);
-    MultiByteToWideChar(CP_UTF8, 0, utf8, -1, mbcs, mbcs_len);
-    return mbcs;
+    return !m_input_script && !replaying_input();
 }
 
-} // namespace gli
 
+void App::end_frame()
+{
+    gliAssert(m_target_stack.empty() && m_clip_stack.empty());
 
-int wWinMainInternal(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdLine, int nCmdShow)
+    // The time spent on the frame itself, before pacing
+    if (m_timing_file)
+    {
+        float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_frame_start).count();
+        fprintf(m_timing_file, "%llu,%.4f\n", (unsigned long long)m_frame, ms);
+    }
+
+    m_fade = 0.0f;
+    m_events.clear();
+    m_frame_timer.wait();
+    ++m_frame;
+}
+
+
+void App::capture_frame()
 {
-    CoInitializeEx(0, COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE);
+    if (!m_screenshot_requested && !capturing())
+    {
+        return;
+    }
 
-    std::vector<char*> argv(__argc);
+    if (!m_capture)
+    {
+        m_capture = new FrameCapture();
+    }
 
-    if (__wargv)
+    CaptureSource source{};
+    source.width = m_screen_width;
+    source.height = m_screen_height;
+    source.fade_color = m_fade_color;
+    source.fade = m_fade;
+
+    if (m_framebuffer_format == Framebuffer_Indexed)
     {
-        for (int i = 0; i < __argc; ++i)
-        {
-            argv[i] = gli::wchar_to_utf8(__wargv[i]);
-        }
+        source.indices = m_indexed_framebuffer;
+        source.palette = m_palette;
     }
     else
     {
-        for (int i = 0; i < __argc; ++i)
-        {
-            argv[i] = __argv[i];
-        }
+        source.pixels = m_framebuffer;
+    }
+
+    if (m_screenshot_requested)
+    {
+        // Forward slashes work on Windows too
+        m_capture->save_image(m_screenshot_directory + "/screen_" + timestamp() + ".png", Capture_Png, source);
+        m_screenshot_requested = false;
     }
 
-    int result = gli_main(__argc, argv.data());
+    m_capture->add_frame(source);
+}
 
 
-    if (__wargv)
+void App::shutdown()
+{
+    stop_input_log();
+    platform_shutdown();
+
+    // Waits for anything still being written
+    delete m_capture;
+    m_capture = nullptr;
+
+    delete m_draw_list;
+    m_draw_list = nullptr;
+    delete m_layers;
+    m_layers = nullptr;
+    JobSystem::get()->stop();
+    delete[] m_framebuffer;
+    delete[] m_indexed_framebuffer;
+    m_framebuffer = nullptr;
+    m_indexed_framebuffer = nullptr;
+}
+
+
+uint32_t App::palette_color(uint8_t c)
+{
+    return m_framebuffer_format == Framebuffer_Indexed ? c : m_palette[c].argb;
+}
+
+
+bool App::direct_framebuffer(const char* func)
+{
+    if (m_framebuffer_format == Framebuffer_Direct)
     {
-        for (char*& argptr : argv)
-        {
-            free(argptr);
-        }
+        return true;
     }
 
-    CoUninitialize();
+    // Once, rather than every frame the app keeps drawing
+    if (!m_warned_indexed)
+    {
+        gliLog(LogLevel::Warning, "App", func, "%s and the other Pixel color and sprite draws need a direct framebuffer, ignoring them.",
+               func);
+        m_warned_indexed = true;
+    }
 
-    return 0;
+    return false;
 }
 
 
-int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdLine, int nCmdShow)
+template <typename T>
+Raster<T> App::raster(T* pixels, int stride, const DirtyRect& clip)
 {
-    int result;
+    return { pixels, stride, clip.x0, clip.y0, clip.x1, clip.y1, m_blend_op, m_blend_kernel, m_blend_constant, &m_span_buffer };
+}
+
 
-    if (IsDebuggerPresent())
+void App::submit(const DrawCommand& command, const void* data, size_t size)
+{
+    if (m_target)
     {
-        result = wWinMainInternal(hInstance, hPrevInstance, GetCommandLineW(), nCmdShow);
+        // Surfaces aren't uploaded, so there's nothing to mark dirty, and they're usually drawn once and reused so deferring
+        // wouldn't save anything
+        gliAssert(command.data != (const Sprite*)m_target);
+        gliAssert(command.type != DrawCommand::TransformedSprite || ((const SpriteTransform*)command.data)->sprite != m_target);
+        execute_draw_command(raster(m_target->pixels(), m_target->stride(), m_clip), command);
+        return;
+    }
+
+    auto mark_dirty = [this](int x0, int y0, int x1, int y1) {
+        m_dirty.add(std::max(x0, m_clip.x0), std::max(y0, m_clip.y0), std::min(x1, m_clip.x1), std::min(y1, m_clip.y1));
+    };
+
+    if (command.type == DrawCommand::Rect)
+    {
+        // Only the outline changes
+        mark_dirty(command.x, command.y, command.x + command.w, command.y + 1);
+        mark_dirty(command.x, command.y + command.h - 1, command.x + command.w, command.y + command.h);
+        mark_dirty(command.x, command.y, command.x + 1, command.y + command.h);
+        mark_dirty(command.x + command.w - 1, command.y, command.x + command.w, command.y + command.h);
     }
     else
     {
-        __try
-        {
-            result = wWinMainInternal(hInstance, hPrevInstance, GetCommandLineW(), nCmdShow);
-        }
-        __except (UnhandledExceptionFilter(GetExceptionInformation()))
+        DirtyRect bounds = draw_command_bounds(command);
+        mark_dirty(bounds.x0, bounds.y0, bounds.x1, bounds.y1);
+    }
+
+    if (m_draw_list)
+    {
+        // A frame that changes the clip or blend state between most of its draws can run out of states, drawing what's
+        // recorded so far frees them
+        if (!m_draw_list->record(command, data, size, m_clip, m_blend_op, m_blend_kernel, m_blend_constant))
         {
-            MessageBoxW(0, L"A wild exception appears! The application will die horribly now.", L"Oh no!", MB_ICONERROR | MB_OK);
-            result = -1;
+            flush_draws();
+            m_draw_list->record(command, data, size, m_clip, m_blend_op, m_blend_kernel, m_blend_constant);
         }
     }
+    else if (m_framebuffer_format == Framebuffer_Indexed)
+    {
+        execute_draw_command(raster(m_indexed_framebuffer, m_screen_width, m_clip), command);
+    }
+    else
+    {
+        execute_draw_command(raster(m_framebuffer, m_screen_width, m_clip), command);
+    }
+}
+
 
-    return result;
+void App::submit_line(int x1, int y1, int x2, int y2, uint32_t c)
+{
+    DrawCommand command{};
+    command.type = DrawCommand::Line;
+    command.x = x1;
+    command.y = y1;
+    command.w = x2;
+    command.h = y2;
+    command.fg = c;
+    submit(command);
 }
 
 
-#ifdef WIN32
-int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR pCmdLine, int nCmdShow)
+void App::submit_rect(int x, int y, int w, int h, uint32_t c)
 {
-    int result;
+    DrawCommand command{};
+    command.type = DrawCommand::Rect;
+    command.x = x;
+    command.y = y;
+    command.w = w;
+    command.h = h;
+    command.fg = c;
+    submit(command);
+}
 
-    if (IsDebuggerPresent())
-    {
-        result = wWinMainInternal(hInstance, hPrevInstance, GetCommandLineW(), nCmdShow);
-    }
-    else
+
+void App::submit_fill_rect(int x, int y, int w, int h, int bw, uint32_t fg, uint32_t bg)
+{
+    DrawCommand command{};
+    command.type = DrawCommand::FillRect;
+    command.x = x;
+    command.y = y;
+    command.w = w;
+    command.h = h;
+    command.param = bw;
+    command.fg = fg;
+    command.bg = bg;
+    submit(command);
+}
+
+
+void App::submit_glyphs(int x, int y, const char* str, int len, const Font& font, uint32_t fg, uint32_t bg)
+{
+    DrawCommand command{};
+    command.type = DrawCommand::Glyphs;
+    command.x = x;
+    command.y = y;
+    command.param = len;
+    command.fg = fg;
+    command.bg = bg;
+    command.data = str;
+    command.font = &font;
+    submit(command, str, len);
+}
+
+
+void App::submit_sprite_transform(int x, int y, int w, int h, const SpriteTransform& transform)
+{
+    gliAssert(m_framebuffer_format == Framebuffer_Direct);
+    gliAssert(transform.sx >= 0 && transform.sy >= 0 && transform.sx + transform.sw <= transform.sprite->width() &&
+              transform.sy + transform.sh <= transform.sprite->height());
+
+    DrawCommand command{};
+    command.type = DrawCommand::TransformedSprite;
+    command.x = x;
+    command.y = y;
+    command.w = w;
+    command.h = h;
+    command.data = &transform;
+    submit(command, &transform, sizeof(transform));
+}
+
+
+void App::draw_profile_overlay()
+{
+    ProfileTotal totals[8];
+    int count = profile_top_zones(totals, 8);
+
+    for (int i = 0; i < count; ++i)
     {
-        __try
+        int y = i * vga9_glyph_height;
+        const char* fmt = "%-32.32s %8.3f ms %5d";
+        double ms = totals[i].time / 1000000.0;
+
+        if (m_framebuffer_format == Framebuffer_Indexed)
         {
-            result = wWinMainInternal(hInstance, hPrevInstance, GetCommandLineW(), nCmdShow);
+            format_string(0, y, vga9_glyphs, vga9_glyph_width, vga9_glyph_height, (uint8_t)15, (uint8_t)0, fmt, totals[i].name, ms, totals[i].count);
         }
-        __except (UnhandledExceptionFilter(GetExceptionInformation()))
+        else
         {
-            MessageBoxW(0, L"A wild exception appears! The application will die horribly now.", L"Oh no!", MB_ICONERROR | MB_OK);
-            result = -1;
+            format_string(0, y, vga9_glyphs, vga9_glyph_width, vga9_glyph_height, Pixel(0xFFFFFFFF), Pixel(0xFF000000), fmt, totals[i].name, ms,
+                          totals[i].count);
         }
     }
 
-    return result;
+    // Last frame's, this one is still going
+    int y = count * vga9_glyph_height;
+    const char* fmt = "frame arena %5d allocs %8.1f KB of %8.1f KB";
+    double used_kb = m_frame_arena.last_bytes() / 1024.0;
+    double capacity_kb = m_frame_arena.capacity() / 1024.0;
+
+    if (m_framebuffer_format == Framebuffer_Indexed)
+    {
+        format_string(0, y, vga9_glyphs, vga9_glyph_width, vga9_glyph_height, (uint8_t)15, (uint8_t)0, fmt, m_frame_arena.last_allocations(),
+                      used_kb, capacity_kb);
+    }
+    else
+    {
+        format_string(0, y, vga9_glyphs, vga9_glyph_width, vga9_glyph_height, Pixel(0xFFFFFFFF), Pixel(0xFF000000), fmt,
+                      m_frame_arena.last_allocations(), used_kb, capacity_kb);
+    }
 }
-#endif
+
+
+} // namespace gli
@@ -1,18 +1,27 @@
 #pragma once
 
+#include "gli_dirty.h"
+#include "gli_frame_arena.h"
+#include "gli_frame_timer.h"
+
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstdarg>
 #include <cstdint>
+#include <cstdio>
 #include <string>
 #include <fstream>
 #include <functional>
 #include <iterator>
 #include <vector>
 
+// Headless builds (GLI_HEADLESS) run the engine loop without a window, GPU or input devices, for benchmarks and tests
+#ifndef GLI_HEADLESS
 #define WIN32_LEAN_AND_MEAN
 #define NOMINMAX
 #include <Windows.h>
+#endif
 
 namespace gli
 {
@@ -159,6 +168,33 @@ struct KeyEvent
     char ascii_code;
 };
 
+enum InputEventType : uint8_t
+{
+    Event_KeyDown,
+    Event_KeyUp,
+    Event_Char,           // value is a UTF-16 code unit of typed text
+    Event_MouseMove,
+    Event_MouseDown,
+    Event_MouseUp,
+    Event_MouseWheel,     // value is the distance, 120 per notch
+    Event_ControllerDown, // Seen when the controller is polled, once a frame
+    Event_ControllerUp
+};
+
+// Something that happened on an input device, and when
+struct InputEvent
+{
+    InputEventType type;
+    bool repeat;        // Event_KeyDown sent by auto repeat while the key is held
+    uint8_t button;     // MouseButton, or the XINPUT_GAMEPAD bit for controllers
+    uint8_t controller;
+    Key key;
+    int x;              // Mouse position in screen pixels
+    int y;
+    int value;
+    std::chrono::steady_clock::time_point time;
+};
+
 struct Pixel
 {
     Pixel() = default;
@@ -206,7 +242,47 @@ enum BlendOp
     Subtract
 };
 
+using BlendSpanFunc = void (*)(Pixel* dest, const Pixel* src, int count, uint8_t constant);
+using BlendFillFunc = void (*)(Pixel* dest, Pixel src, int count, uint8_t constant);
+
+struct BlendKernel
+{
+    BlendSpanFunc span; // Blend count pixels from src into dest
+    BlendFillFunc fill; // Blend a single color into count pixels of dest
+};
+
+enum FramebufferFormat
+{
+    Framebuffer_Direct, // 32 bit Pixels, uploaded as BGRA
+    Framebuffer_Indexed // 8 bit palette indices, resolved through the palette on the GPU
+};
+
+enum CaptureFormat
+{
+    Capture_Png,
+    Capture_Qoi,
+    Capture_Y4m // Raw 4:2:0 video, sequences only
+};
+
+enum SpriteFilter
+{
+    Filter_Nearest,
+    Filter_Bilinear // Weighs the four nearest texels, clamped to the edges of the source rectangle
+};
+
+class DrawList;
+class Font;
+class FrameCapture;
+class InputLog;
 class Sprite;
+struct SpriteTransform;
+struct DrawCommand;
+template <typename T> struct Raster;
+class SpriteAtlas;
+struct AtlasHandle;
+class Surface;
+class RenderLayer;
+class LayerCompositor;
 
 class App
 {
@@ -237,19 +313,85 @@ public:
         KeyState buttons[16];
     };
 
+    struct ControllerInput
+    {
+        bool connected;
+        float lx;
+        float ly;
+        float rx;
+        float ry;
+        float lt;
+        float rt;
+        uint16_t buttons; // Bit per button, in XINPUT_GAMEPAD order
+    };
+
+    // What's held down in a frame, which the key, mouse and controller states are worked out from
+    struct InputFrame
+    {
+        bool keys[Key_Count];
+        int mouse_x;
+        int mouse_y;
+        int mouse_wheel; // Only for the frame it's set in
+        bool mouse_buttons[3];
+        ControllerInput controllers[4];
+    };
+
+    // Called at the start of every frame with the input to fill in
+    using InputScript = std::function<void(uint64_t frame, InputFrame& input)>;
+
     virtual ~App() = default;
 
     virtual bool on_create() = 0;
     virtual void on_destroy() = 0;
     virtual bool on_update(float delta) = 0;
-    virtual void on_render(float delta); // FIXME - don't do this, do render layers
+    virtual void on_render(float delta); // Uploads what changed and presents it, render layers are composited before on_update
+
+    // Runs before the render layers are composited. Whatever changes a layer (game logic, scrolling, state changes) and the
+    // redraw into it belong here, a layer changed in on_update only shows the frame after. Returning false quits, as on_update.
+    virtual bool on_pre_update(float) { return true; }
 
-    bool initialize(const char* name, int screen_width_, int screen_height_, int window_scale);
+    // Also starts the shared JobSystem with worker_count threads, -1 for one per core besides the engine thread
+    bool initialize(const char* name, int screen_width_, int screen_height_, int window_scale, FramebufferFormat format = Framebuffer_Direct,
+                    int worker_count = -1);
     void run();
     void quit();
 
     int screen_width();
     int screen_height();
+    FramebufferFormat framebuffer_format();
+
+    // Pace frames to fps, 0 (the default) runs as fast as presenting allows
+    void set_frame_limit(int fps);
+    FrameStats frame_stats() const;
+
+    // Scratch memory that's freed at the top of the next frame, for containers built and dropped within one
+    FrameArena& frame_arena() { return m_frame_arena; }
+
+    // Pass on_update a fixed delta instead of the measured frame time, 0 (the default) goes back to measuring
+    void set_fixed_timestep(float delta);
+
+    // Frames since run started
+    uint64_t frame_index() const { return m_frame; }
+
+    // While a script is set it replaces the keyboard, mouse and controllers. Headless builds have no other input besides replays.
+    void set_input_script(InputScript script);
+
+    // Write every frame's input and delta to a binary log until stopped or the app exits
+    bool record_input(const std::string& path);
+
+    // Play a recorded log back in place of the devices and script, passing on_update the recorded deltas, and quit after its
+    // last frame. With a timing path each frame's measured time is written there as CSV, for comparing runs of the same log.
+    bool replay_input(const std::string& path, const std::string& timing_path = std::string());
+
+    void stop_input_log();
+    bool recording_input() const;
+    bool replaying_input() const;
+
+    // Starts recording for "--record <log>" or replaying for "--replay <log> [--timing <csv>]", false if a log failed to open
+    bool input_log_from_args(int argc, char** argv);
+
+    // List the zones that took longest in the last frame over the top left of the screen
+    void show_profile_overlay(bool show);
 
     const KeyState& key_state(Key key);
     const MouseState& mouse_state();
@@ -257,9 +399,19 @@ public:
     bool mouse_visible();
     ControllerState controller_state(int controller);
 
+    // Key events in the order they happened, with auto repeats and the character each press typed. Scripts and replays only
+    // have key states to go on, so their events are worked out from those, once per frame and without repeats.
     using KeyEventHandler = std::function<void(KeyEvent&)>;
     void process_key_events(KeyEventHandler handler);
 
+    // Everything the window saw since the last frame, oldest first, stamped as it arrived rather than when the frame polled.
+    // Presses shorter than a frame still show in key_state and mouse_state for the frame they happened in. Empty while a
+    // script or replay drives the input.
+    const std::vector<InputEvent>& poll_events() const { return m_events; }
+
+    // Seconds between an event and the start of this frame
+    float event_age(const InputEvent& event) const;
+
     void set_palette(uint32_t rgbx[256]);
     void set_palette(const uint8_t* palette, int size);
     void load_palette(const std::string& path);
@@ -280,40 +432,173 @@ public:
     void draw_string(int x, int y, const char* str, const int* glyphs, int w, int h, Pixel fg, Pixel bg);
     void format_string(int x, int y, const int* glyphs, int w, int h, uint8_t fg, uint8_t bg, const char* fmt, ...);
     void format_string(int x, int y, const int* glyphs, int w, int h, Pixel fg, Pixel bg, const char* fmt, ...);
+    void draw_string(int x, int y, const char* str, const Font& font, uint8_t fg, uint8_t bg);
+    void draw_string(int x, int y, const char* str, const Font& font, Pixel fg, Pixel bg);
+    void format_string(int x, int y, const Font& font, uint8_t fg, uint8_t bg, const char* fmt, ...);
+    void format_string(int x, int y, const Font& font, Pixel fg, Pixel bg, const char* fmt, ...);
     void draw_rect(int x, int y, int w, int h, uint8_t c);
+    void draw_rect(int x, int y, int w, int h, Pixel c);
     void fill_rect(int x, int y, int w, int h, int bw, uint8_t fg, uint8_t bg);
     void fill_rect(int x, int y, int w, int h, int bw, Pixel fg, Pixel bg);
     void copy_rect(int x, int y, int w, int h, const uint8_t* src, uint32_t stride);
+    // w and h are the source size, each source index is drawn as a pixel_scale x pixel_scale block
     void copy_rect_scaled(int x, int y, int w, int h, const uint8_t* src, uint32_t stride, int pixel_scale);
     void draw_sprite(int x, int y, const Sprite* sprite);
     void draw_partial_sprite(int x, int y, const Sprite* sprite, int ox, int oy, int w, int h);
     void blend_sprite(int x, int y, const Sprite& sprite, uint8_t alpha);
     void blend_partial_sprite(int x, int y, const Sprite& sprite, int ox, int oy, int w, int h, uint8_t alpha);
+
+    // Scaled and transformed sprites are resampled and then drawn with the current blend mode, or copied when blending is off.
+    // Only destination pixels whose centres map inside the source rectangle are touched.
+    void draw_sprite_scaled(int x, int y, int w, int h, const Sprite& sprite, SpriteFilter filter = Filter_Nearest);
+    void draw_partial_sprite_scaled(int x, int y, int w, int h, const Sprite& sprite, int ox, int oy, int sw, int sh,
+                                    SpriteFilter filter = Filter_Nearest);
+
+    // Scales the sprite about its centre, rotates it clockwise by angle radians and puts its centre at (x, y)
+    void draw_sprite_transformed(float x, float y, const Sprite& sprite, float angle, float scale_x, float scale_y,
+                                 SpriteFilter filter = Filter_Nearest);
+    void draw_partial_sprite_transformed(float x, float y, const Sprite& sprite, int ox, int oy, int w, int h, float angle,
+                                         float scale_x, float scale_y, SpriteFilter filter = Filter_Nearest);
+
+    // Atlas handles draw their rectangle of one of the atlas pages. The partial calls take ox and oy within that rectangle and
+    // are clipped to it, so neighbouring images never show.
+    void draw_sprite(int x, int y, const SpriteAtlas& atlas, AtlasHandle handle);
+    void draw_partial_sprite(int x, int y, const SpriteAtlas& atlas, AtlasHandle handle, int ox, int oy, int w, int h);
+    void blend_sprite(int x, int y, const SpriteAtlas& atlas, AtlasHandle handle, uint8_t alpha);
+    void blend_partial_sprite(int x, int y, const SpriteAtlas& atlas, AtlasHandle handle, int ox, int oy, int w, int h, uint8_t alpha);
+    void draw_sprite_scaled(int x, int y, int w, int h, const SpriteAtlas& atlas, AtlasHandle handle, SpriteFilter filter = Filter_Nearest);
+    void draw_sprite_transformed(float x, float y, const SpriteAtlas& atlas, AtlasHandle handle, float angle, float scale_x,
+                                 float scale_y, SpriteFilter filter = Filter_Nearest);
     void set_screen_fade(Pixel color, float fade);
 
+    // Draw calls go to the surface on top of the target stack, or the screen when it's empty. Draws into a surface happen
+    // straight away even with deferred drawing, and pushing one flushes what's been recorded for the screen first. Pixel
+    // framebuffers only. Surfaces can't be drawn while they're a target.
+    void push_target(Surface& surface);
+    void pop_target();
+
+    // Each target starts unclipped. Clip rectangles are intersected with the one below them, and popping a target pops any it
+    // left pushed. Both stacks have to be empty again by the end of the frame.
+    void push_clip(int x, int y, int w, int h);
+    void pop_clip();
+
+    // Size of the current target
+    int target_width();
+    int target_height();
+
+    // Render layers are composited into the framebuffer every frame between on_pre_update and on_update, in the order they were
+    // added, under whatever on_update draws. They're only composited again when one of them changes; otherwise just the parts of
+    // the screen drawn over in the last frame are restored, so apps using layers shouldn't clear the screen. Changes made to a
+    // layer in on_update, including redrawing its surface, show a frame late, so make them in on_pre_update. Pixel framebuffers
+    // only.
+    RenderLayer& add_layer(int width, int height);
+    void remove_layers();
+    int layer_count() const;
+    RenderLayer& layer(int index);
+
+    // Deferred drawing records draw calls and replays them when the frame is presented, binned into 64x64 tiles that are
+    // drawn in parallel on the JobSystem. The result is the same as drawing immediately. Strings and copy_rect sources are
+    // copied, but sprites and fonts must stay alive until the frame is presented.
+    void set_deferred_drawing(bool deferred);
+
+    // Draw anything recorded so far. Getting the framebuffer pointers does this too, so direct writes land in order.
+    void flush_draws();
+
+    // Only one of these is valid, depending on the framebuffer format. In indexed mode the Pixel overloads of the draw calls
+    // and the sprite calls do nothing, the palette index overloads write indices and blending is ignored.
     Pixel* get_framebuffer();
+    uint8_t* get_indexed_framebuffer();
 
+    // Only the parts of the framebuffer that changed are uploaded each frame. The draw calls keep track of what they touch,
+    // anything writing through the framebuffer pointers directly has to report it here.
+    void mark_dirty(int x, int y, int w, int h);
+    void mark_dirty();
+
+    // Screenshots and captures copy the framebuffer as it's shown, at screen resolution, and are encoded on a background thread.
+    // A capture writes every frame until it's stopped, to numbered images or a single Y4M video.
     void request_screenshot(const std::string& directory);
+    void start_capture(const std::string& directory, CaptureFormat format);
+    void stop_capture();
+    bool capturing() const;
 
+#ifndef GLI_HEADLESS
     HWND get_window_handle() { return m_hwnd; }
+#endif
 
 private:
-    void shutdown();
-    void pump_messages();
+    // Implemented by the platform backend, gli_core_win32.cpp or gli_core_headless.cpp
+    bool platform_initialize(const char* name, int window_scale);
+    void platform_shutdown();
     void engine_loop();
-    void make_screenshot(const std::string& path);
 
+    void shutdown();
+
+    // Works out this frame's input states from m_input, after the backend has filled it, and returns the delta to pass on
+    float update_input(float delta);
+    bool input_from_devices() const;
+    void composite_layers();
+    void end_frame();
+    void capture_frame();
+
+    // Colors from here on are Pixel argb values or palette indices, depending on the framebuffer format
+    uint32_t palette_color(uint8_t c);
+    bool direct_framebuffer(const char* func); // False, and warns the first time, in indexed mode
+    template <typename T> Raster<T> raster(T* pixels, int stride, const DirtyRect& clip);
+    void submit(const DrawCommand& command, const void* data = nullptr, size_t size = 0);
+    void submit_line(int x1, int y1, int x2, int y2, uint32_t c);
+    void submit_rect(int x, int y, int w, int h, uint32_t c);
+    void submit_fill_rect(int x, int y, int w, int h, int bw, uint32_t fg, uint32_t bg);
+    void submit_glyphs(int x, int y, const char* str, int len, const Font& font, uint32_t fg, uint32_t bg);
+    const Font& glyph_font(const int* glyphs, int w, int h);
+    template <typename Color>
+    void vformat_string(int x, int y, const Font& font, Color fg, Color bg, const char* fmt, va_list args);
+    void submit_sprite_transform(int x, int y, int w, int h, const SpriteTransform& transform);
+    void draw_profile_overlay();
+
+    struct TargetState
+    {
+        Surface* target;
+        DirtyRect clip;
+        size_t clip_depth; // Size of m_clip_stack when it was pushed over
+    };
+
+#ifndef GLI_HEADLESS
+    void pump_messages();
     static LRESULT CALLBACK window_proc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam);
 
     HWND m_hwnd = NULL;
-    short* m_keystate[2] = {};
-    int m_current_keystate = 0;
-    Pixel* m_framebuffer = {};
     wchar_t* m_title = nullptr;
+    int m_keymap[Key_Count] = {};
+#endif
+
+    std::atomic<bool> m_quit{};
+    uint64_t m_frame = 0;
+    float m_fixed_timestep = 0.0f;
+    InputFrame m_input{};
+    std::vector<InputEvent> m_events{};
+    InputScript m_input_script{};
+    InputLog* m_input_log = nullptr;
+    std::vector<float> m_input_log_times{}; // Every frame's time since the log started
+    FILE* m_timing_file = nullptr;
+    std::chrono::steady_clock::time_point m_frame_start{};
+    ControllerState m_controllers[4] = {};
+    FramebufferFormat m_framebuffer_format = Framebuffer_Direct;
+    Pixel* m_framebuffer = {};
+    uint8_t* m_indexed_framebuffer = {};
     Pixel m_palette[256] = {};
+    bool m_palette_dirty = true;
+    DirtyRects m_dirty{};
+    DirtyRects m_presented{}; // What m_dirty was when the last frame went up
+    FrameTimer m_frame_timer{};
+    FrameArena m_frame_arena{};
+    DrawList* m_draw_list = nullptr;
+    LayerCompositor* m_layers = nullptr;
+    Surface* m_target = nullptr;           // nullptr for the screen
+    DirtyRect m_clip{};                    // In target coordinates
+    std::vector<DirtyRect> m_clip_stack{}; // Clips pushed over the current one
+    std::vector<TargetState> m_target_stack{};
     KeyState m_keys[Key_Count] = {};
     MouseState m_mouse = {};
-    int m_keymap[Key_Count] = {};
     int m_screen_width;
     int m_screen_height;
     int m_window_width;
@@ -324,8 +609,15 @@ private:
     BlendMode m_dest_blend = BlendMode::Zero;
     uint8_t m_blend_constant = 255;
     BlendOp m_blend_op = BlendOp::None;
+    BlendKernel m_blend_kernel{};
+    const Font* m_glyph_font = nullptr; // The last font glyph_font returned, and the glyph array it came from
+    const int* m_glyph_font_glyphs = nullptr;
     bool m_screenshot_requested = false;
+    bool m_profile_overlay = false;
+    bool m_warned_indexed = false;
     std::string m_screenshot_directory{};
+    FrameCapture* m_capture = nullptr;
+    std::vector<Pixel> m_span_buffer{};
 };
 
 } // namespace gli
@@ -0,0 +1,132 @@
+#ifdef GLI_HEADLESS
+
+#include "gli_core.h"
+
+#include "gli_log.h"
+#include "gli_memory.h"
+#include "gli_profile.h"
+
+extern int gli_main(int argc, char** argv);
+
+namespace gli
+{
+
+static int _hide_cursor = 1;
+
+
+bool App::platform_initialize(const char* name, int)
+{
+    gliLog(LogLevel::Info, "App", "App::initialize", "Running %s headless at %dx%d.", name, m_screen_width, m_screen_height);
+    return true;
+}
+
+
+void App::run()
+{
+    m_quit = false;
+    m_frame = 0;
+
+    // Nothing to pump, so the engine loop gets the calling thread
+    engine_loop();
+    shutdown();
+}
+
+
+void App::show_mouse(bool show)
+{
+    if (show && _hide_cursor)
+    {
+        --_hide_cursor;
+    }
+    else
+    {
+        ++_hide_cursor;
+    }
+}
+
+
+bool App::mouse_visible()
+{
+    return _hide_cursor == 0;
+}
+
+
+void App::on_render(float)
+{
+    flush_draws();
+    m_presented = m_dirty;
+    m_dirty.clear();
+}
+
+
+void App::platform_shutdown()
+{
+}
+
+
+void App::engine_loop()
+{
+    GLI_PROFILE_THREAD("Engine");
+
+    if (!on_create())
+    {
+        m_quit = true;
+    }
+
+    m_frame_timer.reset();
+
+    while (!m_quit)
+    {
+        GLI_PROFILE_FRAME();
+        m_frame_arena.reset();
+        memory_frame();
+        float delta = update_input(m_frame_timer.tick());
+
+        // Ahead of compositing, so layer changes show this frame
+        {
+            GLI_PROFILE_SCOPE("App::on_pre_update");
+
+            if (!on_pre_update(delta))
+            {
+                m_quit = true;
+            }
+        }
+
+        composite_layers();
+
+        // User update
+        {
+            GLI_PROFILE_SCOPE("App::on_update");
+
+            if (!on_update(delta))
+            {
+                m_quit = true;
+            }
+        }
+
+        if (m_profile_overlay)
+        {
+            draw_profile_overlay();
+        }
+
+        {
+            GLI_PROFILE_SCOPE("App::on_render");
+            on_render(delta);
+        }
+
+        capture_frame();
+        end_frame();
+    }
+
+    on_destroy();
+}
+
+} // namespace gli
+
+
+int main(int argc, char** argv)
+{
+    return gli_main(argc, argv);
+}
+
+#endif // GLI_HEADLESS
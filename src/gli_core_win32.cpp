@@ -0,0 +1,1003 @@
+#ifndef GLI_HEADLESS
+
+#include "gli_core.h"
+
+#include "gli_log.h"
+#include "gli_memory.h"
+#include "gli_opengl.h"
+#include "gli_profile.h"
+#include "gli_spsc_queue.h"
+
+#include "opengl/glad.h"
+
+#include <objbase.h>
+#include <Xinput.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+extern int gli_main(int argc, char** argv);
+
+static const char* s_shader_source[3]{
+    R"(
+#version 400 core
+
+in vec2 vPos;
+out vec2 vTexCoord;
+
+out gl_PerVertex
+{
+    vec4 gl_Position;
+};
+
+void main()
+{
+    gl_Position = vec4(vPos, 0, 1);
+    vTexCoord = (vPos + 1.0) * vec2(0.5, -0.5);
+}
+    )",
+
+    R"(
+#version 400 core
+
+uniform sampler2D sDiffuseMap;
+uniform float fFade;
+
+in vec2 vTexCoord;
+out vec4 oColor;
+
+void main()
+{
+    oColor = vec4(texture(sDiffuseMap, vTexCoord).rgb, fFade);
+}
+    )",
+
+    R"(
+#version 400 core
+
+uniform sampler2D sIndexMap;
+uniform sampler2D sPalette;
+uniform float fFade;
+
+in vec2 vTexCoord;
+out vec4 oColor;
+
+void main()
+{
+    int index = int(texture(sIndexMap, vTexCoord).r * 255.0 + 0.5);
+    oColor = vec4(texelFetch(sPalette, ivec2(index, 0), 0).rgb, fFade);
+}
+    )"
+};
+
+DWORD WINAPI XInputGetStateStub(DWORD, XINPUT_STATE*)
+{
+    return ERROR_DEVICE_NOT_CONNECTED;
+}
+
+using XInputGetStateFuncPtr = decltype(&(XInputGetStateStub));
+
+
+namespace gli
+{
+
+char* wchar_to_utf8(const wchar_t* mbcs);
+wchar_t* utf8_to_wchar(const char* utf8);
+OpenGL _opengl;
+GLuint _shader_program{};
+GLuint _vbo = 0;
+GLuint _vao = 0;
+StreamingTexture _framebuffer_texture;
+GLuint _uniform_fade = 0;
+GLuint _palette_texture = 0;
+std::atomic<bool> _active;
+std::atomic<bool> _mouse_active;
+std::atomic<bool> _poll_controllers;
+SpscQueue<InputEvent, 1024> _events;     // From window_proc on the message thread to the engine thread
+std::atomic<uint32_t> _dropped_events{}; // Pushed while _events was full
+Key _vk_keys[256];                       // Windows virtual keys to gli::Key, Key_Count for keys that aren't mapped
+bool _keys_held[Key_Count]{};            // Engine thread only, as of the last event read
+bool _mouse_held[3]{};
+HMODULE _xinput_dll = NULL;
+XInputGetStateFuncPtr XInputGetState = XInputGetStateStub;
+bool _controller_connected[4]{};
+int _hide_cursor = 1;
+bool _cursor_hidden = true;
+
+static GLuint compile_shader(GLenum type, const char* source)
+{
+    GLint status;
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+
+    if (!status)
+    {
+        GLint log_length;
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &log_length);
+        std::string log;
+        log.resize(log_length);
+        glGetShaderInfoLog(shader, log_length, nullptr, &log[0]);
+        logf("%s shader failed to compile:\n%s\n", type == GL_VERTEX_SHADER ? "Vertex" : "Fragment", log.c_str());
+        glDeleteShader(shader);
+        return 0;
+    }
+
+    return shader;
+}
+
+
+static GLuint link_program(GLuint vertex_shader, GLuint fragment_shader)
+{
+    GLint status;
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertex_shader);
+    glAttachShader(program, fragment_shader);
+    glLinkProgram(program);
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+
+    if (!status)
+    {
+        GLint log_length;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &log_length);
+        std::string log;
+        log.resize(log_length);
+        glGetProgramInfoLog(program, log_length, nullptr, &log[0]);
+        logf("Program failed to link:\n%s\n", log.c_str());
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    return program;
+}
+
+
+bool App::platform_initialize(const char* name, int window_scale)
+{
+    m_title = utf8_to_wchar(name);
+
+    // Create window
+    WNDCLASSEXW wc = {};
+    wc.cbSize = sizeof(wc);
+    wc.style = CS_HREDRAW | CS_VREDRAW | CS_OWNDC;
+    wc.lpfnWndProc = window_proc;
+    wc.hInstance = GetModuleHandle(NULL);
+    wc.hCursor = LoadCursor(NULL, IDC_ARROW);
+    wc.lpszClassName = L"IneptEngineWindow";
+
+    if (!RegisterClassEx(&wc))
+    {
+        return false;
+    }
+
+    DWORD dwExStyle = WS_EX_APPWINDOW | WS_EX_WINDOWEDGE;
+    DWORD dwStyle = WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
+
+    RECT client_rect = { 0, 0, m_window_width, m_window_height };
+    AdjustWindowRectEx(&client_rect, dwStyle, FALSE, dwExStyle);
+    int width = client_rect.right - client_rect.left;
+    int height = client_rect.bottom - client_rect.top;
+    m_hwnd = CreateWindowEx(dwExStyle, L"IneptEngineWindow", m_title, dwStyle, 0, 0, width, height, NULL, NULL, GetModuleHandle(NULL), NULL);
+    SetProp(m_hwnd, L"IneptEngineWindow", (HANDLE)this);
+
+    if (m_hwnd == NULL)
+    {
+        return false;
+    }
+
+    int x = (GetSystemMetrics(SM_CXSCREEN) - width) / 2;
+    int y = (GetSystemMetrics(SM_CYSCREEN) - height) / 2;
+    SetWindowPos(m_hwnd, 0, x, y, 0, 0, SWP_NOZORDER | SWP_NOSIZE);
+    ShowCursor(FALSE);
+
+    // Map of gli::Key codes to Windows virtual keys
+    m_keymap[Key_A] = 'A';
+    m_keymap[Key_B] = 'B';
+    m_keymap[Key_C] = 'C';
+    m_keymap[Key_D] = 'D';
+    m_keymap[Key_E] = 'E';
+    m_keymap[Key_F] = 'F';
+    m_keymap[Key_G] = 'G';
+    m_keymap[Key_H] = 'H';
+    m_keymap[Key_I] = 'I';
+    m_keymap[Key_J] = 'J';
+    m_keymap[Key_K] = 'K';
+    m_keymap[Key_L] = 'L';
+    m_keymap[Key_M] = 'M';
+    m_keymap[Key_N] = 'N';
+    m_keymap[Key_O] = 'O';
+    m_keymap[Key_P] = 'P';
+    m_keymap[Key_Q] = 'Q';
+    m_keymap[Key_R] = 'R';
+    m_keymap[Key_S] = 'S';
+    m_keymap[Key_T] = 'T';
+    m_keymap[Key_U] = 'U';
+    m_keymap[Key_V] = 'V';
+    m_keymap[Key_W] = 'W';
+    m_keymap[Key_X] = 'X';
+    m_keymap[Key_Y] = 'Y';
+    m_keymap[Key_Z] = 'Z';
+    m_keymap[Key_0] = '0';
+    m_keymap[Key_1] = '1';
+    m_keymap[Key_2] = '2';
+    m_keymap[Key_3] = '3';
+    m_keymap[Key_4] = '4';
+    m_keymap[Key_5] = '5';
+    m_keymap[Key_6] = '6';
+    m_keymap[Key_7] = '7';
+    m_keymap[Key_8] = '8';
+    m_keymap[Key_9] = '9';
+    m_keymap[Key_Space] = VK_SPACE;
+    m_keymap[Key_BackTick] = VK_OEM_3;
+    m_keymap[Key_Minus] = VK_OEM_MINUS;
+    m_keymap[Key_Equals] = VK_OEM_PLUS;
+    m_keymap[Key_LeftBracket] = VK_OEM_4;
+    m_keymap[Key_RightBracket] = VK_OEM_6;
+    m_keymap[Key_Backslash] = VK_OEM_5;
+    m_keymap[Key_Semicolon] = VK_OEM_1;
+    m_keymap[Key_Apostrophe] = VK_OEM_7;
+    m_keymap[Key_Comma] = VK_OEM_COMMA;
+    m_keymap[Key_Period] = VK_OEM_PERIOD;
+    m_keymap[Key_Slash] = VK_OEM_2;
+    m_keymap[Key_Backspace] = VK_BACK;
+    m_keymap[Key_Tab] = VK_TAB;
+    m_keymap[Key_Enter] = VK_RETURN;
+    m_keymap[Key_Escape] = VK_ESCAPE;
+    m_keymap[Key_Menu] = VK_APPS;
+    m_keymap[Key_LeftSystem] = VK_LWIN;
+    m_keymap[Key_RightSystem] = VK_RWIN;
+    m_keymap[Key_PrintScreen] = VK_SNAPSHOT;
+    m_keymap[Key_F1] = VK_F1;
+    m_keymap[Key_F2] = VK_F2;
+    m_keymap[Key_F3] = VK_F3;
+    m_keymap[Key_F4] = VK_F4;
+    m_keymap[Key_F5] = VK_F5;
+    m_keymap[Key_F6] = VK_F6;
+    m_keymap[Key_F7] = VK_F7;
+    m_keymap[Key_F8] = VK_F8;
+    m_keymap[Key_F9] = VK_F9;
+    m_keymap[Key_F10] = VK_F10;
+    m_keymap[Key_F11] = VK_F11;
+    m_keymap[Key_F12] = VK_F12;
+    m_keymap[Key_LeftShift] = VK_LSHIFT;
+    m_keymap[Key_RightShift] = VK_RSHIFT;
+    m_keymap[Key_LeftControl] = VK_LCONTROL;
+    m_keymap[Key_RightControl] = VK_RCONTROL;
+    m_keymap[Key_LeftAlt] = VK_LMENU;
+    m_keymap[Key_RightAlt] = VK_RMENU;
+    m_keymap[Key_Left] = VK_LEFT;
+    m_keymap[Key_Right] = VK_RIGHT;
+    m_keymap[Key_Up] = VK_UP;
+    m_keymap[Key_Down] = VK_DOWN;
+    m_keymap[Key_PageUp] = VK_PRIOR;
+    m_keymap[Key_PageDown] = VK_NEXT;
+    m_keymap[Key_Home] = VK_HOME;
+    m_keymap[Key_End] = VK_END;
+    m_keymap[Key_Insert] = VK_INSERT;
+    m_keymap[Key_Delete] = VK_DELETE;
+    m_keymap[Key_ScrollLock] = VK_SCROLL;
+    m_keymap[Key_CapsLock] = VK_CAPITAL;
+    m_keymap[Key_NumLock] = VK_NUMLOCK;
+    m_keymap[Key_Num_0] = VK_NUMPAD0;
+    m_keymap[Key_Num_1] = VK_NUMPAD1;
+    m_keymap[Key_Num_2] = VK_NUMPAD2;
+    m_keymap[Key_Num_3] = VK_NUMPAD3;
+    m_keymap[Key_Num_4] = VK_NUMPAD4;
+    m_keymap[Key_Num_5] = VK_NUMPAD5;
+    m_keymap[Key_Num_6] = VK_NUMPAD6;
+    m_keymap[Key_Num_7] = VK_NUMPAD7;
+    m_keymap[Key_Num_8] = VK_NUMPAD8;
+    m_keymap[Key_Num_9] = VK_NUMPAD9;
+    m_keymap[Key_Num_Add] = VK_ADD;
+    m_keymap[Key_Num_Subtract] = VK_SUBTRACT;
+    m_keymap[Key_Num_Multiply] = VK_MULTIPLY;
+    m_keymap[Key_Num_Divide] = VK_DIVIDE;
+    m_keymap[Key_Num_Decimal] = VK_DECIMAL;
+    m_keymap[Key_Num_Enter] = VK_RETURN; // Told apart from Key_Enter by the extended key flag, see key_from_message
+
+    // And back again for the key messages, the first key wins when two share a virtual key
+    std::fill_n(_vk_keys, 256, Key_Count);
+
+    for (int i = Key_Count - 1; i >= 0; --i)
+    {
+        _vk_keys[m_keymap[i] & 0xFF] = Key(i);
+    }
+
+    // Initialize OpenGL
+    if (!_opengl.init(m_hwnd))
+    {
+        return false;
+    }
+
+    if (!_opengl.make_current(true))
+    {
+        return false;
+    }
+
+    // Indexed framebuffers look up their colors in the palette texture in the fragment shader
+    GLuint vertex_shader = compile_shader(GL_VERTEX_SHADER, s_shader_source[0]);
+    GLuint fragment_shader = compile_shader(GL_FRAGMENT_SHADER, s_shader_source[m_framebuffer_format == Framebuffer_Indexed ? 2 : 1]);
+
+    if (!vertex_shader || !fragment_shader || !(_shader_program = link_program(vertex_shader, fragment_shader)))
+    {
+        return false;
+    }
+
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+
+    glGenBuffers(1, &_vbo);
+    glGenVertexArrays(1, &_vao);
+
+    glBindVertexArray(_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+
+    static const float verts[] = { -1.0f, 1.0f, -1.0f, -3.0f, 3.0f, 1.0f };
+    glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    StreamingTexture::Format texture_format = m_framebuffer_format == Framebuffer_Indexed ? StreamingTexture::R8 : StreamingTexture::BGRA8;
+
+    if (!_framebuffer_texture.init(m_screen_width, m_screen_height, texture_format))
+    {
+        return false;
+    }
+
+    _uniform_fade = glGetUniformLocation(_shader_program, "fFade");
+
+    if (m_framebuffer_format == Framebuffer_Indexed)
+    {
+        glGenTextures(1, &_palette_texture);
+        glBindTexture(GL_TEXTURE_2D, _palette_texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 256, 1, 0, GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
+
+        glUseProgram(_shader_program);
+        glUniform1i(glGetUniformLocation(_shader_program, "sIndexMap"), 0);
+        glUniform1i(glGetUniformLocation(_shader_program, "sPalette"), 1);
+        glUseProgram(0);
+    }
+
+    _opengl.make_current(false);
+
+    // Initialize XInput
+    if ((_xinput_dll = LoadLibrary(XINPUT_DLL)))
+    {
+        if (!(XInputGetState = (XInputGetStateFuncPtr)GetProcAddress(_xinput_dll, "XInputGetState")))
+        {
+            XInputGetState = XInputGetStateStub;
+        }
+
+        XINPUT_STATE state;
+
+        for (int i = 0; i < 4; ++i)
+        {
+            _controller_connected[i] = XInputGetState(i, &state) == ERROR_SUCCESS;
+        }
+    }
+
+    return true;
+}
+
+
+void App::run()
+{
+    m_quit = false;
+    m_frame = 0;
+    _active = true;
+    std::thread game_thread = std::thread(&App::engine_loop, this);
+    pump_messages();
+    game_thread.join();
+    shutdown();
+}
+
+
+void App::show_mouse(bool show)
+{
+    if (show && _hide_cursor)
+    {
+        --_hide_cursor;
+    }
+    else
+    {
+        ++_hide_cursor;
+    }
+}
+
+
+bool App::mouse_visible()
+{
+    return _hide_cursor == 0;
+}
+
+
+void App::on_render(float delta)
+{
+    flush_draws();
+
+    if (m_fade > 0.0f)
+    {
+        glClearColor(m_fade_color.r / 255.0f, m_fade_color.g / 255.0f, m_fade_color.b / 255.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+    else
+    {
+        glDisable(GL_BLEND);
+    }
+
+    m_dirty.coalesce();
+
+    if (m_framebuffer_format == Framebuffer_Indexed)
+    {
+        // The palette only goes up when it changes, palette effects cost nothing otherwise
+        if (m_palette_dirty)
+        {
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, _palette_texture);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 256, 1, GL_BGRA, GL_UNSIGNED_BYTE, m_palette);
+            glActiveTexture(GL_TEXTURE0);
+            m_palette_dirty = false;
+        }
+
+        _framebuffer_texture.update(m_indexed_framebuffer, m_dirty.rects(), m_dirty.count());
+    }
+    else
+    {
+        _framebuffer_texture.update(m_framebuffer, m_dirty.rects(), m_dirty.count());
+    }
+
+    m_presented = m_dirty;
+    m_dirty.clear();
+
+    glUseProgram(_shader_program);
+    glUniform1f(_uniform_fade, 1.0f - m_fade);
+    glBindVertexArray(_vao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+
+void App::platform_shutdown()
+{
+    _framebuffer_texture.destroy();
+    glDeleteTextures(1, &_palette_texture);
+    glDeleteVertexArrays(1, &_vao);
+    glDeleteBuffers(1, &_vbo);
+    glDeleteProgram(_shader_program);
+
+    UnregisterClass(L"IneptEngineWindow", GetModuleHandle(NULL));
+
+    free(m_title);
+}
+
+
+void App::pump_messages()
+{
+    MSG msg;
+
+    while (GetMessageW(&msg, 0, 0, 0) > 0)
+    {
+        if (msg.message == WM_QUIT)
+        {
+            break;
+        }
+
+        TranslateMessage(&msg);
+        DispatchMessageW(&msg);
+
+        if (!!_hide_cursor != _cursor_hidden)
+        {
+            _cursor_hidden = !!_hide_cursor;
+            ShowCursor(!_cursor_hidden);
+        }
+    }
+}
+
+
+// Works the frame's keys, mouse buttons, position and wheel out from what window_proc queued, and moves the events into events.
+// Keys and buttons read as down for any frame they were down in, so a press and release between two frames isn't lost.
+static void read_window_events(App::InputFrame& input, std::vector<InputEvent>& events)
+{
+    bool went_down[Key_Count] = {};
+    bool mouse_went_down[3] = {};
+
+    std::copy(_keys_held, _keys_held + Key_Count, input.keys);
+    std::copy(_mouse_held, _mouse_held + 3, input.mouse_buttons);
+
+    InputEvent event;
+
+    while (_events.pop(event))
+    {
+        events.push_back(event);
+
+        switch (event.type)
+        {
+            case Event_KeyDown:
+            {
+                _keys_held[event.key] = went_down[event.key] = input.keys[event.key] = true;
+                break;
+            }
+            case Event_KeyUp:
+            {
+                _keys_held[event.key] = false;
+                input.keys[event.key] = went_down[event.key];
+                break;
+            }
+            case Event_MouseDown:
+            {
+                _mouse_held[event.button] = mouse_went_down[event.button] = input.mouse_buttons[event.button] = true;
+                break;
+            }
+            case Event_MouseUp:
+            {
+                _mouse_held[event.button] = false;
+                input.mouse_buttons[event.button] = mouse_went_down[event.button];
+                break;
+            }
+            case Event_MouseMove:
+            {
+                input.mouse_x = event.x;
+                input.mouse_y = event.y;
+                break;
+            }
+            case Event_MouseWheel:
+            {
+                input.mouse_wheel += event.value;
+                break;
+            }
+            default:
+            {
+                break;
+            }
+        }
+    }
+
+    // Releases go to whichever window has focus by then
+    if (!_active)
+    {
+        std::fill_n(_keys_held, Key_Count, false);
+        std::fill_n(_mouse_held, 3, false);
+    }
+
+    if (!_mouse_active)
+    {
+        input.mouse_x = 0;
+        input.mouse_y = 0;
+        input.mouse_wheel = 0;
+    }
+
+    if (uint32_t dropped = _dropped_events.exchange(0))
+    {
+        gliLog(LogLevel::Warning, "App", "read_window_events", "Input event queue full, dropped %u events.", dropped);
+    }
+}
+
+
+void App::engine_loop()
+{
+    GLI_PROFILE_THREAD("Engine");
+
+    _opengl.make_current(true);
+    if (!on_create())
+    {
+        m_quit = true;
+    }
+    _opengl.make_current(false);
+
+    ShowWindow(m_hwnd, SW_SHOW);
+    m_frame_timer.reset();
+
+    // SetWindowText waits for the message thread, so the title only shows a summary a few times a second
+    auto title_time = std::chrono::steady_clock::now();
+
+    while (!m_quit)
+    {
+        GLI_PROFILE_FRAME();
+        m_frame_arena.reset();
+        memory_frame();
+        float delta = m_frame_timer.tick();
+
+        if (std::chrono::steady_clock::now() - title_time >= std::chrono::milliseconds(250))
+        {
+            title_time = std::chrono::steady_clock::now();
+            FrameStats stats = frame_stats();
+            float fps = stats.p50 > 0.0f ? 1.0f / stats.p50 : 0.0f; // No frames timed yet
+            wchar_t title[256];
+            swprintf(title, 256, L"%s - %0.2f ms (%0.2f fps), p99 %0.2f ms, max %0.2f ms", m_title, stats.p50 * 1000.0f, fps,
+                     stats.p99 * 1000.0f, stats.max * 1000.0f);
+            SetWindowText(m_hwnd, title);
+        }
+
+        // The devices fill in the input, unless a script or a replay does
+        if (input_from_devices())
+        {
+            read_window_events(m_input, m_events);
+
+            // Disconnected controllers are only checked for when the device list changes, XInputGetState is slow for them
+            bool poll_controllers = _poll_controllers.exchange(false);
+            XINPUT_STATE xinput_state;
+            auto poll_time = std::chrono::steady_clock::now();
+
+            for (int i = 0; i < 4; ++i)
+            {
+                ControllerInput& controller = m_input.controllers[i];
+                uint16_t previous_buttons = controller.connected ? controller.buttons : 0;
+
+                if (poll_controllers || _controller_connected[i])
+                {
+                    _controller_connected[i] = XInputGetState(i, &xinput_state) == ERROR_SUCCESS;
+                }
+
+                controller = {};
+                controller.connected = _controller_connected[i];
+
+                if (controller.connected)
+                {
+                    const XINPUT_GAMEPAD& pad = xinput_state.Gamepad;
+                    controller.lx = pad.sThumbLX < 0 ? pad.sThumbLX / 32768.0f : pad.sThumbLX / 32767.0f;
+                    controller.ly = pad.sThumbLY < 0 ? pad.sThumbLY / 32768.0f : pad.sThumbLY / 32767.0f;
+                    controller.rx = pad.sThumbRX < 0 ? pad.sThumbRX / 32768.0f : pad.sThumbRX / 32767.0f;
+                    controller.ry = pad.sThumbRY < 0 ? pad.sThumbRY / 32768.0f : pad.sThumbRY / 32767.0f;
+                    controller.lt = pad.bLeftTrigger / 255.0f;
+                    controller.rt = pad.bRightTrigger / 255.0f;
+                    controller.buttons = pad.wButtons;
+                }
+
+                // XInput has no messages, so button events are only as precise as the polling
+                uint16_t changed = previous_buttons ^ controller.buttons;
+
+                for (int button = 0; button < 16; ++button)
+                {
+                    if (changed & (1 << button))
+                    {
+                        InputEvent event{};
+                        event.type = controller.buttons & (1 << button) ? Event_ControllerDown : Event_ControllerUp;
+                        event.button = (uint8_t)button;
+                        event.controller = (uint8_t)i;
+                        event.time = poll_time;
+                        m_events.push_back(event);
+                    }
+                }
+            }
+        }
+
+        delta = update_input(delta);
+
+        // Ahead of compositing, so layer changes show this frame
+        {
+            GLI_PROFILE_SCOPE("App::on_pre_update");
+
+            if (!on_pre_update(delta))
+            {
+                m_quit = true;
+            }
+        }
+
+        composite_layers();
+
+        // User update
+        {
+            GLI_PROFILE_SCOPE("App::on_update");
+
+            if (!on_update(delta))
+            {
+                m_quit = true;
+            }
+        }
+
+        if (m_profile_overlay)
+        {
+            draw_profile_overlay();
+        }
+
+        // Present
+        _opengl.begin_frame();
+
+        {
+            GLI_PROFILE_SCOPE("App::on_render");
+            on_render(delta);
+        }
+
+        capture_frame();
+
+        _opengl.end_frame();
+        end_frame();
+    }
+
+    _opengl.make_current(true);
+    on_destroy();
+    _opengl.make_current(false);
+
+    PostMessage(m_hwnd, WM_DESTROY, 0, 0);
+}
+
+
+static void push_event(InputEvent event)
+{
+    event.time = std::chrono::steady_clock::now();
+
+    if (!_events.push(event))
+    {
+        _dropped_events.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+
+// Key messages only say shift, control or alt, the scan code and extended key flag say which one
+static Key key_from_message(WPARAM vk, LPARAM lparam)
+{
+    bool extended = (lparam & (1 << 24)) != 0;
+
+    switch (vk)
+    {
+        case VK_SHIFT:
+        {
+            vk = MapVirtualKey((lparam >> 16) & 0xFF, MAPVK_VSC_TO_VK_EX);
+            break;
+        }
+        case VK_CONTROL:
+        {
+            vk = extended ? VK_RCONTROL : VK_LCONTROL;
+            break;
+        }
+        case VK_MENU:
+        {
+            vk = extended ? VK_RMENU : VK_LMENU;
+            break;
+        }
+        case VK_RETURN:
+        {
+            if (extended)
+            {
+                return Key_Num_Enter;
+            }
+
+            break;
+        }
+    }
+
+    return vk < 256 ? _vk_keys[vk] : Key_Count;
+}
+
+
+LRESULT CALLBACK App::window_proc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
+{
+    App* app = (App*)GetProp(hwnd, L"IneptEngineWindow");
+
+    switch (msg)
+    {
+        case WM_ACTIVATEAPP:
+        {
+            _active = !!wparam;
+            break;
+        }
+        case WM_CLOSE:
+        {
+            app->m_quit = true;
+            return 0;
+        }
+        case WM_DESTROY:
+        {
+            PostQuitMessage(0);
+            return 0;
+        }
+        case WM_DEVICECHANGE:
+        {
+            _poll_controllers = true;
+            return 0;
+        }
+        case WM_MOUSELEAVE:
+        {
+            _mouse_active = false;
+            return 0;
+        }
+        case WM_MOUSEMOVE:
+        case WM_LBUTTONDOWN:
+        case WM_LBUTTONUP:
+        case WM_MBUTTONDOWN:
+        case WM_MBUTTONUP:
+        case WM_RBUTTONDOWN:
+        case WM_RBUTTONUP:
+        {
+            // Signed, the mouse is captured while a button is down and can be left of or above the window
+            int window_scale = app->m_window_width / app->m_screen_width;
+            InputEvent event{};
+            event.x = (short)(lparam & 0xFFFF) / window_scale;
+            event.y = (short)((lparam >> 16) & 0xFFFF) / window_scale;
+
+            if (msg == WM_MOUSEMOVE)
+            {
+                event.type = Event_MouseMove;
+                _mouse_active = true;
+            }
+            else
+            {
+                bool down = msg == WM_LBUTTONDOWN || msg == WM_MBUTTONDOWN || msg == WM_RBUTTONDOWN;
+                event.type = down ? Event_MouseDown : Event_MouseUp;
+                event.button = msg == WM_LBUTTONDOWN || msg == WM_LBUTTONUP ? Left : msg == WM_MBUTTONDOWN || msg == WM_MBUTTONUP ? Middle : Right;
+
+                // So the release still arrives when it happens outside the window
+                if (down)
+                {
+                    SetCapture(hwnd);
+                }
+                else if (!(wparam & (MK_LBUTTON | MK_MBUTTON | MK_RBUTTON)))
+                {
+                    ReleaseCapture();
+                }
+            }
+
+            push_event(event);
+            return 0;
+        }
+        case WM_MOUSEWHEEL:
+        {
+            InputEvent event{};
+            event.type = Event_MouseWheel;
+            event.value = GET_WHEEL_DELTA_WPARAM(wparam);
+            push_event(event);
+            return 0;
+        }
+        case WM_KEYDOWN:
+        case WM_KEYUP:
+        case WM_SYSKEYDOWN:
+        case WM_SYSKEYUP:
+        {
+            Key key = key_from_message(wparam, lparam);
+
+            if (key != Key_Count)
+            {
+                InputEvent event{};
+                event.type = msg == WM_KEYDOWN || msg == WM_SYSKEYDOWN ? Event_KeyDown : Event_KeyUp;
+                event.repeat = event.type == Event_KeyDown && (lparam & (1 << 30)) != 0;
+                event.key = key;
+
+                // Print screen only ever sends the release
+                if (wparam == VK_SNAPSHOT && event.type == Event_KeyUp)
+                {
+                    event.type = Event_KeyDown;
+                    push_event(event);
+                    event.type = Event_KeyUp;
+                }
+
+                push_event(event);
+            }
+
+            // F10 would open the window menu
+            if (msg == WM_SYSKEYDOWN && wparam == VK_F10)
+            {
+                return 0;
+            }
+
+            break;
+        }
+        case WM_CHAR:
+        {
+            InputEvent event{};
+            event.type = Event_Char;
+            event.value = (int)wparam;
+            push_event(event);
+            return 0;
+        }
+    }
+
+    return DefWindowProc(hwnd, msg, wparam, lparam);
+}
+
+
+char* wchar_to_utf8(const wchar_t* mbcs)
+{
+    int utf8_len = WideCharToMultiByte(CP_UTF8, 0, mbcs, -1, NULL, 0, NULL, NULL);
+    char* utf8 = (char*)malloc(utf8_len);
+    WideCharToMultiByte(CP_UTF8, 0, mbcs, -1, utf8, utf8_len + 1, NULL, NULL);
+    return utf8;
+}
+
+
+wchar_t* utf8_to_wchar(const char* utf8)
+{
+    int mbcs_len = MultiByteToWideChar(CP_UTF8, 0, utf8, -1, NULL, 0);
+    wchar_t* mbcs = (wchar_t*)malloc(sizeof(wchar_t) * mbcs_len);
+    MultiByteToWideChar(CP_UTF8, 0, utf8, -1, mbcs, mbcs_len);
+    return mbcs;
+}
+
+} // namespace gli
+
+
+int wWinMainInternal(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdLine, int nCmdShow)
+{
+    CoInitializeEx(0, COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE);
+
+    std::vector<char*> argv(__argc);
+
+    if (__wargv)
+    {
+        for (int i = 0; i < __argc; ++i)
+        {
+            argv[i] = gli::wchar_to_utf8(__wargv[i]);
+        }
+    }
+    else
+    {
+        for (int i = 0; i < __argc; ++i)
+        {
+            argv[i] = __argv[i];
+        }
+    }
+
+    int result = gli_main(__argc, argv.data());
+
+
+    if (__wargv)
+    {
+        for (char*& argptr : argv)
+        {
+            free(argptr);
+        }
+    }
+
+    CoUninitialize();
+
+    return 0;
+}
+
+
+int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdLine, int nCmdShow)
+{
+    int result;
+
+    if (IsDebuggerPresent())
+    {
+        result = wWinMainInternal(hInstance, hPrevInstance, GetCommandLineW(), nCmdShow);
+    }
+    else
+    {
+        __try
+        {
+            result = wWinMainInternal(hInstance, hPrevInstance, GetCommandLineW(), nCmdShow);
+        }
+        __except (UnhandledExceptionFilter(GetExceptionInformation()))
+        {
+            MessageBoxW(0, L"A wild exception appears! The application will die horribly now.", L"Oh no!", MB_ICONERROR | MB_OK);
+            result = -1;
+        }
+    }
+
+    return result;
+}
+
+
+#ifdef WIN32
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR pCmdLine, int nCmdShow)
+{
+    int result;
+
+    if (IsDebuggerPresent())
+    {
+        result = wWinMainInternal(hInstance, hPrevInstance, GetCommandLineW(), nCmdShow);
+    }
+    else
+    {
+        __try
+        {
+            result = wWinMainInternal(hInstance, hPrevInstance, GetCommandLineW(), nCmdShow);
+        }
+        __except (UnhandledExceptionFilter(GetExceptionInformation()))
+        {
+            MessageBoxW(0, L"A wild exception appears! The application will die horribly now.", L"Oh no!", MB_ICONERROR | MB_OK);
+            result = -1;
+        }
+    }
+
+    return result;
+}
+#endif
+
+#endif // GLI_HEADLESS
@@ -1,10 +1,16 @@
 #include "gli_debug.h"
 #include "gli_log.h"
 
+#ifdef _MSC_VER
 #include <intrin.h>
+#endif
 
 void gli_assert(const char* file, int line, const char* message)
 {
     gli::logf("%s(%d): ASSERT FAILED: %s\n", file, line, message);
+#ifdef _MSC_VER
     __debugbreak();
+#else
+    __builtin_trap();
+#endif
 }
@@ -0,0 +1,126 @@
+#include "gli_dirty.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace gli
+{
+
+static bool contains(const DirtyRect& outer, const DirtyRect& inner)
+{
+    return inner.x0 >= outer.x0 && inner.y0 >= outer.y0 && inner.x1 <= outer.x1 && inner.y1 <= outer.y1;
+}
+
+
+static DirtyRect merge(const DirtyRect& a, const DirtyRect& b)
+{
+    return { std::min(a.x0, b.x0), std::min(a.y0, b.y0), std::max(a.x1, b.x1), std::max(a.y1, b.y1) };
+}
+
+
+static int64_t area(const DirtyRect& r)
+{
+    return int64_t(r.x1 - r.x0) * (r.y1 - r.y0);
+}
+
+
+void DirtyRects::reset(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+    m_count = 0;
+}
+
+
+void DirtyRects::clear()
+{
+    m_count = 0;
+}
+
+
+void DirtyRects::add(int x0, int y0, int x1, int y1)
+{
+    DirtyRect rect{ std::max(x0, 0), std::max(y0, 0), std::min(x1, m_width), std::min(y1, m_height) };
+
+    if (rect.x0 >= rect.x1 || rect.y0 >= rect.y1)
+    {
+        return;
+    }
+
+    // Most draws land somewhere that's already dirty
+    for (int i = 0; i < m_count; ++i)
+    {
+        if (contains(m_rects[i], rect))
+        {
+            return;
+        }
+    }
+
+    if (m_count == MaxRects)
+    {
+        int best = 0;
+        int64_t best_growth = INT64_MAX;
+
+        for (int i = 0; i < m_count; ++i)
+        {
+            int64_t growth = area(merge(m_rects[i], rect)) - area(m_rects[i]);
+
+            if (growth < best_growth)
+            {
+                best = i;
+                best_growth = growth;
+            }
+        }
+
+        rect = merge(m_rects[best], rect);
+        m_rects[best] = m_rects[--m_count];
+    }
+
+    // Drop anything the new rectangle covers
+    int count = 0;
+
+    for (int i = 0; i < m_count; ++i)
+    {
+        if (!contains(rect, m_rects[i]))
+        {
+            m_rects[count++] = m_rects[i];
+        }
+    }
+
+    m_rects[count] = rect;
+    m_count = count + 1;
+}
+
+
+void DirtyRects::add_all()
+{
+    m_rects[0] = { 0, 0, m_width, m_height };
+    m_count = (m_width > 0 && m_height > 0) ? 1 : 0;
+}
+
+
+void DirtyRects::coalesce()
+{
+    if (m_count < 2)
+    {
+        return;
+    }
+
+    DirtyRect bounds = m_rects[0];
+    int64_t total = 0;
+
+    for (int i = 0; i < m_count; ++i)
+    {
+        bounds = merge(bounds, m_rects[i]);
+        total += area(m_rects[i]);
+    }
+
+    // Each upload has a fixed cost, so a few wasted pixels are cheaper than another call
+    if (total * 4 >= area(bounds) * 3)
+    {
+        m_rects[0] = bounds;
+        m_count = 1;
+    }
+}
+
+} // namespace gli
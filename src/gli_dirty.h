@@ -0,0 +1,43 @@
+#pragma once
+
+namespace gli
+{
+
+// Half open: covers x0 <= x < x1, y0 <= y < y1
+struct DirtyRect
+{
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+};
+
+// The parts of a framebuffer that changed since the last clear, kept as a handful of rectangles. Rectangles already covered
+// are dropped, and once all slots are used a new rectangle is merged into whichever one grows the least.
+class DirtyRects
+{
+public:
+    static const int MaxRects = 16;
+
+    void reset(int width, int height);
+    void clear();
+
+    // Clipped to the bounds given to reset
+    void add(int x0, int y0, int x1, int y1);
+    void add_all();
+
+    // Collapse to the bounding rectangle when that's barely more than the rectangles themselves, so mostly dirty frames
+    // go up in one piece
+    void coalesce();
+
+    int count() const { return m_count; }
+    const DirtyRect* rects() const { return m_rects; }
+
+private:
+    int m_width{};
+    int m_height{};
+    int m_count{};
+    DirtyRect m_rects[MaxRects]{};
+};
+
+} // namespace gli
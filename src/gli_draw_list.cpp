@@ -0,0 +1,304 @@
+#include "gli_draw_list.h"
+
+#include "gli_debug.h"
+#include "gli_font.h"
+#include "gli_job.h"
+#include "gli_profile.h"
+#include "gli_sprite.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace gli
+{
+
+static const int64_t BoundsLimit = 1 << 30;
+
+
+DirtyRect draw_command_bounds(const DrawCommand& command)
+{
+    int64_t x0 = command.x;
+    int64_t y0 = command.y;
+    int64_t x1;
+    int64_t y1;
+
+    switch (command.type)
+    {
+        case DrawCommand::Clear:
+        {
+            x0 = y0 = -BoundsLimit;
+            x1 = y1 = BoundsLimit;
+            break;
+        }
+        case DrawCommand::SetPixel:
+        {
+            x1 = x0 + 1;
+            y1 = y0 + 1;
+            break;
+        }
+        case DrawCommand::Line:
+        {
+            x0 = std::min(command.x, command.w);
+            y0 = std::min(command.y, command.h);
+            x1 = std::max(command.x, command.w) + (int64_t)1;
+            y1 = std::max(command.y, command.h) + (int64_t)1;
+            break;
+        }
+        case DrawCommand::Glyphs:
+        {
+            x1 = x0 + (int64_t)command.param * command.font->glyph_width();
+            y1 = y0 + command.font->glyph_height();
+            break;
+        }
+        default:
+        {
+            x1 = x0 + command.w;
+            y1 = y0 + command.h;
+            break;
+        }
+    }
+
+    auto limit = [](int64_t v) { return (int)std::min(std::max(v, -BoundsLimit), BoundsLimit); };
+    return { limit(x0), limit(y0), limit(x1), limit(y1) };
+}
+
+
+static void execute_sprite(const Raster<Pixel>& raster, const DrawCommand& command)
+{
+    if (command.type == DrawCommand::TransformedSprite)
+    {
+        raster_transformed_sprite(raster, command.x, command.y, command.w, command.h, *(const SpriteTransform*)command.data);
+        return;
+    }
+
+    const Sprite& sprite = *(const Sprite*)command.data;
+
+    if (command.type == DrawCommand::Sprite)
+    {
+        raster_sprite(raster, command.x, command.y, sprite, command.ox, command.oy, command.w, command.h);
+    }
+    else
+    {
+        raster_blend_sprite(raster, command.x, command.y, sprite, command.ox, command.oy, command.w, command.h, command.alpha);
+    }
+}
+
+
+static void execute_sprite(const Raster<uint8_t>&, const DrawCommand&) {}
+
+
+template <typename T>
+void execute_draw_command(const Raster<T>& raster, const DrawCommand& command)
+{
+    switch (command.type)
+    {
+        case DrawCommand::Clear:
+        {
+            raster_clear(raster, T(command.fg));
+            break;
+        }
+        case DrawCommand::SetPixel:
+        {
+            raster_set_pixel(raster, command.x, command.y, T(command.fg));
+            break;
+        }
+        case DrawCommand::Line:
+        {
+            raster_line(raster, command.x, command.y, command.w, command.h, T(command.fg));
+            break;
+        }
+        case DrawCommand::Rect:
+        {
+            raster_rect(raster, command.x, command.y, command.w, command.h, T(command.fg));
+            break;
+        }
+        case DrawCommand::FillRect:
+        {
+            raster_fill_rect(raster, command.x, command.y, command.w, command.h, command.param, T(command.fg), T(command.bg));
+            break;
+        }
+        case DrawCommand::Glyphs:
+        {
+            raster_glyphs(raster, command.x, command.y, (const char*)command.data, command.param, *command.font, T(command.fg), T(command.bg));
+            break;
+        }
+        case DrawCommand::CopyRect:
+        {
+            raster_copy_rect(raster, command.x, command.y, command.w, command.h, (const uint8_t*)command.data, command.param, command.palette);
+            break;
+        }
+        case DrawCommand::CopyRectScaled:
+        {
+            raster_copy_rect_scaled(raster, command.x, command.y, command.w, command.h, (const uint8_t*)command.data, command.param,
+                                    command.ox, command.palette);
+            break;
+        }
+        case DrawCommand::Sprite:
+        case DrawCommand::BlendSprite:
+        case DrawCommand::TransformedSprite:
+        {
+            execute_sprite(raster, command);
+            break;
+        }
+    }
+}
+
+
+static bool uses_palette(DrawCommand::Type type)
+{
+    return type == DrawCommand::CopyRect || type == DrawCommand::CopyRectScaled;
+}
+
+
+static bool copies_data(DrawCommand::Type type)
+{
+    return type == DrawCommand::Glyphs || type == DrawCommand::CopyRect || type == DrawCommand::CopyRectScaled ||
+           type == DrawCommand::TransformedSprite;
+}
+
+
+void DrawList::reset(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+    m_tiles_x = (width + TileSize - 1) / TileSize;
+    m_tiles_y = (height + TileSize - 1) / TileSize;
+    m_commands.clear();
+    m_data.clear();
+    m_states.clear();
+    m_bins.clear();
+    m_bins.resize(m_tiles_x * m_tiles_y);
+}
+
+
+bool DrawList::record(const DrawCommand& command, const void* data, size_t size, const DirtyRect& clip, BlendOp op, BlendKernel kernel,
+                      uint8_t constant)
+{
+    DirtyRect bounds = draw_command_bounds(command);
+    int x0 = std::max({ bounds.x0, clip.x0, 0 });
+    int y0 = std::max({ bounds.y0, clip.y0, 0 });
+    int x1 = std::min({ bounds.x1, clip.x1, m_width });
+    int y1 = std::min({ bounds.y1, clip.y1, m_height });
+
+    if (x0 >= x1 || y0 >= y1)
+    {
+        return true;
+    }
+
+    DrawCommand recorded = command;
+
+    if (m_states.empty() || m_states.back().op != op || m_states.back().kernel.span != kernel.span ||
+        m_states.back().constant != constant || memcmp(&m_states.back().clip, &clip, sizeof(DirtyRect)) != 0)
+    {
+        if (m_states.size() > UINT16_MAX)
+        {
+            return false;
+        }
+
+        m_states.push_back({ clip, op, kernel, constant });
+    }
+
+    recorded.state = (uint16_t)(m_states.size() - 1);
+
+    // Strings, copy_rect sources (and the palette to expand them with) and sprite transforms are stored as offsets into m_data,
+    // which moves as it grows
+    if (uses_palette(command.type))
+    {
+        m_data.resize((m_data.size() + alignof(Pixel) - 1) & ~(alignof(Pixel) - 1));
+        recorded.palette = (const Pixel*)(uintptr_t)m_data.size();
+        m_data.insert(m_data.end(), (const char*)command.palette, (const char*)(command.palette + 256));
+    }
+
+    if (copies_data(command.type))
+    {
+        m_data.resize((m_data.size() + alignof(SpriteTransform) - 1) & ~(alignof(SpriteTransform) - 1));
+        recorded.data = (const void*)(uintptr_t)m_data.size();
+        m_data.insert(m_data.end(), (const char*)data, (const char*)data + size);
+    }
+
+    uint32_t index = (uint32_t)m_commands.size();
+    m_commands.push_back(recorded);
+
+    for (int ty = y0 / TileSize; ty <= (y1 - 1) / TileSize; ++ty)
+    {
+        for (int tx = x0 / TileSize; tx <= (x1 - 1) / TileSize; ++tx)
+        {
+            m_bins[ty * m_tiles_x + tx].push_back(index);
+        }
+    }
+
+    return true;
+}
+
+
+template <typename T>
+void DrawList::replay(const Raster<T>& raster)
+{
+    if (m_commands.empty())
+    {
+        return;
+    }
+
+    GLI_PROFILE_SCOPE("DrawList::replay");
+
+    JobSystem::get()->parallel_for(0, m_tiles_x * m_tiles_y, 1, [this, &raster](int tile, int) {
+        const std::vector<uint32_t>& bin = m_bins[tile];
+
+        if (bin.empty())
+        {
+            return;
+        }
+
+        // Tiles run on any thread, so each thread builds its blended spans in its own buffer
+        static thread_local std::vector<Pixel> span_buffer;
+
+        int tx = tile % m_tiles_x;
+        int ty = tile / m_tiles_x;
+        int tile_x1 = std::min((tx + 1) * TileSize, m_width);
+        int tile_y1 = std::min((ty + 1) * TileSize, m_height);
+        Raster<T> tile_raster = raster;
+        tile_raster.span_buffer = &span_buffer;
+
+        for (uint32_t index : bin)
+        {
+            DrawCommand command = m_commands[index];
+            const State& state = m_states[command.state];
+            tile_raster.clip_x0 = std::max(state.clip.x0, tx * TileSize);
+            tile_raster.clip_y0 = std::max(state.clip.y0, ty * TileSize);
+            tile_raster.clip_x1 = std::min(state.clip.x1, tile_x1);
+            tile_raster.clip_y1 = std::min(state.clip.y1, tile_y1);
+            tile_raster.blend_op = state.op;
+            tile_raster.blend_kernel = state.kernel;
+            tile_raster.blend_constant = state.constant;
+
+            if (uses_palette(command.type))
+            {
+                command.palette = (const Pixel*)(m_data.data() + (uintptr_t)command.palette);
+            }
+
+            if (copies_data(command.type))
+            {
+                command.data = m_data.data() + (uintptr_t)command.data;
+            }
+
+            execute_draw_command(tile_raster, command);
+        }
+    });
+
+    m_commands.clear();
+    m_data.clear();
+    m_states.clear();
+
+    for (std::vector<uint32_t>& bin : m_bins)
+    {
+        bin.clear();
+    }
+}
+
+
+template void execute_draw_command(const Raster<Pixel>&, const DrawCommand&);
+template void execute_draw_command(const Raster<uint8_t>&, const DrawCommand&);
+template void DrawList::replay(const Raster<Pixel>&);
+template void DrawList::replay(const Raster<uint8_t>&);
+
+} // namespace gli
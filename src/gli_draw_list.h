@@ -0,0 +1,101 @@
+#pragma once
+
+#include "gli_core.h" // for gli::Pixel, gli::BlendOp, gli::BlendKernel
+#include "gli_dirty.h"
+#include "gli_raster.h"
+
+#include <vector>
+
+namespace gli
+{
+
+// One draw call, as recorded by App. Immediate drawing executes it straight away, deferred drawing records it in a DrawList.
+struct DrawCommand
+{
+    enum Type : uint8_t
+    {
+        Clear,
+        SetPixel,
+        Line,
+        Rect,
+        FillRect,
+        Glyphs,
+        CopyRect,
+        Sprite,
+        BlendSprite,
+        CopyRectScaled,
+        TransformedSprite
+    };
+
+    Type type;
+    uint8_t alpha;        // BlendSprite
+    uint16_t state;       // Index of the clip and blend state it was recorded with, set by DrawList
+    int x;
+    int y;
+    int w;                // Line end point x
+    int h;                // Line end point y
+    int ox;               // Sprite source offset, CopyRectScaled pixel scale
+    int oy;
+    int param;            // FillRect border width, Glyphs string length, CopyRect source stride
+    uint32_t fg;          // Pixel argb or palette index
+    uint32_t bg;
+    const void* data;     // Sprite, string, CopyRect source or SpriteTransform
+
+    union
+    {
+        const Font* font;     // Glyphs
+        const Pixel* palette; // CopyRect, CopyRectScaled
+    };
+};
+
+// Conservative bounds of the pixels a command can touch, before clipping
+DirtyRect draw_command_bounds(const DrawCommand& command);
+
+template <typename T> void execute_draw_command(const Raster<T>& raster, const DrawCommand& command);
+
+// Deferred draw commands binned into 64x64 screen tiles. Replaying draws the tiles in parallel on the JobSystem, each one
+// clipped to its tile and in submission order, so the result is the same as executing every command in order.
+class DrawList
+{
+public:
+    static const int TileSize = 64;
+
+    DrawList() = default;
+    DrawList(const DrawList&) = delete;
+
+    DrawList& operator=(const DrawList&) = delete;
+
+    void reset(int width, int height);
+
+    // size bytes of data are copied, so callers can reuse strings and buffers straight away. The command is clipped to clip as
+    // well as its tiles when it's replayed. Returns false, recording nothing, when the command needs a new clip and blend state
+    // and the 65536 a 16 bit DrawCommand::state can index are used up; replay the list and record it again.
+    bool record(const DrawCommand& command, const void* data, size_t size, const DirtyRect& clip, BlendOp op, BlendKernel kernel,
+                uint8_t constant);
+
+    bool empty() const { return m_commands.empty(); }
+
+    // Draw everything recorded into the raster (its clip rectangle and blend state are replaced per tile and command) and
+    // clear the list
+    template <typename T> void replay(const Raster<T>& raster);
+
+private:
+    struct State
+    {
+        DirtyRect clip;
+        BlendOp op;
+        BlendKernel kernel;
+        uint8_t constant;
+    };
+
+    int m_width{};
+    int m_height{};
+    int m_tiles_x{};
+    int m_tiles_y{};
+    std::vector<DrawCommand> m_commands{};
+    std::vector<char> m_data{};
+    std::vector<State> m_states{};
+    std::vector<std::vector<uint32_t>> m_bins{};
+};
+
+} // namespace gli
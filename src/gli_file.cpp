@@ -48,7 +48,7 @@ bool FileContainer::read_entire_file(const char* path, std::vector<uint8_t>& con
 
 File::File(FileContainer* container, void* handle)
     : _container(container)
-    , _handle()
+    , _handle(handle)
 {
 }
 
@@ -80,11 +80,11 @@ void File::close()
 class FileContainerSystem : public FileContainer
 {
 public:
-    bool attach(const char* container_name) override { return true; }
+    bool attach(const char*) override { return true; }
     void dettach() override {}
-    bool open_internal(const char* path, void*& handle) override { return false; }
-    void close_internal(void* handle) override {}
-    bool valid_internal(void* handle) override { return false; }
+    bool open_internal(const char*, void*&) override { return false; }
+    void close_internal(void*) override {}
+    bool valid_internal(void*) override { return false; }
     bool read_entire_file_internal(const char* path, std::vector<uint8_t>& contents) override
     {
         // FIXME: do this better (Windows file functions / unicode paths / etc)
@@ -156,7 +156,7 @@ public:
     }
 
 
-    bool open_internal(const char* path, void*& handle) override
+    bool open_internal(const char* path, void*&) override
     {
         if (!_unzfile)
         {
@@ -193,7 +193,7 @@ public:
     }
 
 
-    void close_internal(void* handle) override
+    void close_internal(void*) override
     {
         if (_unzfile && _file_opened)
         {
@@ -203,11 +203,14 @@ public:
     }
 
 
-    bool valid_internal(void* handle) override { return _unzfile && _file_opened; }
+    bool valid_internal(void*) override { return _unzfile && _file_opened; }
 
 
     bool read_entire_file_internal(const char* path, std::vector<uint8_t>& contents) override
     {
+        // One file at a time per zip, whichever thread asks
+        std::lock_guard<std::mutex> lock(_mutex);
+
         if (!_unzfile)
         {
             gliLog(LogLevel::Error, "File", "FileContainerZipFile::read_entire_file_internal", "Not attached.");
@@ -260,6 +263,7 @@ private:
     unzFile _unzfile = nullptr;
     bool _file_opened = false;
     unz_file_info _current_file_info;
+    std::mutex _mutex;
 };
 
 
@@ -370,6 +374,7 @@ bool FileSystem::read_entire_file(const char* path, std::vector<uint8_t>& conten
 
 FileContainer* FileSystem::get_or_create_container(const std::string& container_name)
 {
+    std::lock_guard<std::mutex> lock(_mutex);
     FileContainerLookup::const_iterator it = _container_lookup.find(container_name);
 
     if (it == _container_lookup.end())
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -71,6 +72,7 @@ private:
 
     FileContainerList _containers;
     FileContainerLookup _container_lookup;
+    std::mutex _mutex; // Guards the containers, so files can be read from any thread
 
     FileContainer* get_or_create_container(const std::string& container_name);
 
@@ -0,0 +1,78 @@
+#include "gli_font.h"
+
+#include "gli_debug.h"
+
+#include <map>
+#include <mutex>
+#include <tuple>
+
+namespace gli
+{
+
+Font::Font(const int* glyphs, int glyph_width, int glyph_height, int glyph_count)
+    : m_glyph_width(glyph_width)
+    , m_glyph_height(glyph_height)
+    , m_glyph_count(glyph_count)
+{
+    gliAssert(glyph_width > 0 && glyph_width <= 32);
+
+    m_rows.resize(glyph_height * glyph_count);
+    uint32_t* row = m_rows.data();
+
+    for (int i = 0; i < glyph_count * glyph_height; ++i)
+    {
+        uint32_t mask = 0;
+
+        for (int x = 0; x < glyph_width; ++x)
+        {
+            mask |= (*glyphs++ ? 1u : 0u) << x;
+        }
+
+        *row++ = mask;
+    }
+}
+
+
+const Font& Font::from_glyphs(const int* glyphs, int glyph_width, int glyph_height)
+{
+    // Entries are never removed, and map nodes don't move, so the returned font lives as long as the process. Draw commands
+    // hold on to it until the frame is rendered.
+    static std::mutex mutex;
+    static std::map<std::tuple<const int*, int, int>, Font> fonts;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Font& font = fonts[std::make_tuple(glyphs, glyph_width, glyph_height)];
+
+    if (font.m_glyph_count == 0)
+    {
+        font = Font(glyphs, glyph_width, glyph_height);
+    }
+
+    return font;
+}
+
+
+int Font::glyph_width() const
+{
+    return m_glyph_width;
+}
+
+
+int Font::glyph_height() const
+{
+    return m_glyph_height;
+}
+
+
+int Font::glyph_count() const
+{
+    return m_glyph_count;
+}
+
+
+const uint32_t* Font::glyph(uint8_t c) const
+{
+    return m_rows.data() + ((c < m_glyph_count ? c : 0) * m_glyph_height);
+}
+
+} // namespace gli
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace gli
+{
+
+// Bitmap font packed one bit per pixel: each glyph row is a mask with bit n set where pixel n is foreground
+class Font
+{
+public:
+    Font() = default;
+    Font(const int* glyphs, int glyph_width, int glyph_height, int glyph_count = 256);
+
+    // Converts a font in the one int per pixel format fontgen generates (e.g. vga9_glyphs). Conversions are cached by glyph
+    // array and size and kept until exit, so only the first lookup pays for it and the reference stays valid.
+    static const Font& from_glyphs(const int* glyphs, int glyph_width, int glyph_height);
+
+    int glyph_width() const;
+    int glyph_height() const;
+    int glyph_count() const;
+
+    const uint32_t* glyph(uint8_t c) const;
+
+private:
+    int m_glyph_width{};
+    int m_glyph_height{};
+    int m_glyph_count{};
+    std::vector<uint32_t> m_rows{};
+};
+
+} // namespace gli
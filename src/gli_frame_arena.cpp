@@ -0,0 +1,105 @@
+#include "gli_frame_arena.h"
+
+#include "gli_debug.h"
+
+#include <algorithm>
+#include <new>
+
+namespace gli
+{
+
+FrameArena::FrameArena(size_t block_size) : m_block_size(block_size)
+{
+}
+
+
+FrameArena::~FrameArena()
+{
+    free_blocks();
+}
+
+
+void FrameArena::free_blocks()
+{
+    while (m_blocks)
+    {
+        Block* next = m_blocks->next;
+        ::operator delete(m_blocks);
+        m_blocks = next;
+    }
+}
+
+
+void* FrameArena::allocate(size_t size, size_t alignment)
+{
+    gliAssert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+    uint8_t* p = (uint8_t*)(((uintptr_t)m_next + alignment - 1) & ~(uintptr_t)(alignment - 1));
+
+    if (!m_next || p + size > m_end)
+    {
+        add_block(size + alignment);
+        p = (uint8_t*)(((uintptr_t)m_next + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    }
+
+    m_next = p + size;
+    ++m_allocations;
+    m_bytes += size;
+    return p;
+}
+
+
+void FrameArena::reset()
+{
+    m_last_allocations = m_allocations;
+    m_last_bytes = m_bytes;
+    m_allocations = 0;
+    m_bytes = 0;
+
+    // Fold a frame that overflowed into a single block that would have held it
+    if (m_blocks && m_blocks->next)
+    {
+        size_t total = capacity();
+        free_blocks();
+        m_block_size = std::max(m_block_size, total);
+    }
+
+    if (m_blocks)
+    {
+        m_next = (uint8_t*)(m_blocks + 1);
+        m_end = m_next + m_blocks->size;
+    }
+    else
+    {
+        m_next = nullptr;
+        m_end = nullptr;
+    }
+}
+
+
+size_t FrameArena::capacity() const
+{
+    size_t total = 0;
+
+    for (Block* block = m_blocks; block; block = block->next)
+    {
+        total += block->size;
+    }
+
+    return total;
+}
+
+
+FrameArena::Block* FrameArena::add_block(size_t min_size)
+{
+    size_t size = std::max(m_block_size, min_size);
+    Block* block = (Block*)::operator new(sizeof(Block) + size);
+    block->next = m_blocks;
+    block->size = size;
+    m_blocks = block;
+    m_next = (uint8_t*)(block + 1);
+    m_end = m_next + size;
+    return block;
+}
+
+} // namespace gli
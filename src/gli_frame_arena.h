@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#include <memory_resource>
+#define GLI_HAS_PMR 1
+#endif
+
+namespace gli
+{
+
+// A bump allocator for memory that only lives until the end of the frame. App resets it at the top of every frame, so anything
+// allocated from it is gone by the next one, deallocating is a no-op. When a frame needs more than the block it chains extra
+// blocks, and the next reset swaps them for one block big enough for all of it, so a steady frame settles into never calling new.
+// Engine thread only.
+class FrameArena
+{
+public:
+    explicit FrameArena(size_t block_size = 1 << 20);
+    FrameArena(const FrameArena&) = delete;
+    ~FrameArena();
+
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    // Invalidates everything allocated since the last reset
+    void reset();
+
+    // This frame so far, and the whole of the previous frame
+    int allocations() const { return m_allocations; }
+    size_t bytes() const { return m_bytes; }
+    int last_allocations() const { return m_last_allocations; }
+    size_t last_bytes() const { return m_last_bytes; }
+
+    size_t capacity() const;
+
+private:
+    struct Block
+    {
+        Block* next;
+        size_t size;
+    };
+
+    Block* add_block(size_t min_size);
+    void free_blocks();
+
+    Block* m_blocks = nullptr; // Most recent first, allocations come from the head
+    uint8_t* m_next = nullptr;
+    uint8_t* m_end = nullptr;
+    size_t m_block_size;
+    int m_allocations = 0;
+    size_t m_bytes = 0;
+    int m_last_allocations = 0;
+    size_t m_last_bytes = 0;
+};
+
+
+// Standard allocator over a FrameArena, for containers that are built and thrown away within a frame
+template <typename T>
+class FrameAllocator
+{
+public:
+    using value_type = T;
+
+    FrameAllocator(FrameArena& arena) : m_arena(&arena) {}
+
+    template <typename U>
+    FrameAllocator(const FrameAllocator<U>& other) : m_arena(other.arena())
+    {
+    }
+
+    T* allocate(size_t n) { return (T*)m_arena->allocate(n * sizeof(T), alignof(T)); }
+    void deallocate(T*, size_t) {}
+
+    FrameArena* arena() const { return m_arena; }
+
+private:
+    FrameArena* m_arena;
+};
+
+
+template <typename T, typename U>
+bool operator==(const FrameAllocator<T>& a, const FrameAllocator<U>& b)
+{
+    return a.arena() == b.arena();
+}
+
+
+template <typename T, typename U>
+bool operator!=(const FrameAllocator<T>& a, const FrameAllocator<U>& b)
+{
+    return a.arena() != b.arena();
+}
+
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+using FrameString = std::basic_string<char, std::char_traits<char>, FrameAllocator<char>>;
+
+
+#ifdef GLI_HAS_PMR
+// For std::pmr containers. Its upstream is never used, a FrameArena only runs out when new does.
+class FrameMemoryResource : public std::pmr::memory_resource
+{
+public:
+    explicit FrameMemoryResource(FrameArena& arena) : m_arena(arena) {}
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override { return m_arena.allocate(bytes, alignment); }
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    FrameArena& m_arena;
+};
+#endif
+
+} // namespace gli
@@ -0,0 +1,115 @@
+#include "gli_frame_timer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+
+namespace gli
+{
+
+void FrameTimer::reset()
+{
+    m_last_tick = Clock::now();
+    m_deadline = m_last_tick;
+    m_count = 0;
+    m_next = 0;
+}
+
+
+float FrameTimer::tick()
+{
+    Clock::time_point now = Clock::now();
+    float delta = std::chrono::duration<float>(now - m_last_tick).count();
+    m_last_tick = now;
+
+    m_times[m_next] = delta;
+    m_next = (m_next + 1) % WindowSize;
+    m_count = std::min(m_count + 1, (int)WindowSize);
+
+    return delta;
+}
+
+
+void FrameTimer::set_frame_limit(int fps)
+{
+    m_frame_limit = std::max(fps, 0);
+    m_period = fps > 0 ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fps)) : Clock::duration::zero();
+    m_deadline = Clock::now();
+}
+
+
+void FrameTimer::wait()
+{
+    if (m_period == Clock::duration::zero())
+    {
+        return;
+    }
+
+    Clock::time_point now = Clock::now();
+    m_deadline += m_period;
+
+    // After a long frame start over from now instead of rushing through frames to catch up
+    if (m_deadline < now - m_period)
+    {
+        m_deadline = now;
+        return;
+    }
+
+    Clock::duration sleep_time = m_deadline - now - m_sleep_error;
+
+    if (sleep_time > Clock::duration::zero())
+    {
+        std::this_thread::sleep_for(sleep_time);
+
+        // Sleeps overshoot by up to the scheduler's timer period, so keep that much in hand for spinning. The margin
+        // shrinks again slowly if the timer gets more precise.
+        Clock::duration overshoot = Clock::now() - (now + sleep_time);
+        m_sleep_error = std::max(overshoot, m_sleep_error * 15 / 16);
+    }
+
+    while (Clock::now() < m_deadline)
+    {
+        std::this_thread::yield();
+    }
+}
+
+
+FrameStats FrameTimer::stats() const
+{
+    float times[WindowSize];
+    std::copy(m_times, m_times + m_count, times);
+    return summarize_frames(times, m_count);
+}
+
+
+FrameStats summarize_frames(float* times, int count)
+{
+    FrameStats stats{};
+
+    if (count == 0)
+    {
+        return stats;
+    }
+
+    std::sort(times, times + count);
+
+    // Nearest rank
+    auto percentile = [&](int p) { return times[std::max((int)(((int64_t)count * p + 99) / 100) - 1, 0)]; };
+
+    double total = 0.0;
+
+    for (int i = 0; i < count; ++i)
+    {
+        total += times[i];
+    }
+
+    stats.average = (float)(total / count);
+    stats.p50 = percentile(50);
+    stats.p95 = percentile(95);
+    stats.p99 = percentile(99);
+    stats.max = times[count - 1];
+    stats.frame_count = count;
+    return stats;
+}
+
+} // namespace gli
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+
+namespace gli
+{
+
+// Frame times in seconds. FrameTimer::stats covers the last FrameTimer::WindowSize frames.
+struct FrameStats
+{
+    float average;
+    float p50;
+    float p95;
+    float p99;
+    float max;
+    int frame_count;
+};
+
+// Stats for any number of frame times, sorting them in place
+FrameStats summarize_frames(float* times, int count);
+
+// Measures frames with the monotonic clock and optionally paces them to a target rate. Pacing sleeps for most of the wait
+// and spins for the rest, with the spin margin tracking how far sleeps have overshot recently.
+class FrameTimer
+{
+public:
+    static const int WindowSize = 256;
+
+    void reset();
+
+    // Seconds since the previous tick, also recorded for stats
+    float tick();
+
+    // 0 turns pacing off
+    void set_frame_limit(int fps);
+    int frame_limit() const { return m_frame_limit; }
+
+    // Returns once the next frame is due, straight away if pacing is off or the frame is already late
+    void wait();
+
+    FrameStats stats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point m_last_tick{};
+    Clock::time_point m_deadline{};
+    Clock::duration m_period{};
+    Clock::duration m_sleep_error{ std::chrono::milliseconds(1) };
+    int m_frame_limit{};
+    float m_times[WindowSize]{};
+    int m_count{};
+    int m_next{};
+};
+
+} // namespace gli
@@ -0,0 +1,212 @@
+#include "gli_input_log.h"
+
+#include "gli_log.h"
+
+#include <cstring>
+
+namespace gli
+{
+
+static const char LogMagic[4] = { 'G', 'L', 'I', 'I' };
+static const uint16_t LogVersion = 1;
+
+// The header records the key count so logs from a build with a different Key enum are refused instead of misread
+struct LogHeader
+{
+    char magic[4];
+    uint16_t version;
+    uint16_t key_count;
+};
+
+
+InputLog::~InputLog()
+{
+    close();
+}
+
+
+bool InputLog::open_write(const std::string& path)
+{
+    close();
+
+    m_file = fopen(path.c_str(), "wb");
+
+    if (!m_file)
+    {
+        gliLog(LogLevel::Error, "Input", "InputLog::open_write", "Failed to open %s.", path.c_str());
+        return false;
+    }
+
+    LogHeader header{};
+    memcpy(header.magic, LogMagic, sizeof(LogMagic));
+    header.version = LogVersion;
+    header.key_count = Key_Count;
+    fwrite(&header, sizeof(header), 1, m_file);
+
+    m_writing = true;
+    m_frame_count = 0;
+    return true;
+}
+
+
+bool InputLog::open_read(const std::string& path)
+{
+    close();
+
+    m_file = fopen(path.c_str(), "rb");
+
+    if (!m_file)
+    {
+        gliLog(LogLevel::Error, "Input", "InputLog::open_read", "Failed to open %s.", path.c_str());
+        return false;
+    }
+
+    LogHeader header{};
+
+    if (fread(&header, sizeof(header), 1, m_file) != 1 || memcmp(header.magic, LogMagic, sizeof(LogMagic)) != 0 ||
+        header.version != LogVersion || header.key_count != Key_Count)
+    {
+        gliLog(LogLevel::Error, "Input", "InputLog::open_read", "%s is not an input log from this version.", path.c_str());
+        close();
+        return false;
+    }
+
+    m_writing = false;
+    m_frame_count = 0;
+    return true;
+}
+
+
+void InputLog::close()
+{
+    if (m_file)
+    {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+
+void InputLog::write(const App::InputFrame& input, float delta)
+{
+    uint8_t buffer[256];
+    uint8_t* out = buffer;
+
+    auto put = [&out](const void* data, size_t size) {
+        memcpy(out, data, size);
+        out += size;
+    };
+
+    put(&delta, sizeof(delta));
+
+    uint8_t key_bits[(Key_Count + 7) / 8] = {};
+
+    for (int i = 0; i < Key_Count; ++i)
+    {
+        key_bits[i / 8] |= (uint8_t)(input.keys[i] << (i % 8));
+    }
+
+    put(key_bits, sizeof(key_bits));
+
+    int32_t mouse[3] = { input.mouse_x, input.mouse_y, input.mouse_wheel };
+    put(mouse, sizeof(mouse));
+
+    // Mouse buttons in the low bits, connected controllers in the high ones
+    uint8_t flags = 0;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        flags |= (uint8_t)(input.mouse_buttons[i] << i);
+    }
+
+    for (int i = 0; i < 4; ++i)
+    {
+        flags |= (uint8_t)(input.controllers[i].connected << (4 + i));
+    }
+
+    put(&flags, sizeof(flags));
+
+    for (const App::ControllerInput& controller : input.controllers)
+    {
+        if (controller.connected)
+        {
+            float axes[6] = { controller.lx, controller.ly, controller.rx, controller.ry, controller.lt, controller.rt };
+            put(&controller.buttons, sizeof(controller.buttons));
+            put(axes, sizeof(axes));
+        }
+    }
+
+    fwrite(buffer, out - buffer, 1, m_file);
+    ++m_frame_count;
+}
+
+
+bool InputLog::read(App::InputFrame& input, float& delta)
+{
+    uint8_t key_bits[(Key_Count + 7) / 8];
+    int32_t mouse[3];
+    uint8_t flags;
+
+    if (fread(&delta, sizeof(delta), 1, m_file) != 1 || fread(key_bits, sizeof(key_bits), 1, m_file) != 1 ||
+        fread(mouse, sizeof(mouse), 1, m_file) != 1 || fread(&flags, sizeof(flags), 1, m_file) != 1)
+    {
+        return false;
+    }
+
+    for (int i = 0; i < Key_Count; ++i)
+    {
+        input.keys[i] = (key_bits[i / 8] >> (i % 8)) & 1;
+    }
+
+    input.mouse_x = mouse[0];
+    input.mouse_y = mouse[1];
+    input.mouse_wheel = mouse[2];
+
+    for (int i = 0; i < 3; ++i)
+    {
+        input.mouse_buttons[i] = (flags >> i) & 1;
+    }
+
+    for (int i = 0; i < 4; ++i)
+    {
+        App::ControllerInput& controller = input.controllers[i];
+        controller = {};
+        controller.connected = (flags >> (4 + i)) & 1;
+
+        if (controller.connected)
+        {
+            float axes[6];
+
+            if (fread(&controller.buttons, sizeof(controller.buttons), 1, m_file) != 1 || fread(axes, sizeof(axes), 1, m_file) != 1)
+            {
+                return false;
+            }
+
+            controller.lx = axes[0];
+            controller.ly = axes[1];
+            controller.rx = axes[2];
+            controller.ry = axes[3];
+            controller.lt = axes[4];
+            controller.rt = axes[5];
+        }
+    }
+
+    ++m_frame_count;
+    return true;
+}
+
+
+bool InputLog::at_end()
+{
+    int c = fgetc(m_file);
+
+    if (c == EOF)
+    {
+        return true;
+    }
+
+    ungetc(c, m_file);
+    return false;
+}
+
+} // namespace gli
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "gli_core.h"
+
+#include <cstdio>
+#include <string>
+
+namespace gli
+{
+
+// A binary log of App::InputFrame and the delta for each frame. Keys and buttons are stored as bits and controllers only
+// while connected, so a frame without controllers takes under 32 bytes. Values are written in the host's byte order.
+class InputLog
+{
+public:
+    InputLog() = default;
+    InputLog(const InputLog&) = delete;
+    ~InputLog();
+
+    InputLog& operator=(const InputLog&) = delete;
+
+    bool open_write(const std::string& path);
+    bool open_read(const std::string& path);
+    void close();
+
+    bool writing() const { return m_file && m_writing; }
+    bool reading() const { return m_file && !m_writing; }
+    uint64_t frame_count() const { return m_frame_count; }
+
+    void write(const App::InputFrame& input, float delta);
+
+    // False once there are no frames left
+    bool read(App::InputFrame& input, float& delta);
+    bool at_end();
+
+private:
+    FILE* m_file = nullptr;
+    bool m_writing = false;
+    uint64_t m_frame_count = 0;
+};
+
+} // namespace gli
@@ -0,0 +1,279 @@
+#include "gli_job.h"
+
+#include "gli_log.h"
+#include "gli_profile.h"
+
+#include <algorithm>
+
+namespace gli
+{
+
+// Which pool the current thread works for, and its queue in that pool
+static thread_local const JobSystem* t_owner = nullptr;
+static thread_local int t_index = 0;
+
+
+JobSystem g_job_system;
+JobSystem* JobSystem::_singleton = &g_job_system;
+
+
+JobSystem* JobSystem::get()
+{
+    return _singleton;
+}
+
+
+JobSystem::JobSystem()
+{
+    m_queues.emplace_back(new Queue());
+}
+
+
+JobSystem::~JobSystem()
+{
+    stop();
+}
+
+
+void JobSystem::start(int worker_count)
+{
+    stop();
+
+    if (worker_count < 0)
+    {
+        worker_count = std::max((int)std::thread::hardware_concurrency(), 1) - 1;
+    }
+
+    m_quit = false;
+
+    for (int i = 0; i < worker_count; ++i)
+    {
+        m_queues.emplace_back(new Queue());
+    }
+
+    for (int i = 0; i < worker_count; ++i)
+    {
+        m_workers.emplace_back(&JobSystem::worker_func, this, i + 1);
+    }
+
+    gliLog(LogLevel::Info, "Jobs", "JobSystem::start", "Started %d worker threads.", worker_count);
+}
+
+
+void JobSystem::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleep_mutex);
+        m_quit = true;
+        m_wake.notify_all();
+    }
+
+    for (std::thread& worker : m_workers)
+    {
+        worker.join();
+    }
+
+    // Without workers nothing else will run what's left
+    while (try_run_job())
+    {
+    }
+
+    m_workers.clear();
+    m_queues.resize(1);
+}
+
+
+int JobSystem::thread_index() const
+{
+    return t_owner == this ? t_index : 0;
+}
+
+
+void JobSystem::run(JobFunc func, JobCounter* counter)
+{
+    if (counter)
+    {
+        counter->m_count.fetch_add(1);
+    }
+
+    push({ std::move(func), counter });
+}
+
+
+void JobSystem::run_after(JobCounter& dependency, JobFunc func, JobCounter* counter)
+{
+    if (counter)
+    {
+        counter->m_count.fetch_add(1);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(dependency.m_mutex);
+
+        if (!dependency.done())
+        {
+            dependency.m_continuations.push_back({ std::move(func), counter });
+            return;
+        }
+    }
+
+    push({ std::move(func), counter });
+}
+
+
+void JobSystem::wait(JobCounter& counter)
+{
+    while (!counter.done())
+    {
+        if (!try_run_job())
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    // The job that finished the counter may still be holding its lock
+    std::lock_guard<std::mutex> lock(counter.m_mutex);
+}
+
+
+void JobSystem::parallel_for(int begin, int end, int grain, const JobRangeFunc& func)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+
+    if (grain <= 0)
+    {
+        grain = std::max((end - begin) / ((worker_count() + 1) * 4), 1);
+    }
+
+    JobCounter counter;
+
+    for (int chunk = begin; chunk < end; chunk += std::min(grain, end - chunk))
+    {
+        int chunk_end = chunk + std::min(grain, end - chunk);
+        run([&func, chunk, chunk_end] { func(chunk, chunk_end); }, &counter);
+    }
+
+    wait(counter);
+}
+
+
+void JobSystem::push(Job&& job)
+{
+    Queue& queue = *m_queues[thread_index()];
+
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(std::move(job));
+    }
+
+    m_queued.fetch_add(1);
+
+    // Sleepers count themselves before they check m_queued, so one of the two sides always sees the other
+    if (m_sleeping.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(m_sleep_mutex);
+        m_wake.notify_one();
+    }
+}
+
+
+bool JobSystem::try_run_job()
+{
+    int index = thread_index();
+    int queue_count = (int)m_queues.size();
+    Job job;
+    bool found = false;
+
+    // Newest of our own jobs first, while its data is still in cache
+    {
+        Queue& queue = *m_queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if (!queue.jobs.empty())
+        {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+            found = true;
+        }
+    }
+
+    // Then the oldest of everyone else's, which tends to be the biggest piece of work left
+    for (int i = 1; i < queue_count && !found; ++i)
+    {
+        Queue& queue = *m_queues[(index + i) % queue_count];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if (!queue.jobs.empty())
+        {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+            found = true;
+        }
+    }
+
+    if (!found)
+    {
+        return false;
+    }
+
+    m_queued.fetch_sub(1);
+    job.func();
+    finish(job.counter);
+    return true;
+}
+
+
+void JobSystem::finish(JobCounter* counter)
+{
+    if (!counter)
+    {
+        return;
+    }
+
+    std::vector<Job> continuations;
+
+    {
+        std::lock_guard<std::mutex> lock(counter->m_mutex);
+
+        if (counter->m_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            continuations.swap(counter->m_continuations);
+        }
+    }
+
+    for (Job& job : continuations)
+    {
+        push(std::move(job));
+    }
+}
+
+
+void JobSystem::worker_func(int index)
+{
+    t_owner = this;
+    t_index = index;
+    GLI_PROFILE_THREAD("Job worker");
+
+    for (;;)
+    {
+        if (try_run_job())
+        {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleep_mutex);
+        m_sleeping.fetch_add(1);
+        m_wake.wait(lock, [this] { return m_quit || m_queued.load() > 0; });
+        m_sleeping.fetch_sub(1);
+
+        if (m_quit && m_queued.load() == 0)
+        {
+            return;
+        }
+    }
+}
+
+} // namespace gli
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gli
+{
+
+class JobCounter;
+
+using JobFunc = std::function<void()>;
+using JobRangeFunc = std::function<void(int begin, int end)>;
+
+struct Job
+{
+    JobFunc func;
+    JobCounter* counter;
+};
+
+// Counts the jobs that were started with it and haven't finished yet. Wait on it before destroying it.
+class JobCounter
+{
+public:
+    JobCounter() = default;
+    JobCounter(const JobCounter&) = delete;
+
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    bool done() const { return m_count.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+
+    std::atomic<int> m_count{};
+    std::mutex m_mutex{};
+    std::vector<Job> m_continuations{}; // Started by run_after, queued once m_count drops to zero
+};
+
+// Worker threads with a deque each. Workers take their newest job first and steal the oldest from the others when they run
+// out. Threads outside the pool share one more deque, and run jobs too while they wait. App starts the shared pool in
+// initialize, tools without an App can start it themselves.
+class JobSystem
+{
+public:
+    static JobSystem* get();
+
+    JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    ~JobSystem();
+
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // -1 for one worker per core besides the calling thread. With 0 workers jobs run on the threads that wait for them.
+    void start(int worker_count = -1);
+
+    // Finishes the queued jobs first
+    void stop();
+
+    int worker_count() const { return (int)m_workers.size(); }
+
+    // 1 to worker_count on the pool's workers, 0 on any other thread
+    int thread_index() const;
+
+    void run(JobFunc func, JobCounter* counter = nullptr);
+
+    // func is queued once dependency is done, counter counts it from now
+    void run_after(JobCounter& dependency, JobFunc func, JobCounter* counter = nullptr);
+
+    // Runs queued jobs on the calling thread until the counter is done
+    void wait(JobCounter& counter);
+
+    // Calls func on [begin, end) split into chunks of grain indices (0 picks a grain that gives every thread a few
+    // chunks), and returns when all of them are done
+    void parallel_for(int begin, int end, int grain, const JobRangeFunc& func);
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    void push(Job&& job);
+    bool try_run_job();
+    void finish(JobCounter* counter);
+    void worker_func(int index);
+
+    std::vector<std::unique_ptr<Queue>> m_queues{}; // [0] is shared by the threads outside the pool
+    std::vector<std::thread> m_workers{};
+    std::atomic<int> m_queued{};
+    std::atomic<int> m_sleeping{};
+    std::mutex m_sleep_mutex{};
+    std::condition_variable m_wake{};
+    bool m_quit{};
+
+    static JobSystem* _singleton;
+};
+
+} // namespace gli
@@ -0,0 +1,118 @@
+#include "gli_layer.h"
+
+#include "gli_job.h"
+#include "gli_profile.h"
+#include "gli_raster.h"
+
+#include <algorithm>
+
+namespace gli
+{
+
+static const int BandHeight = 32;
+
+
+RenderLayer::RenderLayer(int w, int h) : m_surface(w, h)
+{
+}
+
+
+void RenderLayer::set_opacity(uint8_t opacity)
+{
+    m_dirty |= opacity != m_opacity;
+    m_opacity = opacity;
+}
+
+
+void RenderLayer::set_scroll(int x, int y)
+{
+    m_dirty |= x != m_scroll_x || y != m_scroll_y;
+    m_scroll_x = x;
+    m_scroll_y = y;
+}
+
+
+void RenderLayer::set_visible(bool visible)
+{
+    m_dirty |= visible != m_visible;
+    m_visible = visible;
+}
+
+
+void LayerCompositor::reset(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+    m_background.assign((size_t)width * height, Pixel());
+    m_dirty = true;
+}
+
+
+RenderLayer& LayerCompositor::add(int w, int h)
+{
+    m_layers.push_back(std::unique_ptr<RenderLayer>(new RenderLayer(w, h)));
+    m_dirty = true;
+    return *m_layers.back();
+}
+
+
+void LayerCompositor::clear()
+{
+    m_layers.clear();
+    m_dirty = true;
+}
+
+
+bool LayerCompositor::update()
+{
+    for (const std::unique_ptr<RenderLayer>& layer : m_layers)
+    {
+        m_dirty |= layer->dirty();
+    }
+
+    if (!m_dirty)
+    {
+        return false;
+    }
+
+    GLI_PROFILE_SCOPE("LayerCompositor::update");
+
+    std::vector<RenderLayer*> visible;
+
+    for (const std::unique_ptr<RenderLayer>& layer : m_layers)
+    {
+        // Runs let the blend copy opaque stretches and skip transparent ones, they only need building when the surface changed
+        if (layer->m_surface.generation() != layer->m_generation || !layer->m_surface.has_runs())
+        {
+            layer->m_surface.build_runs();
+        }
+
+        layer->m_generation = layer->m_surface.generation();
+        layer->m_dirty = false;
+
+        if (layer->m_visible && layer->m_opacity > 0)
+        {
+            visible.push_back(layer.get());
+        }
+    }
+
+    int bands = (m_height + BandHeight - 1) / BandHeight;
+
+    JobSystem::get()->parallel_for(0, bands, 1, [this, &visible](int begin, int end) {
+        Raster<Pixel> raster{ m_background.data(), m_width, 0, begin * BandHeight, m_width, std::min(end * BandHeight, m_height),
+                              BlendOp::None, {}, 255, nullptr };
+        raster_clear(raster, Pixel(Pixel::Black));
+
+        for (const RenderLayer* layer : visible)
+        {
+            const Surface& surface = layer->m_surface;
+            raster_blend_sprite(raster, -layer->m_scroll_x, -layer->m_scroll_y, surface, 0, 0, surface.width(), surface.height(),
+                                layer->m_opacity);
+        }
+    });
+
+    m_dirty = false;
+    return true;
+}
+
+} // namespace gli
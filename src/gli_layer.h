@@ -0,0 +1,82 @@
+#pragma once
+
+#include "gli_surface.h"
+
+#include <memory>
+#include <vector>
+
+namespace gli
+{
+
+// A surface composited under the screen by App, see App::add_layer. Changing anything here, or pushing the surface as a
+// target, marks the layer for compositing again.
+class RenderLayer
+{
+public:
+    RenderLayer(int w, int h);
+
+    Surface& surface() { return m_surface; }
+    const Surface& surface() const { return m_surface; }
+
+    // How much of the layers below shows through, on top of the surface's own alpha
+    void set_opacity(uint8_t opacity);
+    uint8_t opacity() const { return m_opacity; }
+
+    // The surface pixel that lands on the screen's top left, for surfaces larger than the screen
+    void set_scroll(int x, int y);
+    int scroll_x() const { return m_scroll_x; }
+    int scroll_y() const { return m_scroll_y; }
+
+    void set_visible(bool visible);
+    bool visible() const { return m_visible; }
+
+    // For changes made through surface().pixels() rather than the draw calls
+    void mark_dirty() { m_dirty = true; }
+    bool dirty() const { return m_dirty || m_surface.generation() != m_generation; }
+
+private:
+    friend class LayerCompositor;
+
+    Surface m_surface;
+    uint8_t m_opacity = 255;
+    int m_scroll_x = 0;
+    int m_scroll_y = 0;
+    bool m_visible = true;
+    bool m_dirty = true;
+    uint32_t m_generation = 0; // Of the surface, when it was last composited
+};
+
+// Blends render layers in order, lowest first, over opaque black into a background image, and keeps the result until one of
+// them changes
+class LayerCompositor
+{
+public:
+    LayerCompositor() = default;
+    LayerCompositor(const LayerCompositor&) = delete;
+
+    LayerCompositor& operator=(const LayerCompositor&) = delete;
+
+    void reset(int width, int height);
+
+    // Layers stay where they are in memory until they're cleared
+    RenderLayer& add(int w, int h);
+    void clear();
+
+    int count() const { return (int)m_layers.size(); }
+    RenderLayer& layer(int index) { return *m_layers[index]; }
+
+    // Composites the layers again if any of them are dirty, in bands on the JobSystem. Returns true if the background changed.
+    bool update();
+
+    // width x height pixels, tightly packed like the framebuffer
+    const Pixel* background() const { return m_background.data(); }
+
+private:
+    int m_width{};
+    int m_height{};
+    bool m_dirty = true;
+    std::vector<Pixel> m_background{};
+    std::vector<std::unique_ptr<RenderLayer>> m_layers{};
+};
+
+} // namespace gli
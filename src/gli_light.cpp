@@ -0,0 +1,54 @@
+#include "gli_light.h"
+
+#include "gli_blend.h"
+#include "gli_debug.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace gli
+{
+
+LightTable::LightTable(int levels, float max_scale)
+{
+    // The factors are 16 bit 256ths, which run out just short of 256. Past 255 every lit channel saturates anyway.
+    gliAssert(levels >= 2 && max_scale > 0.0f && max_scale <= 255.0f);
+
+    m_level_scale = (levels - 1) / max_scale;
+    m_factors.resize(levels);
+    m_tables.resize(levels * 256);
+
+    for (int level = 0; level < levels; ++level)
+    {
+        uint16_t factor = (uint16_t)std::lround(level * 256.0f / m_level_scale);
+        m_factors[level] = factor;
+
+        // The same rounding scale_pixels uses
+        for (int c = 0; c < 256; ++c)
+        {
+            m_tables[level * 256 + c] = (uint8_t)std::min((c * factor) >> 8, 255);
+        }
+    }
+}
+
+
+int LightTable::level(float scale) const
+{
+    int level = (int)(scale * m_level_scale + 0.5f);
+    return std::min(std::max(level, 0), levels() - 1);
+}
+
+
+Pixel LightTable::scale_pixel(Pixel p, int level) const
+{
+    const uint8_t* t = table(level);
+    return Pixel(t[p.r], t[p.g], t[p.b], p.a);
+}
+
+
+void LightTable::scale_pixels(Pixel* dest, const Pixel* src, int count, int level) const
+{
+    gli::scale_pixels(dest, src, count, m_factors[level]);
+}
+
+} // namespace gli
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "gli_core.h" // for gli::Pixel
+
+#include <vector>
+
+namespace gli
+{
+
+// Brightness scaling through a fixed set of light levels, for distance shading and the like. Level 0 is black and the last level
+// scales by max_scale, at most 255. Every level has a 256 entry table for single pixels, and scale_pixels does the same integer math in SIMD,
+// so both give identical results.
+class LightTable
+{
+public:
+    explicit LightTable(int levels = 256, float max_scale = 1.0f);
+
+    int levels() const { return (int)m_factors.size(); }
+
+    // The level nearest to a scale factor, clamped to the table
+    int level(float scale) const;
+
+    const uint8_t* table(int level) const { return &m_tables[level * 256]; }
+    Pixel scale_pixel(Pixel p, int level) const;
+
+    // Scale count pixels by a level, 8 at a time with AVX2 or 4 with SSE2. dest may be src.
+    void scale_pixels(Pixel* dest, const Pixel* src, int count, int level) const;
+    void scale_pixels(Pixel* pixels, int count, int level) const { scale_pixels(pixels, pixels, count, level); }
+
+private:
+    float m_level_scale;            // Levels per unit of scale
+    std::vector<uint16_t> m_factors; // Multiplier for each level in 256ths
+    std::vector<uint8_t> m_tables;   // 256 entries for each level
+};
+
+} // namespace gli
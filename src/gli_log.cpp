@@ -1,10 +1,14 @@
 #include "gli_log.h"
 
+#include <algorithm>
+#include <cstdio>
 #include <string>
 
+#ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #define NOMINMAX
 #include <Windows.h>
+#endif
 
 namespace gli
 {
@@ -21,7 +25,7 @@ void logf(const char* format, ...)
 void logv(const char* format, va_list args)
 {
     static constexpr int log_buffer_size = 256;
-    static char log_buffer[log_buffer_size];
+    static thread_local char log_buffer[log_buffer_size];
     std::va_list args_copy;
     va_copy(args_copy, args);
     int len = std::vsnprintf(log_buffer, log_buffer_size, format, args);
@@ -44,7 +48,11 @@ void logv(const char* format, va_list args)
 
 void logm(const char* message)
 {
+#ifdef _WIN32
     OutputDebugStringA(message);
+#else
+    fputs(message, stderr);
+#endif
 }
 
 
@@ -82,9 +90,10 @@ static void print(std::string& buffer, const char* format, va_list args)
 
     for (;;)
     {
+        // vsnprintf consumes the list it's given, so each attempt formats from its own copy
         std::va_list args_copy;
         va_copy(args_copy, args);
-        size_t len = len = std::vsnprintf(&buffer[0], buffer.size(), format, args) + 1;
+        size_t len = std::vsnprintf(&buffer[0], buffer.size(), format, args_copy) + 1;
         va_end(args_copy);
 
         if (len <= buffer.size())
@@ -92,8 +101,7 @@ static void print(std::string& buffer, const char* format, va_list args)
             break;
         }
 
-        len = buffer.size() * 2;
-        buffer.resize(len);
+        buffer.resize(std::max(len, buffer.size() * 2));
     }
 }
 
@@ -107,10 +115,11 @@ static void print(std::string& buffer, const char* format, ...)
 }
 
 
-void log(const char* file, int line, const char* category, int loglevel, const char* func, const char* format, ...)
+void log(const char* file, int line, const char* category, int loglevel, const char*, const char* format, ...)
 {
-    static std::string format_buffer;
-    static std::string output_buffer;
+    // Per thread, so jobs can log
+    static thread_local std::string format_buffer;
+    static thread_local std::string output_buffer;
 
     print(format_buffer, "%s(%d): %s: [%s] %s\n", file, line, category, log_level_string(loglevel), format);
 
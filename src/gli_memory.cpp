@@ -0,0 +1,308 @@
+#include "gli_memory.h"
+
+#include "gli_debug.h"
+#include "gli_log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+namespace gli
+{
+
+static void* aligned_allocate(size_t size, size_t alignment)
+{
+#ifdef _MSC_VER
+    return _aligned_malloc(size, alignment);
+#else
+    void* memory = nullptr;
+    return posix_memalign(&memory, alignment, size) == 0 ? memory : nullptr;
+#endif
+}
+
+
+static void aligned_free(void* memory)
+{
+#ifdef _MSC_VER
+    _aligned_free(memory);
+#else
+    free(memory);
+#endif
+}
+
+#ifdef GLI_MEMORY_TRACKING
+
+// Counts are updated from any thread. The budgets and warning state belong to the engine thread.
+struct MemoryTag
+{
+    const char* name = nullptr;
+    std::atomic<size_t> live{};
+    std::atomic<size_t> peak{};
+    std::atomic<uint64_t> allocations{};
+    std::atomic<int> frame_allocations{};
+    int last_frame_allocations = 0;
+    size_t budget = 0;
+    int frame_budget = 0;
+    bool over_budget = false;
+    bool over_frame_budget = false;
+};
+
+
+// Sits just before every tracked allocation, and is padded out to its alignment
+struct AllocationHeader
+{
+    size_t size;
+    uint32_t offset; // From the start of the underlying allocation
+    int32_t tag;
+};
+
+static_assert(sizeof(AllocationHeader) <= 16, "AllocationHeader should fit in the smallest alignment");
+
+// Everything here is constant initialized, so new can run before any static constructors have
+static MemoryTag _tags[MaxMemoryTags];
+static std::atomic<int> _tag_count{ 1 };
+static std::mutex _mutex; // Guards registering tags
+static std::atomic<bool> _hooked{};
+
+static thread_local int t_tag = 0;
+
+
+void* memory_allocate(size_t size, size_t alignment)
+{
+    gliAssert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+    alignment = std::max(alignment, (size_t)16);
+    uint8_t* base = (uint8_t*)aligned_allocate(std::max(size, (size_t)1) + alignment, alignment);
+
+    if (!base)
+    {
+        return nullptr;
+    }
+
+    uint8_t* memory = base + alignment;
+    AllocationHeader* header = (AllocationHeader*)memory - 1;
+    header->size = size;
+    header->offset = (uint32_t)alignment;
+    header->tag = t_tag;
+
+    MemoryTag& tag = _tags[header->tag];
+    size_t live = tag.live.fetch_add(size, std::memory_order_relaxed) + size;
+    size_t peak = tag.peak.load(std::memory_order_relaxed);
+
+    while (live > peak && !tag.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+    {
+    }
+
+    tag.allocations.fetch_add(1, std::memory_order_relaxed);
+    tag.frame_allocations.fetch_add(1, std::memory_order_relaxed);
+    return memory;
+}
+
+
+void memory_free(void* memory)
+{
+    if (!memory)
+    {
+        return;
+    }
+
+    AllocationHeader* header = (AllocationHeader*)memory - 1;
+    _tags[header->tag].live.fetch_sub(header->size, std::memory_order_relaxed);
+    aligned_free((uint8_t*)memory - header->offset);
+}
+
+
+void* memory_hook_new(size_t size)
+{
+    _hooked.store(true, std::memory_order_relaxed);
+    void* memory = memory_allocate(size);
+
+    if (!memory)
+    {
+        throw std::bad_alloc();
+    }
+
+    return memory;
+}
+
+
+int memory_tag(const char* name)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    int count = _tag_count.load(std::memory_order_relaxed);
+
+    for (int i = 1; i < count; ++i)
+    {
+        if (strcmp(_tags[i].name, name) == 0)
+        {
+            return i;
+        }
+    }
+
+    if (count == MaxMemoryTags)
+    {
+        gliLog(LogLevel::Warning, "Memory", "memory_tag", "Out of tags, counting %s as untagged.", name);
+        return 0;
+    }
+
+    _tags[count].name = name;
+    _tag_count.store(count + 1, std::memory_order_release);
+    return count;
+}
+
+
+int memory_set_tag(int tag)
+{
+    int previous = t_tag;
+    t_tag = tag;
+    return previous;
+}
+
+
+void set_memory_budget(const char* name, size_t bytes, int allocations_per_frame)
+{
+    MemoryTag& tag = _tags[memory_tag(name)];
+    tag.budget = bytes;
+    tag.frame_budget = allocations_per_frame;
+    tag.over_budget = false;
+    tag.over_frame_budget = false;
+}
+
+
+void memory_frame()
+{
+    int count = _tag_count.load(std::memory_order_acquire);
+
+    // Only warn as a tag goes over, not every frame it stays there
+    for (int i = 0; i < count; ++i)
+    {
+        MemoryTag& tag = _tags[i];
+        const char* name = tag.name ? tag.name : "untagged";
+        size_t live = tag.live.load(std::memory_order_relaxed);
+        tag.last_frame_allocations = tag.frame_allocations.exchange(0, std::memory_order_relaxed);
+
+        bool over_budget = tag.budget > 0 && live > tag.budget;
+
+        if (over_budget && !tag.over_budget)
+        {
+            gliLog(LogLevel::Warning, "Memory", "memory_frame", "%s is over budget, %.1f KB of %.1f KB.", name, live / 1024.0,
+                   tag.budget / 1024.0);
+        }
+
+        bool over_frame_budget = tag.frame_budget > 0 && tag.last_frame_allocations > tag.frame_budget;
+
+        if (over_frame_budget && !tag.over_frame_budget)
+        {
+            gliLog(LogLevel::Warning, "Memory", "memory_frame", "%s made %d allocations in a frame, its budget is %d.", name,
+                   tag.last_frame_allocations, tag.frame_budget);
+        }
+
+        tag.over_budget = over_budget;
+        tag.over_frame_budget = over_frame_budget;
+    }
+}
+
+
+int memory_stats(MemoryTagStats* stats, int max_count)
+{
+    int count = std::min(_tag_count.load(std::memory_order_acquire), max_count);
+
+    for (int i = 0; i < count; ++i)
+    {
+        const MemoryTag& tag = _tags[i];
+        stats[i].name = tag.name ? tag.name : "untagged";
+        stats[i].live = tag.live.load(std::memory_order_relaxed);
+        stats[i].peak = tag.peak.load(std::memory_order_relaxed);
+        stats[i].allocations = tag.allocations.load(std::memory_order_relaxed);
+        stats[i].frame_allocations = tag.last_frame_allocations;
+        stats[i].budget = tag.budget;
+        stats[i].frame_budget = tag.frame_budget;
+    }
+
+    return count;
+}
+
+
+void memory_report()
+{
+    MemoryTagStats stats[MaxMemoryTags];
+    int count = memory_stats(stats, MaxMemoryTags);
+
+    gliLog(LogLevel::Info, "Memory", "memory_report", "%s", _hooked.load(std::memory_order_relaxed)
+                                                                 ? "new and delete are hooked, everything is counted."
+                                                                 : "new and delete aren't hooked, only gli allocations are counted.");
+    gliLog(LogLevel::Info, "Memory", "memory_report", "%-16s %12s %12s %12s %12s %12s", "tag", "live KB", "peak KB", "budget KB",
+           "allocs/frame", "allocs");
+
+    for (int i = 0; i < count; ++i)
+    {
+        gliLog(LogLevel::Info, "Memory", "memory_report", "%-16s %12.1f %12.1f %12.1f %12d %12llu", stats[i].name, stats[i].live / 1024.0,
+               stats[i].peak / 1024.0, stats[i].budget / 1024.0, stats[i].frame_allocations, (unsigned long long)stats[i].allocations);
+    }
+}
+
+#else
+
+void* memory_allocate(size_t size, size_t alignment)
+{
+    return aligned_allocate(std::max(size, (size_t)1), std::max(alignment, (size_t)16));
+}
+
+
+void memory_free(void* memory)
+{
+    aligned_free(memory);
+}
+
+
+void* memory_hook_new(size_t size)
+{
+    void* memory = memory_allocate(size);
+
+    if (!memory)
+    {
+        throw std::bad_alloc();
+    }
+
+    return memory;
+}
+
+
+int memory_tag(const char*)
+{
+    return 0;
+}
+
+
+int memory_set_tag(int)
+{
+    return 0;
+}
+
+
+void set_memory_budget(const char*, size_t, int) {}
+
+
+void memory_frame() {}
+
+
+int memory_stats(MemoryTagStats*, int)
+{
+    return 0;
+}
+
+
+void memory_report()
+{
+    gliLog(LogLevel::Info, "Memory", "memory_report", "Memory tracking is compiled out of release builds.");
+}
+
+#endif
+
+} // namespace gli
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#ifndef GLI_RELEASE
+#define GLI_MEMORY_TRACKING 1
+#endif
+
+namespace gli
+{
+
+static const int MaxMemoryTags = 64;
+
+// What one tag has allocated. Tag 0 is everything allocated outside a GLI_MEMORY_TAG scope.
+struct MemoryTagStats
+{
+    const char* name;
+    size_t live;
+    size_t peak;
+    uint64_t allocations;  // Since startup
+    int frame_allocations; // Over the last frame
+    size_t budget;         // 0 for none
+    int frame_budget;
+};
+
+// Allocations made through these are counted against the calling thread's current tag. Sprites allocate their pixels here, and
+// GLI_MEMORY_HOOK routes new and delete here too. alignment must be a power of two. Release builds skip the counting.
+void* memory_allocate(size_t size, size_t alignment = 16);
+void memory_free(void* memory);
+
+// Finds or registers a tag, returning its index. name must outlive the app, which string literals do.
+int memory_tag(const char* name);
+
+// Makes tag the calling thread's current one, returning the one it replaces
+int memory_set_tag(int tag);
+
+// Warn when the tag holds more than bytes, or makes more than allocations_per_frame allocations in a frame. 0 turns either off.
+// Engine thread only.
+void set_memory_budget(const char* name, size_t bytes, int allocations_per_frame = 0);
+
+// Ends a frame: rolls the per frame counts over and warns about budgets as tags go over them. App calls it each frame.
+void memory_frame();
+
+// Returns how many tags were written
+int memory_stats(MemoryTagStats* stats, int max_count);
+
+// Logs every tag's counts, and whether new and delete are hooked
+void memory_report();
+
+// For GLI_MEMORY_HOOK
+void* memory_hook_new(size_t size);
+
+class MemoryTagScope
+{
+public:
+    explicit MemoryTagScope(int tag) : m_previous(memory_set_tag(tag)) {}
+    MemoryTagScope(const MemoryTagScope&) = delete;
+    ~MemoryTagScope() { memory_set_tag(m_previous); }
+
+    MemoryTagScope& operator=(const MemoryTagScope&) = delete;
+
+private:
+    int m_previous;
+};
+
+} // namespace gli
+
+#define GLI_MEMORY_CONCAT_(a, b) a##b
+#define GLI_MEMORY_CONCAT(a, b) GLI_MEMORY_CONCAT_(a, b)
+
+#ifdef GLI_MEMORY_TRACKING
+// Attributes what the calling thread allocates until the end of the enclosing scope to name
+#define GLI_MEMORY_TAG(name)                                                                 \
+    static const int GLI_MEMORY_CONCAT(gli_memory_tag_, __LINE__) = gli::memory_tag(name); \
+    gli::MemoryTagScope GLI_MEMORY_CONCAT(gli_memory_scope_, __LINE__)(GLI_MEMORY_CONCAT(gli_memory_tag_, __LINE__))
+
+// Replaces the global new and delete with counted ones. An app opts in by putting this in one of its source files, at global scope.
+#define GLI_MEMORY_HOOK()                                                                                                    \
+    void* operator new(size_t size) { return gli::memory_hook_new(size); }                                                \
+    void* operator new[](size_t size) { return gli::memory_hook_new(size); }                                              \
+    void* operator new(size_t size, const std::nothrow_t&) noexcept { return gli::memory_allocate(size); }                \
+    void* operator new[](size_t size, const std::nothrow_t&) noexcept { return gli::memory_allocate(size); }              \
+    void operator delete(void* memory) noexcept { gli::memory_free(memory); }                                              \
+    void operator delete[](void* memory) noexcept { gli::memory_free(memory); }                                            \
+    void operator delete(void* memory, size_t) noexcept { gli::memory_free(memory); }                                      \
+    void operator delete[](void* memory, size_t) noexcept { gli::memory_free(memory); }                                    \
+    void operator delete(void* memory, const std::nothrow_t&) noexcept { gli::memory_free(memory); }                       \
+    void operator delete[](void* memory, const std::nothrow_t&) noexcept { gli::memory_free(memory); }
+#else
+#define GLI_MEMORY_TAG(name) ((void)0)
+#define GLI_MEMORY_HOOK()
+#endif
@@ -1,3 +1,5 @@
+#ifndef GLI_HEADLESS
+
 #include "gli_opengl.h"
 
 #define WIN32_LEAN_AND_MEAN
@@ -5,6 +7,8 @@
 #include <Windows.h>
 #include <dwmapi.h>
 
+#include <cstring>
+
 #include "opengl/glad.h"
 #include "wglext.h"
 
@@ -512,7 +516,14 @@ bool OpenGL::init(HWND hwnd)
     };
     /* clang-format on */
 
-    HGLRC glrc = wglCreateContextAttribsARB(dc, 0, context_attributes);
+    // Step down to older core versions for drivers that stop short of 4.6 (e.g. Mesa's llvmpipe), the shaders need 4.0
+    HGLRC glrc = nullptr;
+
+    for (int minor_version = 6; !glrc && minor_version >= 0; --minor_version)
+    {
+        context_attributes[3] = minor_version;
+        glrc = wglCreateContextAttribsARB(dc, 0, context_attributes);
+    }
 
     if (!glrc)
     {
@@ -525,6 +536,14 @@ bool OpenGL::init(HWND hwnd)
         return false;
     }
 
+    // Reload against the real context so the GLAD_GL_VERSION flags describe what it supports
+    if (!gladLoadGL())
+    {
+        wgl.makeCurrent(nullptr, nullptr);
+        wgl.deleteContext(glrc);
+        return false;
+    }
+
 #if GLI_DEBUG_GL
     glDebugMessageCallback(debug_message_callback, nullptr);
 #endif
@@ -579,4 +598,185 @@ void OpenGL::clear(float r, float g, float b, float a)
     glClear(GL_COLOR_BUFFER_BIT);
 }
 
-} // namespace gli
\ No newline at end of file
+
+bool StreamingTexture::init(uint32_t width, uint32_t height, Format format)
+{
+    GLenum internal_format = format == R8 ? GL_R8 : GL_RGBA8;
+    _width = width;
+    _height = height;
+    _format = format;
+    _pixel_size = format == R8 ? 1 : 4;
+    _frame_size = size_t(width) * height * _pixel_size;
+    _next = 0;
+
+    // Storage is allocated once, updates only ever replace the contents
+    glGenTextures(1, &_texture);
+    glBindTexture(GL_TEXTURE_2D, _texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+    if (GLAD_GL_VERSION_4_2)
+    {
+        glTexStorage2D(GL_TEXTURE_2D, 1, internal_format, width, height);
+    }
+    else
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, format == R8 ? GL_RED : GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
+    }
+
+    glGenBuffers(1, &_buffer);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _buffer);
+
+    // Persistent mapping needs buffer storage, which is core from 4.4 and an extension on older contexts
+    bool persistent = GLAD_GL_ARB_buffer_storage || GLAD_GL_VERSION_4_4;
+
+    if (persistent)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, _frame_size * RingSize, nullptr, flags);
+        _mapping = (uint8_t*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, _frame_size * RingSize, flags);
+    }
+    else
+    {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, _frame_size * RingSize, nullptr, GL_STREAM_DRAW);
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (persistent && !_mapping)
+    {
+        gliLog(LogLevel::Error, "OpenGL", "StreamingTexture::init", "Failed to map pixel buffer.");
+        destroy();
+        return false;
+    }
+
+    gliLog(LogLevel::Info, "OpenGL", "StreamingTexture::init", "%ux%u texture, %s upload ring.", width, height,
+           _mapping ? "persistent mapped" : "unsynchronized mapped");
+    return true;
+}
+
+
+void StreamingTexture::destroy()
+{
+    for (GLsync& fence : _fences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+
+    if (_mapping)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _buffer);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        _mapping = nullptr;
+    }
+
+    glDeleteBuffers(1, &_buffer);
+    glDeleteTextures(1, &_texture);
+    _buffer = 0;
+    _texture = 0;
+}
+
+
+void StreamingTexture::update(const void* pixels, const DirtyRect* rects, int count)
+{
+    glBindTexture(GL_TEXTURE_2D, _texture);
+
+    if (count <= 0)
+    {
+        return;
+    }
+
+    int index = _next;
+    _next = (_next + 1) % RingSize;
+    size_t offset = _frame_size * index;
+
+    // Only blocks if the GPU is still reading this region from RingSize frames ago
+    if (_fences[index])
+    {
+        GLenum result;
+
+        do
+        {
+            result = glClientWaitSync(_fences[index], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        } while (result == GL_TIMEOUT_EXPIRED);
+
+        glDeleteSync(_fences[index]);
+        _fences[index] = nullptr;
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _buffer);
+    uint8_t* region = nullptr;
+
+    if (_mapping)
+    {
+        region = _mapping + offset;
+    }
+    else
+    {
+        // The fence already guarantees the region is free, so there's no need for the driver to synchronize
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+        region = (uint8_t*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, offset, _frame_size, flags);
+    }
+
+    if (region)
+    {
+        // Rectangles keep their place in the frame layout, so each one is a single upload with a row length of the full width
+        size_t stride = _width * _pixel_size;
+
+        for (int i = 0; i < count; ++i)
+        {
+            size_t start = rects[i].y0 * stride + rects[i].x0 * _pixel_size;
+            size_t row_size = (rects[i].x1 - rects[i].x0) * _pixel_size;
+
+            if (row_size == stride)
+            {
+                memcpy(region + start, (const uint8_t*)pixels + start, row_size * (rects[i].y1 - rects[i].y0));
+                continue;
+            }
+
+            for (int y = rects[i].y0; y < rects[i].y1; ++y, start += stride)
+            {
+                memcpy(region + start, (const uint8_t*)pixels + start, row_size);
+            }
+        }
+
+        if (!_mapping)
+        {
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+
+        GLenum format = _format == R8 ? GL_RED : GL_BGRA;
+        glPixelStorei(GL_UNPACK_ALIGNMENT, _format == R8 ? 1 : 4);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, _width);
+
+        for (int i = 0; i < count; ++i)
+        {
+            size_t start = offset + rects[i].y0 * stride + rects[i].x0 * _pixel_size;
+            glTexSubImage2D(GL_TEXTURE_2D, 0, rects[i].x0, rects[i].y0, rects[i].x1 - rects[i].x0, rects[i].y1 - rects[i].y0, format,
+                            GL_UNSIGNED_BYTE, (const void*)start);
+        }
+
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    _fences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+
+void StreamingTexture::update(const void* pixels)
+{
+    DirtyRect all{ 0, 0, (int)_width, (int)_height };
+    update(pixels, &all, 1);
+}
+
+} // namespace gli
+
+#endif // GLI_HEADLESS
@@ -1,10 +1,14 @@
 #pragma once
 
+#include "gli_dirty.h"
+
+#include <cstddef>
 #include <cstdint>
 
 typedef struct HDC__* HDC;
 typedef struct HGLRC__* HGLRC;
 typedef struct HWND__* HWND;
+typedef struct __GLsync* GLsync;
 
 namespace gli
 {
@@ -30,4 +34,41 @@ private:
     HGLRC _rc;
 };
 
+// A texture updated from CPU memory every frame. Uploads go through a ring of pixel buffer regions guarded by fences, so
+// the CPU copies the next frame while the GPU is still reading the previous ones. The ring is persistently mapped when
+// the context has buffer storage (GL 4.4) and mapped unsynchronized each frame otherwise.
+class StreamingTexture
+{
+public:
+    enum Format
+    {
+        BGRA8,
+        R8
+    };
+
+    bool init(uint32_t width, uint32_t height, Format format);
+    void destroy();
+
+    // Copy the given rectangles of a frame of tightly packed pixels into the texture, the rest of the texture keeps its
+    // contents. Leaves the texture bound to the active unit.
+    void update(const void* pixels, const DirtyRect* rects, int count);
+    void update(const void* pixels);
+
+    uint32_t texture() const { return _texture; }
+
+private:
+    static const int RingSize = 3;
+
+    uint32_t _width = 0;
+    uint32_t _height = 0;
+    Format _format = BGRA8;
+    size_t _pixel_size = 0;
+    size_t _frame_size = 0;
+    uint32_t _texture = 0;
+    uint32_t _buffer = 0;
+    uint8_t* _mapping = nullptr;
+    GLsync _fences[RingSize] = {};
+    int _next = 0;
+};
+
 }
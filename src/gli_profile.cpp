@@ -0,0 +1,262 @@
+#include "gli_profile.h"
+
+#include "gli_log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace gli
+{
+
+struct ProfileEvent
+{
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+};
+
+
+struct CapturedEvent
+{
+    ProfileEvent event;
+    int thread;
+};
+
+
+// Single producer ring: the owning thread appends zones, profile_frame consumes them
+struct ThreadBuffer
+{
+    static const uint32_t Size = 16384;
+
+    ProfileEvent events[Size];
+    std::atomic<uint32_t> head{};
+    std::atomic<uint32_t> tail{};
+    const char* name = nullptr;
+    int id = 0;
+};
+
+
+// The mutex only guards the buffer list and what profile_frame builds, recording zones never takes it
+static std::mutex _mutex;
+static std::vector<std::unique_ptr<ThreadBuffer>> _buffers;
+static std::atomic<uint32_t> _dropped{};
+static std::vector<ProfileTotal> _frame_totals;
+static std::vector<ProfileTotal> _last_totals;
+static bool _capturing = false;
+static std::vector<CapturedEvent> _capture;
+static std::vector<uint64_t> _capture_frames;
+static uint64_t _capture_start = 0;
+
+static thread_local ThreadBuffer* t_buffer = nullptr;
+
+
+static ThreadBuffer* thread_buffer()
+{
+    if (!t_buffer)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _buffers.emplace_back(new ThreadBuffer());
+        t_buffer = _buffers.back().get();
+        t_buffer->id = (int)_buffers.size() - 1;
+    }
+
+    return t_buffer;
+}
+
+
+static void write_json_string(FILE* file, const char* str)
+{
+    fputc('"', file);
+
+    for (; *str; ++str)
+    {
+        if (*str == '"' || *str == '\\')
+        {
+            fputc('\\', file);
+        }
+
+        fputc(*str, file);
+    }
+
+    fputc('"', file);
+}
+
+
+uint64_t profile_now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+void profile_record(const char* name, uint64_t start, uint64_t end)
+{
+    ThreadBuffer* buffer = thread_buffer();
+    uint32_t head = buffer->head.load(std::memory_order_relaxed);
+
+    // Full until the next frame collects it
+    if (head - buffer->tail.load(std::memory_order_acquire) >= ThreadBuffer::Size)
+    {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    buffer->events[head & (ThreadBuffer::Size - 1)] = { name, start, end };
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+
+void profile_thread_name(const char* name)
+{
+    ThreadBuffer* buffer = thread_buffer();
+    std::lock_guard<std::mutex> lock(_mutex);
+    buffer->name = name;
+}
+
+
+void profile_frame()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _frame_totals.clear();
+
+    for (const std::unique_ptr<ThreadBuffer>& buffer : _buffers)
+    {
+        uint32_t head = buffer->head.load(std::memory_order_acquire);
+
+        for (uint32_t tail = buffer->tail.load(std::memory_order_relaxed); tail != head; ++tail)
+        {
+            const ProfileEvent& event = buffer->events[tail & (ThreadBuffer::Size - 1)];
+
+            // Few enough distinct zones per frame that a linear search wins. Names are compared by contents since the
+            // same literal can have different addresses in different modules.
+            auto it = std::find_if(_frame_totals.begin(), _frame_totals.end(),
+                                   [&](const ProfileTotal& total) { return strcmp(total.name, event.name) == 0; });
+
+            if (it == _frame_totals.end())
+            {
+                _frame_totals.push_back({ event.name, 0, 0 });
+                it = _frame_totals.end() - 1;
+            }
+
+            it->time += event.end - event.start;
+            ++it->count;
+
+            if (_capturing)
+            {
+                _capture.push_back({ event, buffer->id });
+            }
+        }
+
+        buffer->tail.store(head, std::memory_order_release);
+    }
+
+    std::sort(_frame_totals.begin(), _frame_totals.end(), [](const ProfileTotal& a, const ProfileTotal& b) { return a.time > b.time; });
+    _last_totals.swap(_frame_totals);
+
+    if (_capturing)
+    {
+        _capture_frames.push_back(profile_now());
+    }
+
+    uint32_t dropped = _dropped.exchange(0, std::memory_order_relaxed);
+
+    if (dropped)
+    {
+        gliLog(LogLevel::Warning, "Profile", "profile_frame", "Dropped %u zones, a thread recorded more than %u in a frame.", dropped,
+               ThreadBuffer::Size);
+    }
+}
+
+
+int profile_top_zones(ProfileTotal* totals, int max_count)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    int count = std::min(max_count, (int)_last_totals.size());
+    std::copy(_last_totals.begin(), _last_totals.begin() + count, totals);
+    return count;
+}
+
+
+void profile_start_capture()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _capture.clear();
+    _capture_frames.clear();
+    _capture_start = profile_now();
+    _capturing = true;
+}
+
+
+bool profile_stop_capture(const char* path)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (!_capturing)
+    {
+        return false;
+    }
+
+    _capturing = false;
+
+    FILE* file = fopen(path, "wb");
+
+    if (!file)
+    {
+        gliLog(LogLevel::Error, "Profile", "profile_stop_capture", "Failed to open %s.", path);
+        return false;
+    }
+
+    // Timestamps in microseconds, keeping the nanoseconds as decimals
+    auto micros = [](uint64_t ns) { return (ns - _capture_start) / 1000.0; };
+    const char* separator = "\n";
+
+    fputs("{\"traceEvents\":[", file);
+
+    for (const std::unique_ptr<ThreadBuffer>& buffer : _buffers)
+    {
+        if (buffer->name)
+        {
+            fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":", separator, buffer->id);
+            write_json_string(file, buffer->name);
+            fputs("}}", file);
+            separator = ",\n";
+        }
+    }
+
+    for (const CapturedEvent& captured : _capture)
+    {
+        // Zones that started before the capture did are clipped to it
+        uint64_t start = std::max(captured.event.start, _capture_start);
+
+        fprintf(file, "%s{\"name\":", separator);
+        write_json_string(file, captured.event.name);
+        fprintf(file, ",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", captured.thread, micros(start),
+                (std::max(captured.event.end, start) - start) / 1000.0);
+        separator = ",\n";
+    }
+
+    for (uint64_t frame : _capture_frames)
+    {
+        fprintf(file, "%s{\"name\":\"Frame\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"ts\":%.3f}", separator, micros(frame));
+        separator = ",\n";
+    }
+
+    fputs("\n]}\n", file);
+    bool success = ferror(file) == 0;
+    fclose(file);
+
+    gliLog(LogLevel::Info, "Profile", "profile_stop_capture", "Wrote %zu zones over %zu frames to %s.", _capture.size(), _capture_frames.size(),
+           path);
+
+    _capture.clear();
+    _capture_frames.clear();
+    return success;
+}
+
+} // namespace gli
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+
+#ifndef GLI_RELEASE
+#define GLI_PROFILING 1
+#endif
+
+namespace gli
+{
+
+// Time spent in one zone name over a frame, across all threads
+struct ProfileTotal
+{
+    const char* name;
+    uint64_t time; // Nanoseconds
+    int count;
+};
+
+// Nanoseconds on the monotonic clock
+uint64_t profile_now();
+
+// Zones are recorded into a buffer owned by the calling thread, without locking. name must outlive the profiler, which
+// string literals do.
+void profile_record(const char* name, uint64_t start, uint64_t end);
+
+// Name the calling thread in captures
+void profile_thread_name(const char* name);
+
+// Ends a frame: collects every thread's zones into the last frame's totals, and the capture if one is running
+void profile_frame();
+
+// The biggest totals of the last frame, returns how many were written
+int profile_top_zones(ProfileTotal* totals, int max_count);
+
+// Capture zones until stopped, then write them as Chrome trace JSON (chrome://tracing or ui.perfetto.dev)
+void profile_start_capture();
+bool profile_stop_capture(const char* path);
+
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char* name) : m_name(name), m_start(profile_now()) {}
+    ProfileScope(const ProfileScope&) = delete;
+    ~ProfileScope() { profile_record(m_name, m_start, profile_now()); }
+
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* m_name;
+    uint64_t m_start;
+};
+
+} // namespace gli
+
+#define GLI_PROFILE_CONCAT_(a, b) a##b
+#define GLI_PROFILE_CONCAT(a, b) GLI_PROFILE_CONCAT_(a, b)
+
+#ifdef GLI_PROFILING
+#define GLI_PROFILE_SCOPE(name) gli::ProfileScope GLI_PROFILE_CONCAT(gli_profile_scope_, __LINE__)(name)
+#define GLI_PROFILE_FRAME() gli::profile_frame()
+#define GLI_PROFILE_THREAD(name) gli::profile_thread_name(name)
+#else
+#define GLI_PROFILE_SCOPE(name) ((void)0)
+#define GLI_PROFILE_FRAME() ((void)0)
+#define GLI_PROFILE_THREAD(name) ((void)0)
+#endif
@@ -0,0 +1,718 @@
+#include "gli_raster.h"
+
+#include "gli_blend.h"
+#include "gli_font.h"
+#include "gli_sprite.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace gli
+{
+
+static void fill_span(const Raster<Pixel>& raster, Pixel* dest, int count, Pixel p)
+{
+    if (raster.blend_op == None)
+    {
+        fill_pixels(dest, p, count);
+    }
+    else
+    {
+        raster.blend_kernel.fill(dest, p, count, raster.blend_constant);
+    }
+}
+
+
+static void fill_span(const Raster<uint8_t>&, uint8_t* dest, int count, uint8_t c)
+{
+    memset(dest, c, count);
+}
+
+
+// Spans that can be blended are built in the scratch buffer and blended into the framebuffer in one go
+static Pixel* begin_span(const Raster<Pixel>& raster, Pixel* dest, int count)
+{
+    if (raster.blend_op == None)
+    {
+        return dest;
+    }
+
+    raster.span_buffer->resize(count);
+    return raster.span_buffer->data();
+}
+
+
+static uint8_t* begin_span(const Raster<uint8_t>&, uint8_t* dest, int)
+{
+    return dest;
+}
+
+
+static void end_span(const Raster<Pixel>& raster, Pixel* dest, int count)
+{
+    if (raster.blend_op != None)
+    {
+        raster.blend_kernel.span(dest, raster.span_buffer->data(), count, raster.blend_constant);
+    }
+}
+
+
+static void end_span(const Raster<uint8_t>&, uint8_t*, int) {}
+
+
+static void clear_rows(Pixel* dest, int width, int height, int stride, Pixel p)
+{
+    if (width == stride)
+    {
+        stream_pixels(dest, p, width * height);
+        return;
+    }
+
+    for (int y = 0; y < height; ++y, dest += stride)
+    {
+        fill_pixels(dest, p, width);
+    }
+}
+
+
+static void clear_rows(uint8_t* dest, int width, int height, int stride, uint8_t c)
+{
+    if (width == stride)
+    {
+        memset(dest, c, width * height);
+        return;
+    }
+
+    for (int y = 0; y < height; ++y, dest += stride)
+    {
+        memset(dest, c, width);
+    }
+}
+
+
+static void copy_row(Pixel* dest, const uint8_t* src, int count, const Pixel* palette)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        dest[i] = palette[src[i]];
+    }
+}
+
+
+static void copy_row(uint8_t* dest, const uint8_t* src, int count, const Pixel*)
+{
+    memcpy(dest, src, count);
+}
+
+
+static void scale_row(Pixel* dest, const uint8_t* src, int count, int phase, int scale, const Pixel* palette)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        dest[i] = palette[*src];
+
+        if (++phase == scale)
+        {
+            phase = 0;
+            ++src;
+        }
+    }
+}
+
+
+static void scale_row(uint8_t* dest, const uint8_t* src, int count, int phase, int scale, const Pixel*)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        dest[i] = *src;
+
+        if (++phase == scale)
+        {
+            phase = 0;
+            ++src;
+        }
+    }
+}
+
+
+template <typename T>
+static void raster_hspan(const Raster<T>& raster, int x0, int x1, int y, T c)
+{
+    x0 = std::max(x0, raster.clip_x0);
+    x1 = std::min(x1, raster.clip_x1);
+
+    if (y >= raster.clip_y0 && y < raster.clip_y1 && x0 < x1)
+    {
+        fill_span(raster, raster.pixels + (y * raster.stride) + x0, x1 - x0, c);
+    }
+}
+
+
+template <typename T>
+static void raster_vspan(const Raster<T>& raster, int x, int y0, int y1, T c)
+{
+    y0 = std::max(y0, raster.clip_y0);
+    y1 = std::min(y1, raster.clip_y1);
+
+    if (x >= raster.clip_x0 && x < raster.clip_x1)
+    {
+        T* dest = raster.pixels + (y0 * raster.stride) + x;
+
+        for (int y = y0; y < y1; ++y)
+        {
+            fill_span(raster, dest, 1, c);
+            dest += raster.stride;
+        }
+    }
+}
+
+
+template <typename T>
+void raster_clear(const Raster<T>& raster, T c)
+{
+    int width = raster.clip_x1 - raster.clip_x0;
+    int height = raster.clip_y1 - raster.clip_y0;
+
+    if (width > 0 && height > 0)
+    {
+        clear_rows(raster.pixels + (raster.clip_y0 * raster.stride) + raster.clip_x0, width, height, raster.stride, c);
+    }
+}
+
+
+template <typename T>
+void raster_set_pixel(const Raster<T>& raster, int x, int y, T c)
+{
+    if (x >= raster.clip_x0 && x < raster.clip_x1 && y >= raster.clip_y0 && y < raster.clip_y1)
+    {
+        fill_span(raster, raster.pixels + (y * raster.stride) + x, 1, c);
+    }
+}
+
+
+template <typename T>
+void raster_line(const Raster<T>& raster, int x1, int y1, int x2, int y2, T c)
+{
+    int delta_x = x2 - x1;
+    int delta_y = y2 - y1;
+    int step_x = delta_x > 0 ? 1 : (delta_x < 0 ? -1 : 0);
+    int step_y = delta_y > 0 ? 1 : (delta_y < 0 ? -1 : 0);
+    bool x_major = (delta_x * step_x) > (delta_y * step_y);
+
+    // Steps along the major axis (the end point isn't drawn) and along the minor axis
+    int length = x_major ? delta_x * step_x : delta_y * step_y;
+    int minor_length = x_major ? delta_y * step_y : delta_x * step_x;
+
+    if (length == 0)
+    {
+        return;
+    }
+
+    // Cohen-Sutherland outcodes - reject lines entirely off one side of the clip rectangle, accept lines entirely in it
+    auto outcode = [&raster](int x, int y) -> int {
+        return (x < raster.clip_x0 ? 1 : 0) | (x >= raster.clip_x1 ? 2 : 0) | (y < raster.clip_y0 ? 4 : 0) | (y >= raster.clip_y1 ? 8 : 0);
+    };
+
+    int code1 = outcode(x1, y1);
+    int code2 = outcode(x2, y2);
+
+    if (code1 & code2)
+    {
+        return;
+    }
+
+    // The minor axis moves on step i when the error term crosses half a pixel, so after i steps it has moved
+    // (2 * i * minor_length + length) / (2 * length) pixels. Clipping is done on the range of steps rather than the end points,
+    // so the pixels drawn are exactly the visible pixels of the unclipped line.
+    int first = 0;
+    int last = length - 1;
+
+    if (code1 | code2)
+    {
+        int major_start = x_major ? x1 : y1;
+        int major_step = x_major ? step_x : step_y;
+        int major_min = x_major ? raster.clip_x0 : raster.clip_y0;
+        int major_max = (x_major ? raster.clip_x1 : raster.clip_y1) - 1;
+        int minor_start = x_major ? y1 : x1;
+        int minor_step = x_major ? step_y : step_x;
+        int minor_min = x_major ? raster.clip_y0 : raster.clip_x0;
+        int minor_max = (x_major ? raster.clip_y1 : raster.clip_x1) - 1;
+
+        if (major_step > 0)
+        {
+            first = std::max(first, major_min - major_start);
+            last = std::min(last, major_max - major_start);
+        }
+        else
+        {
+            first = std::max(first, major_start - major_max);
+            last = std::min(last, major_start - major_min);
+        }
+
+        if (minor_step != 0)
+        {
+            int64_t min_moves = minor_step > 0 ? (int64_t)minor_min - minor_start : (int64_t)minor_start - minor_max;
+            int64_t max_moves = minor_step > 0 ? (int64_t)minor_max - minor_start : (int64_t)minor_start - minor_min;
+            int64_t two_minor = 2 * (int64_t)minor_length;
+            min_moves = std::max<int64_t>(min_moves, 0);
+            max_moves = std::min<int64_t>(max_moves, minor_length);
+
+            if (min_moves > max_moves)
+            {
+                return;
+            }
+
+            if (min_moves > 0)
+            {
+                first = std::max(first, (int)(((2 * min_moves - 1) * length + two_minor - 1) / two_minor));
+            }
+
+            last = std::min(last, (int)(((2 * max_moves + 1) * length + two_minor - 1) / two_minor) - 1);
+        }
+
+        if (first > last)
+        {
+            return;
+        }
+    }
+
+    int moves = (int)((2 * (int64_t)first * minor_length + length) / (2 * (int64_t)length));
+    int error = first * minor_length - moves * length;
+
+    if (x_major)
+    {
+        // Horizontal runs of pixels become spans
+        int x = x1 + first * step_x;
+        int y = y1 + moves * step_y;
+        int run_start = x;
+
+        for (int i = first; i <= last; ++i, x += step_x)
+        {
+            error += minor_length;
+            bool move = (error * 2) >= length;
+
+            if (move || i == last)
+            {
+                int left = std::min(run_start, x);
+                int right = std::max(run_start, x);
+                fill_span(raster, raster.pixels + (y * raster.stride) + left, right - left + 1, c);
+                run_start = x + step_x;
+            }
+
+            if (move)
+            {
+                y += step_y;
+                error -= length;
+            }
+        }
+    }
+    else
+    {
+        int x = x1 + moves * step_x;
+        int y = y1 + first * step_y;
+        T* dest = raster.pixels + (y * raster.stride) + x;
+        int dest_step = step_y * raster.stride;
+
+        for (int i = first; i <= last; ++i)
+        {
+            fill_span(raster, dest, 1, c);
+            dest += dest_step;
+            error += minor_length;
+
+            if ((error * 2) >= length)
+            {
+                dest += step_x;
+                error -= length;
+            }
+        }
+    }
+}
+
+
+template <typename T>
+void raster_rect(const Raster<T>& raster, int x, int y, int w, int h, T c)
+{
+    if (w <= 0 || h <= 0)
+    {
+        return;
+    }
+
+    raster_hspan(raster, x, x + w, y, c);
+
+    if (h > 1)
+    {
+        raster_hspan(raster, x, x + w, y + h - 1, c);
+    }
+
+    raster_vspan(raster, x, y + 1, y + h - 1, c);
+
+    if (w > 1)
+    {
+        raster_vspan(raster, x + w - 1, y + 1, y + h - 1, c);
+    }
+}
+
+
+template <typename T>
+void raster_fill_rect(const Raster<T>& raster, int x, int y, int w, int h, int bw, T fg, T bg)
+{
+    int x0 = std::max(x, raster.clip_x0);
+    int y0 = std::max(y, raster.clip_y0);
+    int x1 = std::min(x + w, raster.clip_x1);
+    int y1 = std::min(y + h, raster.clip_y1);
+
+    if (x0 >= x1 || y0 >= y1)
+    {
+        return;
+    }
+
+    // bw pixels around the edge are drawn in bg, the interior in fg
+    bw = std::max(bw, 0);
+    int inner_x0 = x + bw;
+    int inner_x1 = x + w - bw;
+    int inner_y0 = y + bw;
+    int inner_y1 = y + h - bw;
+    T* row = raster.pixels + (y0 * raster.stride);
+
+    auto span = [&raster, x0, x1](T* row, int from, int to, T c) {
+        from = std::max(from, x0);
+        to = std::min(to, x1);
+
+        if (from < to)
+        {
+            fill_span(raster, row + from, to - from, c);
+        }
+    };
+
+    for (int py = y0; py < y1; ++py)
+    {
+        if (py < inner_y0 || py >= inner_y1 || inner_x0 >= inner_x1)
+        {
+            span(row, x0, x1, bg);
+        }
+        else
+        {
+            span(row, x, inner_x0, bg);
+            span(row, inner_x0, inner_x1, fg);
+            span(row, inner_x1, x + w, bg);
+        }
+
+        row += raster.stride;
+    }
+}
+
+
+template <typename T>
+void raster_glyphs(const Raster<T>& raster, int x, int y, const char* str, int len, const Font& font, T fg, T bg)
+{
+    int w = font.glyph_width();
+    int h = font.glyph_height();
+
+    // Clip the whole string once, then draw it a row at a time
+    int x0 = std::max(x, raster.clip_x0);
+    int y0 = std::max(y, raster.clip_y0);
+    int x1 = (int)std::min<int64_t>((int64_t)x + (int64_t)len * w, raster.clip_x1);
+    int y1 = std::min(y + h, raster.clip_y1);
+
+    if (x0 >= x1 || y0 >= y1)
+    {
+        return;
+    }
+
+    int first = (x0 - x) / w;
+    int last = (x1 - 1 - x) / w;
+
+    for (int py = y0; py < y1; ++py)
+    {
+        T* row = raster.pixels + (py * raster.stride) + x0;
+        T* dest = begin_span(raster, row, x1 - x0);
+
+        for (int i = first; i <= last; ++i)
+        {
+            int gx = x + i * w;
+            int from = std::max(gx, x0);
+            int to = std::min(gx + w, x1);
+            uint32_t mask = font.glyph((uint8_t)str[i])[py - y] >> (from - gx);
+            expand_mask(dest, mask, to - from, fg, bg);
+            dest += to - from;
+        }
+
+        end_span(raster, row, x1 - x0);
+    }
+}
+
+
+template <typename T>
+void raster_copy_rect(const Raster<T>& raster, int x, int y, int w, int h, const uint8_t* src, int stride, const Pixel* palette)
+{
+    int x0 = std::max(x, raster.clip_x0);
+    int y0 = std::max(y, raster.clip_y0);
+    int x1 = std::min(x + w, raster.clip_x1);
+    int y1 = std::min(y + h, raster.clip_y1);
+
+    if (x0 >= x1 || y0 >= y1)
+    {
+        return;
+    }
+
+    src += (x0 - x) + (y0 - y) * stride;
+    T* dest = raster.pixels + x0 + (y0 * raster.stride);
+
+    for (int py = y0; py < y1; ++py)
+    {
+        copy_row(dest, src, x1 - x0, palette);
+        dest += raster.stride;
+        src += stride;
+    }
+}
+
+
+template <typename T>
+void raster_copy_rect_scaled(const Raster<T>& raster, int x, int y, int w, int h, const uint8_t* src, int stride, int scale,
+                             const Pixel* palette)
+{
+    int x0 = std::max(x, raster.clip_x0);
+    int y0 = std::max(y, raster.clip_y0);
+    int x1 = std::min(x + w, raster.clip_x1);
+    int y1 = std::min(y + h, raster.clip_y1);
+
+    if (x0 >= x1 || y0 >= y1)
+    {
+        return;
+    }
+
+    // Where the clipped rectangle starts within its first block
+    int phase_x = (x0 - x) % scale;
+    int phase_y = (y0 - y) % scale;
+    src += (x0 - x) / scale + ((y0 - y) / scale) * stride;
+    T* dest = raster.pixels + x0 + (y0 * raster.stride);
+    const T* expanded = nullptr;
+
+    // Each source row is expanded once, the other rows of its block are copies
+    for (int py = y0; py < y1; ++py)
+    {
+        if (expanded && phase_y != 0)
+        {
+            memcpy(dest, expanded, sizeof(T) * (x1 - x0));
+        }
+        else
+        {
+            scale_row(dest, src, x1 - x0, phase_x, scale, palette);
+        }
+
+        expanded = dest;
+        dest += raster.stride;
+
+        if (++phase_y == scale)
+        {
+            phase_y = 0;
+            src += stride;
+        }
+    }
+}
+
+
+void raster_sprite(const Raster<Pixel>& raster, int x, int y, const Sprite& sprite, int ox, int oy, int w, int h)
+{
+    int x0 = std::max(x, raster.clip_x0);
+    int y0 = std::max(y, raster.clip_y0);
+    int x1 = std::min(x + w, raster.clip_x1);
+    int y1 = std::min(y + h, raster.clip_y1);
+
+    if (x0 >= x1 || y0 >= y1)
+    {
+        return;
+    }
+
+    const Pixel* src = sprite.pixels() + (ox + x0 - x) + ((oy + y0 - y) * sprite.stride());
+    Pixel* dest = raster.pixels + x0 + (y0 * raster.stride);
+
+    for (int py = y0; py < y1; ++py)
+    {
+        memcpy(dest, src, sizeof(Pixel) * (x1 - x0));
+        src += sprite.stride();
+        dest += raster.stride;
+    }
+}
+
+
+// Transparent runs only have their alpha set, opaque runs are copied when alpha is 255 and the rest blended. Every pixel comes
+// out opaque, the same as blend_straight leaves them.
+static void blend_sprite_runs(const Raster<Pixel>& raster, const Sprite& sprite, int x0, int y0, int x1, int y1, int sx0, int sy0,
+                              uint8_t alpha)
+{
+    int sx1 = sx0 + (x1 - x0);
+    const Pixel* src_row = sprite.premultiplied_pixels() + sy0 * sprite.stride();
+    Pixel* dest_row = raster.pixels + x0 + (y0 * raster.stride);
+
+    for (int sy = sy0; sy < sy0 + (y1 - y0); ++sy)
+    {
+        int count;
+        const SpriteRun* runs = sprite.row_runs(sy, count);
+
+        for (const SpriteRun* run = runs; run < runs + count && run->start < sx1; ++run)
+        {
+            int start = std::max((int)run->start, sx0);
+            int end = std::min(run->start + run->length, sx1);
+
+            if (start >= end)
+            {
+                continue;
+            }
+
+            if (run->type == SpriteRun::Skip)
+            {
+                for (Pixel* dest = dest_row + (start - sx0); dest < dest_row + (end - sx0); ++dest)
+                {
+                    dest->a = 255;
+                }
+            }
+            else if (run->type == SpriteRun::Opaque && alpha == 255)
+            {
+                memcpy(dest_row + (start - sx0), src_row + start, sizeof(Pixel) * (end - start));
+            }
+            else
+            {
+                blend_premultiplied(dest_row + (start - sx0), src_row + start, end - start, alpha);
+            }
+        }
+
+        src_row += sprite.stride();
+        dest_row += raster.stride;
+    }
+}
+
+
+void raster_blend_sprite(const Raster<Pixel>& raster, int x, int y, const Sprite& sprite, int ox, int oy, int w, int h, uint8_t alpha)
+{
+    int x0 = std::max(x, raster.clip_x0);
+    int y0 = std::max(y, raster.clip_y0);
+    int x1 = std::min(x + w, raster.clip_x1);
+    int y1 = std::min(y + h, raster.clip_y1);
+
+    if (x0 >= x1 || y0 >= y1)
+    {
+        return;
+    }
+
+    if (sprite.has_runs())
+    {
+        blend_sprite_runs(raster, sprite, x0, y0, x1, y1, ox + x0 - x, oy + y0 - y, alpha);
+        return;
+    }
+
+    const Pixel* src = sprite.pixels() + (ox + x0 - x) + ((oy + y0 - y) * sprite.stride());
+    Pixel* dest = raster.pixels + x0 + (y0 * raster.stride);
+
+    for (int py = y0; py < y1; ++py)
+    {
+        blend_straight(dest, src, x1 - x0, alpha);
+        src += sprite.stride();
+        dest += raster.stride;
+    }
+}
+
+
+static int64_t floor_div(int64_t a, int64_t b)
+{
+    return a >= 0 ? a / b : -((b - 1 - a) / b);
+}
+
+
+// Narrow the steps [lo, hi) to those with 0 <= start + i * step < limit. Done exactly in integers so a span's ends don't depend
+// on where it was clipped.
+static void clip_steps(int64_t start, int64_t step, int64_t limit, int& lo, int& hi)
+{
+    int64_t first;
+    int64_t end;
+
+    if (step > 0)
+    {
+        first = -floor_div(start, step);
+        end = -floor_div(start - limit, step);
+    }
+    else if (step < 0)
+    {
+        first = floor_div(start - limit, -step) + 1;
+        end = floor_div(start, -step) + 1;
+    }
+    else
+    {
+        first = start >= 0 && start < limit ? lo : hi;
+        end = hi;
+    }
+
+    lo = (int)std::max<int64_t>(lo, first);
+    hi = (int)std::min<int64_t>(hi, end);
+}
+
+
+void raster_transformed_sprite(const Raster<Pixel>& raster, int x, int y, int w, int h, const SpriteTransform& transform)
+{
+    int x0 = std::max(x, raster.clip_x0);
+    int y0 = std::max(y, raster.clip_y0);
+    int x1 = std::min(x + w, raster.clip_x1);
+    int y1 = std::min(y + h, raster.clip_y1);
+
+    if (x0 >= x1 || y0 >= y1)
+    {
+        return;
+    }
+
+    const Sprite& sprite = *transform.sprite;
+    const Pixel* src = sprite.pixels() + transform.sx + (transform.sy * sprite.stride());
+    int64_t limit_u = (int64_t)transform.sw << 16;
+    int64_t limit_v = (int64_t)transform.sh << 16;
+
+    for (int py = y0; py < y1; ++py)
+    {
+        // Steps are counted from the left edge of the bounds, whatever the clip rectangle
+        int64_t u = transform.u + (int64_t)(py - y) * transform.du_dy;
+        int64_t v = transform.v + (int64_t)(py - y) * transform.dv_dy;
+        int lo = x0 - x;
+        int hi = x1 - x;
+        clip_steps(u, transform.du_dx, limit_u, lo, hi);
+        clip_steps(v, transform.dv_dx, limit_v, lo, hi);
+
+        if (lo >= hi)
+        {
+            continue;
+        }
+
+        int su = (int)(u + (int64_t)lo * transform.du_dx);
+        int sv = (int)(v + (int64_t)lo * transform.dv_dx);
+        Pixel* dest = raster.pixels + x + lo + (py * raster.stride);
+        Pixel* span = begin_span(raster, dest, hi - lo);
+
+        if (transform.filter == Filter_Bilinear)
+        {
+            sample_bilinear(span, src, sprite.stride(), transform.sw, transform.sh, su, sv, transform.du_dx, transform.dv_dx, hi - lo);
+        }
+        else
+        {
+            sample_nearest(span, src, sprite.stride(), su, sv, transform.du_dx, transform.dv_dx, hi - lo);
+        }
+
+        end_span(raster, dest, hi - lo);
+    }
+}
+
+
+template void raster_clear(const Raster<Pixel>&, Pixel);
+template void raster_clear(const Raster<uint8_t>&, uint8_t);
+template void raster_set_pixel(const Raster<Pixel>&, int, int, Pixel);
+template void raster_set_pixel(const Raster<uint8_t>&, int, int, uint8_t);
+template void raster_line(const Raster<Pixel>&, int, int, int, int, Pixel);
+template void raster_line(const Raster<uint8_t>&, int, int, int, int, uint8_t);
+template void raster_rect(const Raster<Pixel>&, int, int, int, int, Pixel);
+template void raster_rect(const Raster<uint8_t>&, int, int, int, int, uint8_t);
+template void raster_fill_rect(const Raster<Pixel>&, int, int, int, int, int, Pixel, Pixel);
+template void raster_fill_rect(const Raster<uint8_t>&, int, int, int, int, int, uint8_t, uint8_t);
+template void raster_glyphs(const Raster<Pixel>&, int, int, const char*, int, const Font&, Pixel, Pixel);
+template void raster_glyphs(const Raster<uint8_t>&, int, int, const char*, int, const Font&, uint8_t, uint8_t);
+template void raster_copy_rect(const Raster<Pixel>&, int, int, int, int, const uint8_t*, int, const Pixel*);
+template void raster_copy_rect(const Raster<uint8_t>&, int, int, int, int, const uint8_t*, int, const Pixel*);
+template void raster_copy_rect_scaled(const Raster<Pixel>&, int, int, int, int, const uint8_t*, int, int, const Pixel*);
+template void raster_copy_rect_scaled(const Raster<uint8_t>&, int, int, int, int, const uint8_t*, int, int, const Pixel*);
+
+} // namespace gli
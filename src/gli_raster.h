@@ -0,0 +1,72 @@
+#pragma once
+
+#include "gli_core.h" // for gli::Pixel, gli::BlendOp, gli::BlendKernel
+
+#include <vector>
+
+namespace gli
+{
+
+class Font;
+class Sprite;
+
+// Where and how the raster functions draw: a framebuffer of Pixels or palette indices, the rectangle they're clipped to and
+// the blend state. Blending only applies to Pixel framebuffers.
+template <typename T>
+struct Raster
+{
+    T* pixels;
+    int stride;
+    int clip_x0; // Half open, x0 <= x < x1
+    int clip_y0;
+    int clip_x1;
+    int clip_y1;
+    BlendOp blend_op;
+    BlendKernel blend_kernel;
+    uint8_t blend_constant;
+    std::vector<Pixel>* span_buffer; // Scratch for blended spans, one per thread
+};
+
+// Maps destination pixels back into a rectangle of a sprite. Coordinates are 16.16 fixed point source pixels relative to the
+// rectangle's top left, and (u, v) is where the centre of the top left pixel of the destination bounds lands.
+struct SpriteTransform
+{
+    const Sprite* sprite;
+    int sx;
+    int sy;
+    int sw;
+    int sh;
+    int u;
+    int v;
+    int du_dx; // Step per destination pixel
+    int dv_dx;
+    int du_dy; // Step per destination row
+    int dv_dy;
+    SpriteFilter filter;
+};
+
+// Everything is clipped to the raster's clip rectangle, and drawing a primitive clipped to several rectangles covering the
+// screen gives exactly the same pixels as drawing it clipped to the screen. Instantiated for Pixel and uint8_t.
+template <typename T> void raster_clear(const Raster<T>& raster, T c);
+template <typename T> void raster_set_pixel(const Raster<T>& raster, int x, int y, T c);
+template <typename T> void raster_line(const Raster<T>& raster, int x1, int y1, int x2, int y2, T c);
+template <typename T> void raster_rect(const Raster<T>& raster, int x, int y, int w, int h, T c);
+template <typename T> void raster_fill_rect(const Raster<T>& raster, int x, int y, int w, int h, int bw, T fg, T bg);
+template <typename T> void raster_glyphs(const Raster<T>& raster, int x, int y, const char* str, int len, const Font& font, T fg, T bg);
+
+// Copy palette indices, expanded through the palette for Pixel framebuffers
+template <typename T>
+void raster_copy_rect(const Raster<T>& raster, int x, int y, int w, int h, const uint8_t* src, int stride, const Pixel* palette);
+
+// Same as raster_copy_rect with every index drawn as a scale x scale block, w and h are the destination size
+template <typename T>
+void raster_copy_rect_scaled(const Raster<T>& raster, int x, int y, int w, int h, const uint8_t* src, int stride, int scale,
+                             const Pixel* palette);
+
+void raster_sprite(const Raster<Pixel>& raster, int x, int y, const Sprite& sprite, int ox, int oy, int w, int h);
+void raster_blend_sprite(const Raster<Pixel>& raster, int x, int y, const Sprite& sprite, int ox, int oy, int w, int h, uint8_t alpha);
+
+// Resample a sprite into the destination bounds (x, y, w, h) through the current blend state
+void raster_transformed_sprite(const Raster<Pixel>& raster, int x, int y, int w, int h, const SpriteTransform& transform);
+
+} // namespace gli
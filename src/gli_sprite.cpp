@@ -1,26 +1,74 @@
 #include "gli_sprite.h"
+#include "gli_debug.h"
 #include "gli_file.h"
+#include "gli_memory.h"
 
 #include <stb/stb_image.h>
 #include <stb/stb_image_write.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <vector>
 
 namespace gli
 {
 
+static const char CookedMagic[4] = { 'G', 'L', 'I', 'S' };
+static const uint16_t CookedVersion = 1;
+static const uint32_t CookedMaxSize = 0xFFFF; // Width and height, the widest row SpriteRun can cover
+static const uint32_t CookedMaxPadding = 64; // Pixels past the width, enough for any sane RowAlignment
+
+// Padded to RowAlignment so the rows that follow keep their alignment if the file is read to an aligned address
+struct CookedHeader
+{
+    char magic[4];
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride; // In pixels
+    uint32_t reserved[3];
+};
+
+static_assert(sizeof(CookedHeader) == Sprite::RowAlignment, "CookedHeader should be one row alignment");
+
+
+void Sprite::AlignedFree::operator()(Pixel* pixels) const
+{
+    memory_free(pixels);
+}
+
+
+void Sprite::allocate(int w, int h)
+{
+    static const int RowPixels = RowAlignment / sizeof(Pixel);
+
+    m_width = w;
+    m_height = h;
+    m_stride = (w + RowPixels - 1) / RowPixels * RowPixels;
+
+    size_t size = sizeof(Pixel) * m_stride * h;
+    Pixel* pixels = (Pixel*)memory_allocate(size, RowAlignment);
+    gliAssert(pixels || size == 0);
+    std::fill_n(pixels, m_stride * h, Pixel());
+    m_pixels.reset(pixels);
+}
+
+
 Sprite::Sprite(int w, int h)
-    : m_width(w)
-    , m_height(h)
 {
-    m_pixels.reset(new Pixel[w * h]);
+    allocate(w, h);
 }
 
 Sprite::Sprite(int w, int h, const Pixel* pixels)
-    : m_width(w)
-    , m_height(h)
 {
-    m_pixels.reset(new Pixel[w * h]);
-    memcpy(m_pixels.get(), pixels, w * h * sizeof(Pixel));
+    allocate(w, h);
+
+    for (int y = 0; y < h; ++y)
+    {
+        memcpy(m_pixels.get() + y * m_stride, pixels + y * w, w * sizeof(Pixel));
+    }
 }
 
 Sprite::~Sprite()
@@ -40,6 +88,11 @@ bool Sprite::load(const std::string& path)
         return false;
     }
 
+    if (image_data.size() >= sizeof(CookedMagic) && memcmp(image_data.data(), CookedMagic, sizeof(CookedMagic)) == 0)
+    {
+        return load_cooked(image_data);
+    }
+
     int x = 0;
     int y = 0;
     int comp;
@@ -52,32 +105,98 @@ bool Sprite::load(const std::string& path)
         return false;
     }
 
-    m_width = x;
-    m_height = y;
-    m_pixels.reset(new Pixel[m_width * m_height]);
-    Pixel *p = m_pixels.get();
+    allocate(x, y);
+    const stbi_uc* src = data;
 
     for (y = 0; y < m_height; ++y)
     {
+        Pixel* p = m_pixels.get() + y * m_stride;
+
         for (x = 0; x < m_width; ++x)
         {
-            p->r = *data++;
-            p->g = *data++;
-            p->b = *data++;
-            p->a = *data++;
+            p->r = *src++;
+            p->g = *src++;
+            p->b = *src++;
+            p->a = *src++;
             p++;
         }
     }
 
+    stbi_image_free(data);
     return true;
 }
 
 
+bool Sprite::load_cooked(const std::vector<uint8_t>& data)
+{
+    CookedHeader header;
+    memcpy(&header, data.data(), std::min(data.size(), sizeof(header)));
+
+    // Bound the sizes on their own too, with a height of 0 the file size check passes any width and stride
+    if (data.size() < sizeof(header) || header.version != CookedVersion || header.header_size < sizeof(header) ||
+        header.width > CookedMaxSize || header.height > CookedMaxSize || header.stride < header.width ||
+        header.stride - header.width > CookedMaxPadding ||
+        data.size() < header.header_size + (size_t)header.stride * header.height * sizeof(Pixel))
+    {
+        return false;
+    }
+
+    allocate((int)header.width, (int)header.height);
+    const Pixel* src = (const Pixel*)(data.data() + header.header_size);
+
+    if ((int)header.stride == m_stride)
+    {
+        memcpy(m_pixels.get(), src, sizeof(Pixel) * m_stride * m_height);
+    }
+    else
+    {
+        // Cooked with a different RowAlignment
+        for (int y = 0; y < m_height; ++y)
+        {
+            memcpy(m_pixels.get() + y * m_stride, src + y * header.stride, m_width * sizeof(Pixel));
+        }
+    }
+
+    return true;
+}
+
+
+bool Sprite::save_cooked(const std::string& path) const
+{
+    FILE* file = fopen(path.c_str(), "wb");
+
+    if (!file)
+    {
+        return false;
+    }
+
+    CookedHeader header{};
+    memcpy(header.magic, CookedMagic, sizeof(CookedMagic));
+    header.version = CookedVersion;
+    header.header_size = sizeof(header);
+    header.width = m_width;
+    header.height = m_height;
+    header.stride = m_stride;
+    fwrite(&header, sizeof(header), 1, file);
+
+    if (m_height > 0)
+    {
+        fwrite(m_pixels.get(), sizeof(Pixel) * m_stride, m_height, file);
+    }
+
+    bool written = ferror(file) == 0;
+    fclose(file);
+    return written;
+}
+
+
 void Sprite::unload()
 {
     m_width = 0;
     m_height = 0;
+    m_stride = 0;
     m_pixels.reset();
+    drop_runs();
 }
 
 
@@ -85,7 +204,8 @@ void Sprite::set_pixel(int x, int y, Pixel p)
 {
     if (x >= 0 && x < m_width && y >= 0 && y < m_height)
     {
-        m_pixels.get()[x + y * m_width] = p;
+        m_pixels.get()[x + y * m_stride] = p;
+        drop_runs();
     }
 }
 
@@ -102,9 +222,85 @@ int Sprite::height() const
 }
 
 
+int Sprite::stride() const
+{
+    return m_stride;
+}
+
+
 Pixel* Sprite::pixels() const
 {
     return m_pixels.get();
 }
 
+
+void Sprite::build_runs()
+{
+    gliAssert(m_width <= 0xFFFF);
+
+    size_t size = sizeof(Pixel) * m_stride * m_height;
+    Pixel* premultiplied = (Pixel*)memory_allocate(size, RowAlignment);
+    gliAssert(premultiplied || size == 0);
+    std::fill_n(premultiplied, m_stride * m_height, Pixel());
+    m_premultiplied.reset(premultiplied);
+    m_runs.clear();
+    m_row_runs.resize(m_height + 1);
+
+    for (int y = 0; y < m_height; ++y)
+    {
+        const Pixel* src = m_pixels.get() + y * m_stride;
+        Pixel* dest = m_premultiplied.get() + y * m_stride;
+        m_row_runs[y] = (uint32_t)m_runs.size();
+
+        for (int x = 0; x < m_width; ++x, ++src, ++dest)
+        {
+            uint32_t a = src->a;
+            dest->r = (uint8_t)((src->r * a + 127) / 255);
+            dest->g = (uint8_t)((src->g * a + 127) / 255);
+            dest->b = (uint8_t)((src->b * a + 127) / 255);
+            dest->a = (uint8_t)a;
+
+            SpriteRun::Type type = a == 0 ? SpriteRun::Skip : (a == 255 ? SpriteRun::Opaque : SpriteRun::Blend);
+
+            if (x > 0 && m_runs.back().type == type)
+            {
+                ++m_runs.back().length;
+            }
+            else
+            {
+                m_runs.push_back({ (uint16_t)x, 1, type });
+            }
+        }
+    }
+
+    m_row_runs[m_height] = (uint32_t)m_runs.size();
+}
+
+
+void Sprite::drop_runs()
+{
+    m_premultiplied.reset();
+    m_runs.clear();
+    m_row_runs.clear();
+}
+
+
+bool Sprite::has_runs() const
+{
+    return !m_row_runs.empty();
+}
+
+
+const Pixel* Sprite::premultiplied_pixels() const
+{
+    return m_premultiplied.get();
+}
+
+
+const SpriteRun* Sprite::row_runs(int y, int& count) const
+{
+    count = (int)(m_row_runs[y + 1] - m_row_runs[y]);
+    return m_runs.data() + m_row_runs[y];
+}
+
 } // namespace gli
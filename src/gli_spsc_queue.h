@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace gli
+{
+
+// A fixed size ring passing items from one producer thread to one consumer thread without locks, neither side ever waits on the
+// other. Capacity must be a power of two.
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+public:
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+    SpscQueue() = default;
+    SpscQueue(const SpscQueue&) = delete;
+
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer only, false when the queue is full
+    bool push(const T& item)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+
+        if (tail - m_head.load(std::memory_order_acquire) == Capacity)
+        {
+            return false;
+        }
+
+        m_items[tail & (Capacity - 1)] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only, false when the queue is empty
+    bool pop(T& item)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+
+        if (head == m_tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        item = m_items[head & (Capacity - 1)];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    static const size_t CacheLine = 64;
+
+    // The indices only ever grow, wrapping is fine as long as Capacity divides the range. Each sits on its own cache line so
+    // the two threads don't keep taking it from each other.
+    std::atomic<size_t> m_head{};
+    char m_head_padding[CacheLine - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> m_tail{};
+    char m_tail_padding[CacheLine - sizeof(std::atomic<size_t>)];
+    T m_items[Capacity];
+};
+
+} // namespace gli
@@ -0,0 +1,11 @@
+#include "gli_surface.h"
+
+namespace gli
+{
+
+// Sprite already clears the pixels, to transparent black
+Surface::Surface(int w, int h) : Sprite(w, h)
+{
+}
+
+} // namespace gli
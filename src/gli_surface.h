@@ -0,0 +1,37 @@
+#pragma once
+
+#include "gli_sprite.h"
+
+namespace gli
+{
+
+// An offscreen image that draw calls can be pointed at with App::push_target. It's a Sprite, so it goes back onto the screen
+// (or another surface) through any of the sprite calls. Layers that rarely change can be drawn into one only when they do and
+// blitted every frame.
+class Surface : public Sprite
+{
+public:
+    Surface() = default;
+    Surface(Surface&&) = default;
+
+    // Starts out transparent and stale
+    Surface(int w, int h);
+
+    Surface& operator=(Surface&&) = default;
+
+    // Stale until something has been drawn into it, popping it off the target stack clears this. Invalidate it when whatever
+    // it shows changes, so the next frame knows to redraw it.
+    bool stale() const { return m_stale; }
+    void invalidate() { m_stale = true; }
+
+    // Counts the times it's been pushed as a target, so whatever composites it can tell when it might have changed
+    uint32_t generation() const { return m_generation; }
+
+private:
+    friend class App;
+
+    bool m_stale = true;
+    uint32_t m_generation = 0;
+};
+
+} // namespace gli
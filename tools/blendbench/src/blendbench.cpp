@@ -0,0 +1,338 @@
+// Checks gli::blend_straight, and sprites blended through their premultiplied runs, against the float blend blend_partial_sprite
+// used to do, then times both over sprite sized rows. Also checks gli::scale_pixels against LightTable's tables. Runs once for each
+// instruction set the CPU supports.
+
+#include "gli_blend.h"
+#include "gli_light.h"
+#include "gli_raster.h"
+#include "gli_sprite.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+
+// The blend from before blend_straight, kept as the reference
+static void blend_float(gli::Pixel* dest, const gli::Pixel* src, int count, uint8_t alpha)
+{
+    const float denom = 1.0f / 255.0f;
+
+    for (int i = 0; i < count; ++i)
+    {
+        float sr = src[i].r * denom;
+        float sg = src[i].g * denom;
+        float sb = src[i].b * denom;
+        float dr = dest[i].r * denom;
+        float dg = dest[i].g * denom;
+        float db = dest[i].b * denom;
+        float w = alpha * denom * src[i].a * denom;
+        float r = (sr * w) + dr * (1.0f - w);
+        float g = (sg * w) + dg * (1.0f - w);
+        float b = (sb * w) + db * (1.0f - w);
+
+        dest[i].r = r < 0.0f ? 0 : (r > 1.0f ? 255 : (uint8_t)(r * 255.0f));
+        dest[i].g = g < 0.0f ? 0 : (g > 1.0f ? 255 : (uint8_t)(g * 255.0f));
+        dest[i].b = b < 0.0f ? 0 : (b > 1.0f ? 255 : (uint8_t)(b * 255.0f));
+        dest[i].a = 255;
+    }
+}
+
+
+static uint32_t random_argb()
+{
+    return ((uint32_t)rand() << 17) ^ ((uint32_t)rand() << 6) ^ (uint32_t)rand();
+}
+
+
+// Worst channel difference between two sets of pixels, and how many channels differ at all
+struct Accuracy
+{
+    int worst{};
+    long long differ{};
+    long long total{};
+
+    void compare(const gli::Pixel* expected, const gli::Pixel* actual, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            for (int shift = 0; shift < 32; shift += 8)
+            {
+                int diff = abs((int)((expected[i].argb >> shift) & 0xFF) - (int)((actual[i].argb >> shift) & 0xFF));
+                worst = std::max(worst, diff);
+                differ += diff != 0;
+            }
+        }
+
+        total += count * 4;
+    }
+
+    bool report(const char* name) const
+    {
+        printf("%s: %lld channels, %lld differ from the float blend, by at most %d\n", name, total, differ, worst);
+        return worst <= 1;
+    }
+};
+
+
+static const uint8_t CheckAlphas[] = { 255, 254, 200, 128, 37, 1, 0 };
+
+
+// Every source channel, dest channel and source alpha at a few global alphas, plus random pixels at random alphas
+static bool check_accuracy()
+{
+    std::vector<gli::Pixel> src(256 * 256);
+    std::vector<gli::Pixel> expected(src.size());
+    std::vector<gli::Pixel> actual(src.size());
+    Accuracy accuracy;
+
+    for (uint8_t alpha : CheckAlphas)
+    {
+        for (int sa = 0; sa < 256; ++sa)
+        {
+            // r walks the source channel and g the dest channel, b tests both the other way round
+            for (int i = 0; i < 256 * 256; ++i)
+            {
+                int s = i & 0xFF;
+                int d = i >> 8;
+                src[i] = gli::Pixel((uint8_t)s, (uint8_t)d, (uint8_t)d, (uint8_t)sa);
+                expected[i] = gli::Pixel((uint8_t)d, (uint8_t)s, (uint8_t)s, (uint8_t)(i * 7));
+            }
+
+            actual = expected;
+            blend_float(expected.data(), src.data(), (int)src.size(), alpha);
+            gli::blend_straight(actual.data(), src.data(), (int)src.size(), alpha);
+            accuracy.compare(expected.data(), actual.data(), src.size());
+        }
+    }
+
+    for (int pass = 0; pass < 256; ++pass)
+    {
+        uint8_t alpha = (uint8_t)rand();
+
+        for (size_t i = 0; i < src.size(); ++i)
+        {
+            src[i].argb = random_argb();
+            expected[i].argb = random_argb();
+        }
+
+        // Odd lengths and offsets for the scalar tails
+        int offset = rand() % 8;
+        int count = (int)src.size() - offset - rand() % 8;
+        actual = expected;
+        blend_float(expected.data() + offset, src.data() + offset, count, alpha);
+        gli::blend_straight(actual.data() + offset, src.data() + offset, count, alpha);
+        accuracy.compare(expected.data(), actual.data(), src.size());
+    }
+
+    return accuracy.report("blend_straight");
+}
+
+
+// Sprites with runs blend their premultiplied copy instead, so raster_blend_sprite should still land within 1 of the float blend
+// of the straight pixels and leave the dest opaque, under transparent runs too
+static bool check_runs()
+{
+    static const int Size = 256;
+    std::vector<gli::Pixel> expected(Size * Size);
+    std::vector<gli::Pixel> actual(expected.size());
+    Accuracy accuracy;
+
+    // Every source channel along x and source alpha along y, over every dest channel in turn
+    std::vector<gli::Pixel> pixels(Size * Size);
+
+    for (int i = 0; i < Size * Size; ++i)
+    {
+        int s = i % Size;
+        pixels[i] = gli::Pixel((uint8_t)s, (uint8_t)s, (uint8_t)(255 - s), (uint8_t)(i / Size));
+    }
+
+    gli::Sprite sprite(Size, Size, pixels.data());
+    sprite.build_runs();
+    gli::Raster<gli::Pixel> raster{ actual.data(), Size, 0, 0, Size, Size, gli::BlendOp::None, {}, 255, nullptr };
+
+    for (uint8_t alpha : CheckAlphas)
+    {
+        for (int d = 0; d < 256; ++d)
+        {
+            std::fill(expected.begin(), expected.end(), gli::Pixel((uint8_t)d, (uint8_t)(255 - d), (uint8_t)d, 0x12));
+            actual = expected;
+            raster.pixels = actual.data();
+            blend_float(expected.data(), pixels.data(), (int)pixels.size(), alpha);
+            gli::raster_blend_sprite(raster, 0, 0, sprite, 0, 0, Size, Size, alpha);
+            accuracy.compare(expected.data(), actual.data(), expected.size());
+        }
+    }
+
+    // Random runs of transparent, opaque and mixed pixels, drawn partly outside a random clip rectangle
+    static const int SpriteWidth = 200;
+    static const int SpriteHeight = 64;
+    pixels.resize(SpriteWidth * SpriteHeight);
+
+    for (int pass = 0; pass < 256; ++pass)
+    {
+        for (size_t i = 0; i < pixels.size();)
+        {
+            int type = rand() % 3;
+            size_t end = std::min(pixels.size(), i + 1 + rand() % 40);
+
+            for (; i < end; ++i)
+            {
+                uint32_t argb = random_argb();
+                pixels[i].argb = type == 0 ? argb & 0x00FFFFFF : (type == 1 ? argb | 0xFF000000 : argb);
+            }
+        }
+
+        for (gli::Pixel& p : expected)
+        {
+            p.argb = random_argb();
+        }
+
+        gli::Sprite runs_sprite(SpriteWidth, SpriteHeight, pixels.data());
+        runs_sprite.build_runs();
+        uint8_t alpha = (uint8_t)rand();
+        int x = rand() % Size - SpriteWidth / 2;
+        int y = rand() % Size - SpriteHeight / 2;
+        actual = expected;
+        raster.pixels = actual.data();
+        raster.clip_x0 = rand() % 16;
+        raster.clip_y0 = rand() % 16;
+        raster.clip_x1 = Size - rand() % 16;
+        raster.clip_y1 = Size - rand() % 16;
+
+        int x0 = std::max(x, raster.clip_x0);
+        int x1 = std::min(x + SpriteWidth, raster.clip_x1);
+
+        for (int py = std::max(y, raster.clip_y0); py < std::min(y + SpriteHeight, raster.clip_y1) && x0 < x1; ++py)
+        {
+            blend_float(&expected[x0 + py * Size], &pixels[(x0 - x) + (py - y) * SpriteWidth], x1 - x0, alpha);
+        }
+
+        gli::raster_blend_sprite(raster, x, y, runs_sprite, 0, 0, SpriteWidth, SpriteHeight, alpha);
+        accuracy.compare(expected.data(), actual.data(), expected.size());
+    }
+
+    return accuracy.report("Sprite runs");
+}
+
+
+// scale_pixels at every factor against the integer math LightTable fills its tables with, then LightTable::scale_pixels against
+// its own tables at every factor a level can have
+static bool check_scale()
+{
+    std::vector<gli::Pixel> src(259); // Odd count for the scalar tails
+    std::vector<gli::Pixel> actual(src.size());
+    long long wrong = 0;
+    long long total = 0;
+
+    for (size_t i = 0; i < src.size(); ++i)
+    {
+        src[i] = gli::Pixel((uint8_t)i, (uint8_t)(255 - i), (uint8_t)(i * 7), (uint8_t)(i * 3));
+    }
+
+    for (int factor = 0; factor < 65536; ++factor)
+    {
+        gli::scale_pixels(actual.data(), src.data(), (int)src.size(), (uint16_t)factor);
+
+        for (size_t i = 0; i < src.size(); ++i)
+        {
+            auto scale = [factor](uint8_t c) { return (uint8_t)std::min((c * factor) >> 8, 255); };
+            gli::Pixel expected(scale(src[i].r), scale(src[i].g), scale(src[i].b), src[i].a);
+            wrong += actual[i].argb != expected.argb;
+        }
+
+        total += src.size();
+    }
+
+    // 257 levels per unit of scale steps the factor by 256 / 257, so the levels hit every factor up to 255 * 256
+    gli::LightTable table(65536, 255.0f);
+
+    for (int level = 0; level < table.levels(); ++level)
+    {
+        table.scale_pixels(actual.data(), src.data(), (int)src.size(), level);
+
+        for (size_t i = 0; i < src.size(); ++i)
+        {
+            wrong += actual[i].argb != table.scale_pixel(src[i], level).argb;
+        }
+
+        total += src.size();
+    }
+
+    printf("scale_pixels: %lld pixels, %lld differ from the tables\n", total, wrong);
+    return wrong == 0;
+}
+
+
+template <typename Func>
+static double time_rows(Func func, std::vector<gli::Pixel>& framebuffer, const std::vector<gli::Pixel>& sprite)
+{
+    static const int FramebufferWidth = 640;
+    static const int SpriteSize = 128;
+    static const int Repeats = 2000;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int repeat = 0; repeat < Repeats; ++repeat)
+    {
+        int x = (repeat * 37) % (FramebufferWidth - SpriteSize);
+        int y = (repeat * 11) % (360 - SpriteSize);
+
+        for (int row = 0; row < SpriteSize; ++row)
+        {
+            func(&framebuffer[x + (y + row) * FramebufferWidth], &sprite[row * SpriteSize], SpriteSize, (uint8_t)(repeat | 1));
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return seconds * 1e9 / ((double)Repeats * SpriteSize * SpriteSize);
+}
+
+
+int main(int, char**)
+{
+    static const struct
+    {
+        gli::BlendIsa isa;
+        const char* name;
+    } isas[] = { { gli::Isa_Sse2, "SSE2" }, { gli::Isa_Avx2, "AVX2" } };
+
+    std::vector<gli::Pixel> framebuffer(640 * 360);
+    std::vector<gli::Pixel> sprite(128 * 128);
+    bool accurate = true;
+
+    for (const auto& isa : isas)
+    {
+        if (!gli::set_blend_isa(isa.isa))
+        {
+            printf("%s: not supported by this CPU, skipped\n", isa.name);
+            continue;
+        }
+
+        printf("%s\n", isa.name);
+        srand(1);
+        accurate &= check_accuracy();
+        accurate &= check_runs();
+        accurate &= check_scale();
+
+        for (gli::Pixel& p : framebuffer)
+        {
+            p.argb = random_argb() | 0xFF000000;
+        }
+
+        for (gli::Pixel& p : sprite)
+        {
+            p.argb = random_argb();
+        }
+
+        double float_ns = time_rows(blend_float, framebuffer, sprite);
+        double simd_ns = time_rows(gli::blend_straight, framebuffer, sprite);
+
+        printf("Float blend:    %6.3f ns/pixel\n", float_ns);
+        printf("blend_straight: %6.3f ns/pixel (%.1fx)\n", simd_ns, float_ns / simd_ns);
+    }
+
+    return accurate ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+// Cooks images into the raw sprite format gli::Sprite::load reads without decoding. Inputs are read through gli::FileSystem, so they
+// can be plain paths or container paths like //assets.glp//sprites/droid.png.
+
+#include "gli_sprite.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+
+
+template<typename F>
+void die(const F& f)
+{
+    f();
+    exit(1);
+}
+
+
+void usage()
+{
+    printf("Usage:\n");
+    printf("\tspritecook -o outputfile inputfile\n");
+}
+
+
+template<typename F>
+double time_ms(const F& f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+int main(int argc, char** argv)
+{
+    std::string input;
+    std::string output;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg(argv[i]);
+
+        if (arg[0] == '-')
+        {
+            if (arg == "-o" && output.empty())
+            {
+                if (++i == argc)
+                {
+                    die(usage);
+                }
+
+                output = argv[i];
+            }
+            else
+            {
+                die(usage);
+            }
+        }
+        else if (input.empty())
+        {
+            input = arg;
+        }
+        else
+        {
+            die(usage);
+        }
+    }
+
+    if (input.empty() || output.empty())
+    {
+        die(usage);
+    }
+
+    gli::Sprite sprite;
+    bool loaded = false;
+    double decode_ms = time_ms([&]() { loaded = sprite.load(input); });
+
+    if (!loaded)
+    {
+        die([&]() { printf("Unable to read input file [%s]\n", input.c_str()); });
+    }
+
+    if (!sprite.save_cooked(output))
+    {
+        die([&]() { printf("Unable to write output file [%s]\n", output.c_str()); });
+    }
+
+    // Load the result back, to check it and to show what cooking saves
+    gli::Sprite cooked;
+    double load_ms = time_ms([&]() { loaded = cooked.load(output); });
+
+    if (!loaded || cooked.width() != sprite.width() || cooked.height() != sprite.height() ||
+        memcmp(cooked.pixels(), sprite.pixels(), sizeof(gli::Pixel) * sprite.stride() * sprite.height()) != 0)
+    {
+        die([&]() { printf("Cooked sprite [%s] doesn't match [%s]\n", output.c_str(), input.c_str()); });
+    }
+
+    printf("%s: %dx%d, loads in %.3f ms instead of %.3f ms\n", output.c_str(), sprite.width(), sprite.height(), load_ms, decode_ms);
+    return 0;
+}